@@ -176,6 +176,19 @@ namespace launcher
     void
     erase_setting (const string_type& key);
 
+    // Download journal.
+    //
+
+    std::vector<journaled_download>
+    journal () const;
+
+    // Upsert the updated entries and drop the erased targets in a single
+    // transaction.
+    //
+    void
+    journal (const std::vector<journaled_download>& updated,
+             const std::vector<string_type>& erased);
+
     // Transaction wrappers.
     //
 
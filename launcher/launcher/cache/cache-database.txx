@@ -121,6 +121,20 @@ namespace launcher
     else
     {
       launcher::log::trace_l3 (categories::cache{}, "database schema already exists");
+
+      // The download journal came later so databases created before it
+      // don't have the table.
+      //
+      odb::transaction t (db_->begin ());
+      db_->execute ("CREATE TABLE IF NOT EXISTS \"download_journal\" (\n"
+                    "  \"target\" TEXT NOT NULL PRIMARY KEY,\n"
+                    "  \"url\" TEXT NOT NULL,\n"
+                    "  \"size\" INTEGER NOT NULL,\n"
+                    "  \"hash\" BLOB NOT NULL,\n"
+                    "  \"confirmed\" INTEGER NOT NULL,\n"
+                    "  \"state\" BLOB NOT NULL,\n"
+                    "  \"etag\" TEXT NOT NULL)");
+      t.commit ();
     }
   }
 
@@ -507,6 +521,54 @@ namespace launcher
     t.commit ();
   }
 
+  template <typename T>
+  std::vector<journaled_download> basic_cache_database<T>::
+  journal () const
+  {
+    launcher::log::trace_l2 (categories::cache{}, "querying download journal");
+    std::vector<journaled_download> r;
+
+    odb::transaction t (db_->begin ());
+    odb::result<journaled_download> res (
+      db_->template query<journaled_download> ());
+
+    for (auto& j: res)
+      r.push_back (j);
+
+    t.commit ();
+    launcher::log::trace_l3 (categories::cache{}, "download journal has {} entries", r.size ());
+    return r;
+  }
+
+  template <typename T>
+  void basic_cache_database<T>::
+  journal (const std::vector<journaled_download>& us,
+           const std::vector<string_type>& es)
+  {
+    if (us.empty () && es.empty ())
+      return;
+
+    launcher::log::trace_l3 (categories::cache{}, "updating download journal: {} updated, {} erased", us.size (), es.size ());
+    odb::transaction t (db_->begin ());
+
+    for (const auto& j : us)
+    {
+      if (db_->template find<journaled_download> (j.target ()))
+        db_->update (j);
+      else
+        db_->persist (j);
+    }
+
+    // The entry may never have made it to the database, so don't insist.
+    //
+    using query = odb::query<journaled_download>;
+
+    for (const auto& e : es)
+      db_->template erase_query<journaled_download> (query::target == e);
+
+    t.commit ();
+  }
+
   template <typename T>
   template <typename F>
   void basic_cache_database<T>::
@@ -587,11 +649,12 @@ namespace launcher
   void basic_cache_database<T>::
   clear ()
   {
-    launcher::log::warning (categories::cache{}, "clearing cache database (all files and versions)");
+    launcher::log::warning (categories::cache{}, "clearing cache database (all files, versions, and journal)");
     odb::transaction t (db_->begin ());
 
     db_->template erase_query<cached_file> ();
     db_->template erase_query<component_version> ();
+    db_->template erase_query<journaled_download> ();
 
     t.commit ();
   }
@@ -0,0 +1,122 @@
+#include <launcher/cache/cache-plan.hxx>
+
+#include <utility>
+
+using namespace std;
+
+namespace launcher
+{
+  reconcile_plan::
+  reconcile_plan (const manifest_index& ix,
+                  fs::path root,
+                  component_type c,
+                  string v)
+    : ix_ (&ix),
+      root_ (move (root)),
+      component_ (c),
+      version_ (move (v))
+  {
+  }
+
+  void reconcile_plan::
+  add (kind k,
+       size_t i,
+       reconcile_action a,
+       uint8_t f,
+       vector<reconcile_chunk> cs)
+  {
+    entry e;
+    e.index = static_cast<uint32_t> (i);
+    e.what = k;
+    e.action = a;
+    e.flags = f;
+    e.chunk = static_cast<uint32_t> (chunks_.size ());
+    e.chunks = static_cast<uint32_t> (cs.size ());
+
+    chunks_.insert (chunks_.end (), cs.begin (), cs.end ());
+    entries_.push_back (e);
+
+    if (sink_)
+      sink_ (e, chunks (e));
+  }
+
+  fs::path reconcile_plan::
+  path (const entry& e) const
+  {
+    if (e.what == kind::file)
+      return ix_->file (e.index).path;
+
+    return (e.flags & exploded) != 0
+      ? root_ / archive (e).name
+      : ix_->archive (e.index).path;
+  }
+
+  const string& reconcile_plan::
+  url (const entry& e) const
+  {
+    static const string empty;
+    return e.what == kind::archive ? archive (e).url : empty;
+  }
+
+  const blake3_digest& reconcile_plan::
+  hash (const entry& e) const
+  {
+    return e.what == kind::archive ? archive (e).hash.value
+                                   : file (e).hash.value;
+  }
+
+  uint64_t reconcile_plan::
+  size (const entry& e) const
+  {
+    return e.what == kind::archive ? archive (e).size : file (e).size;
+  }
+
+  span<const reconcile_chunk> reconcile_plan::
+  chunks (const entry& e) const
+  {
+    return span<const reconcile_chunk> (chunks_.data () + e.chunk, e.chunks);
+  }
+
+  uint64_t reconcile_plan::
+  transfer_size (const entry& e) const
+  {
+    if (e.chunks == 0)
+      return size (e);
+
+    uint64_t r (0);
+    for (const auto& c: chunks (e))
+      if (!c.source)
+        r += c.size;
+
+    return r;
+  }
+
+  reconcile_item reconcile_plan::
+  item (const entry& e) const
+  {
+    reconcile_item r (e.action,
+                      path (e).string (),
+                      url (e),
+                      hash (e),
+                      size (e),
+                      component_,
+                      version_);
+
+    auto cs (chunks (e));
+    r.chunks.assign (cs.begin (), cs.end ());
+
+    return r;
+  }
+
+  vector<reconcile_item> reconcile_plan::
+  items () const
+  {
+    vector<reconcile_item> r;
+    r.reserve (entries_.size ());
+
+    for (const auto& e: entries_)
+      r.push_back (item (e));
+
+    return r;
+  }
+}
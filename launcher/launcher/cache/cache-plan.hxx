@@ -0,0 +1,173 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <filesystem>
+
+#include <launcher/cache/cache-types.hxx>
+
+#include <launcher/manifest/manifest-index.hxx>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Compact reconcile plan.
+  //
+  // A reconcile_item owns its path, URL, and version, yet we already have
+  // all of them: the path is in the manifest index, the URL in the manifest,
+  // and the version is the same for the whole plan. With 100k entries
+  // building, moving, and concatenating those is most of what planning
+  // does. So instead we record which manifest entry needs what, in a few
+  // bytes, and materialize the rest on demand, normally when building the
+  // download request.
+  //
+  // Note that the plan refers to the index (and so to the manifest) which
+  // must outlive it.
+  //
+  // Note also that materializing an entry other than its chunks only reads
+  // the index, so it is fine to do while entries are being added by another
+  // thread (see basic_reconciler::plan() with a channel).
+  //
+  class reconcile_plan
+  {
+  public:
+    enum class kind: std::uint8_t
+    {
+      archive,
+      file
+    };
+
+    // Entry flags.
+    //
+    // An exploded archive (that is, one that lists its files) is downloaded
+    // next to the root rather than to where the index resolves it.
+    //
+    static constexpr std::uint8_t exploded = 0x01;
+
+    struct entry
+    {
+      std::uint32_t    index;  // Archive or file in the manifest.
+      kind             what;
+      reconcile_action action;
+      std::uint8_t     flags;
+      std::uint32_t    chunk;  // First delta chunk.
+      std::uint32_t    chunks; // Delta chunk count, 0 if full download.
+    };
+
+    reconcile_plan (const manifest_index& ix,
+                    fs::path root,
+                    component_type c,
+                    std::string version);
+
+    reconcile_plan (reconcile_plan&&) = default;
+    reconcile_plan& operator= (reconcile_plan&&) = default;
+
+    void
+    add (kind k,
+         std::size_t index,
+         reconcile_action a,
+         std::uint8_t flags = 0,
+         std::vector<reconcile_chunk> chunks = {});
+
+    // Call the sink for every entry as it is added, along with its delta
+    // chunks.
+    //
+    using sink_type =
+      std::function<void (const entry&, std::span<const reconcile_chunk>)>;
+
+    void
+    sink (sink_type s) {sink_ = std::move (s);}
+
+    // Entries.
+    //
+    using const_iterator = std::vector<entry>::const_iterator;
+
+    const_iterator
+    begin () const noexcept {return entries_.begin ();}
+
+    const_iterator
+    end () const noexcept {return entries_.end ();}
+
+    std::size_t
+    size () const noexcept {return entries_.size ();}
+
+    bool
+    empty () const noexcept {return entries_.empty ();}
+
+    const entry&
+    operator[] (std::size_t i) const noexcept {return entries_[i];}
+
+    // Shared by all the entries.
+    //
+    const manifest_index&
+    index () const noexcept {return *ix_;}
+
+    component_type
+    component () const noexcept {return component_;}
+
+    const std::string&
+    version () const noexcept {return version_;}
+
+    // Materialization.
+    //
+
+    // Download target.
+    //
+    fs::path
+    path (const entry&) const;
+
+    // Empty for files, which the manifest has no URL for.
+    //
+    const std::string&
+    url (const entry&) const;
+
+    const blake3_digest&
+    hash (const entry&) const;
+
+    std::uint64_t
+    size (const entry&) const;
+
+    std::span<const reconcile_chunk>
+    chunks (const entry&) const;
+
+    // Bytes that actually have to come over the wire.
+    //
+    std::uint64_t
+    transfer_size (const entry&) const;
+
+    reconcile_item
+    item (const entry&) const;
+
+    std::vector<reconcile_item>
+    items () const;
+
+  private:
+    const manifest_archive&
+    archive (const entry& e) const
+    {
+      return ix_->source ().archives[e.index];
+    }
+
+    const manifest_file&
+    file (const entry& e) const
+    {
+      return ix_->source ().files[e.index];
+    }
+
+    const manifest_index* ix_;
+    fs::path root_;
+    component_type component_;
+    std::string version_;
+
+    std::vector<entry> entries_;
+    std::vector<reconcile_chunk> chunks_; // Delta chunks of all entries.
+
+    sink_type sink_;
+  };
+}
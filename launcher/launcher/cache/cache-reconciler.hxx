@@ -1,9 +1,13 @@
 #pragma once
 
 #include <boost/asio/awaitable.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+
+#include <boost/system/error_code.hpp>
 
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
@@ -11,8 +15,11 @@
 
 #include <launcher/cache/cache-database.hxx>
 #include <launcher/cache/cache-types.hxx>
+#include <launcher/cache/cache-plan.hxx>
 
 #include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-diff.hxx>
+#include <launcher/manifest/manifest-index.hxx>
 #include <launcher/launcher-log.hxx>
 
 namespace launcher
@@ -142,23 +149,54 @@ namespace launcher
     std::vector<reconcile_item>
     plan (const manifest& m, component_type c, const str_type& v);
 
+    // Same but against an index of the manifest built with index() and
+    // producing a compact plan that refers into it (see reconcile_plan). If
+    // the caller needs the resolved paths as well, this saves us resolving
+    // everything twice, and materializing every item only to read a few of
+    // them.
+    //
+    reconcile_plan
+    plan (const manifest_index& ix, component_type c, const str_type& v);
+
+    // Same but plan on a thread of our own and send each entry (along with
+    // its delta chunks) through the channel as soon as it is decided.
+    //
+    // Missing entries are decided right away while those that are on disk
+    // but unknown to the db have to be hashed first. This way the consumer
+    // can start acting on the former (that is, downloading) while we are
+    // still busy with the latter. Once the plan is complete the channel is
+    // closed and the returned future becomes ready (rethrowing any planning
+    // error).
+    //
+    // Note that we don't wait for the consumer so the channel must have room
+    // for an entry per archive and file in the manifest. Note also that
+    // nothing else may use the reconciler until the plan is complete.
+    //
+    using plan_channel =
+      asio::experimental::concurrent_channel<
+        void (boost::system::error_code,
+              reconcile_plan::entry,
+              std::vector<reconcile_chunk>)>;
+
+    std::future<void>
+    plan (reconcile_plan& r, plan_channel& ch);
+
     // Helpers for the planner. We split these out to keep the logic
     // manageable and to handle the slightly different semantics of archives
     // (which need extraction) vs standalone files.
     //
-    std::vector<reconcile_item>
-    plan_archives (const std::vector<manifest_archive>& as,
-                   component_type c,
-                   const str_type& v);
+    void
+    plan_archives (reconcile_plan& r);
 
-    std::vector<reconcile_item>
-    plan_files (const std::vector<manifest_file>& fs,
-                component_type c,
-                const str_type& v);
+    void
+    plan_files (reconcile_plan& r);
 
     reconcile_summary
     summarize (const std::vector<reconcile_item>& items) const;
 
+    reconcile_summary
+    summarize (const reconcile_plan& p) const;
+
     // Recording.
     //
 
@@ -171,7 +209,7 @@ namespace launcher
     track (const fs::path& p,
            component_type c,
            const str_type& v,
-           const str_type& hash = "");
+           const blake3_digest& hash = blake3_digest ());
 
     // Commit extracted files.
     //
@@ -191,6 +229,18 @@ namespace launcher
     void
     stamp (component_type c, const str_type& tag);
 
+    // Move the entries of an unchanged manifest over to the new version.
+    //
+    // If diffing against the installed manifest tells us that an entry is
+    // the same in the target, there is nothing to verify or download: the
+    // only thing standing between it and a clean plan is the version we
+    // recorded it with. So rewrite that in a single batch instead.
+    //
+    // Entries we don't track are left alone for plan() to deal with.
+    //
+    void
+    carry (const manifest& m, component_type c, const str_type& v);
+
     void
     forget (const fs::path& p);
 
@@ -202,6 +252,12 @@ namespace launcher
     std::vector<str_type>
     clean (const manifest& m, component_type c);
 
+    // Same but only for the entries the diff says were removed, which saves
+    // us from scanning the whole component.
+    //
+    std::vector<str_type>
+    clean (const manifest_diff& d, component_type c);
+
     // Resolution.
     //
 
@@ -219,6 +275,11 @@ namespace launcher
     str_type
     key (const fs::path& p) const;
 
+    // Resolve every entry of the manifest once, see manifest_index.
+    //
+    manifest_index
+    index (const manifest& m) const;
+
     // Access.
     //
 
@@ -243,6 +304,43 @@ namespace launcher
     bool
     match (const fs::path& p, const cached_file& entry) const;
 
+    // Download of an existing file for which the manifest carries chunks.
+    // Whether it turns into a delta depends on how much of it we already
+    // have, which means chunking the local copy, so we collect these and
+    // chunk them all at once in add_deltas().
+    //
+    struct delta_task
+    {
+      reconcile_plan::kind k;
+      std::size_t i;
+      fs::path p;
+      std::uint64_t size;
+      const std::vector<manifest_chunk>* cs;
+
+      // Results (filled by the worker thread).
+      //
+      std::vector<manifest_chunk> ls;
+      std::string error;
+    };
+
+    // Chunk the local copies in parallel and add the downloads to the plan.
+    //
+    void
+    add_deltas (reconcile_plan& r, std::vector<delta_task>& ts);
+
+    // Turn the download into a delta if enough of its chunks are already
+    // present locally. Return the delta chunks or an empty list for a full
+    // download.
+    //
+    std::vector<reconcile_chunk>
+    delta (const delta_task& t) const;
+
+    // Db keys of everything the manifest installs: archives that are kept
+    // as blobs, the inner files of exploded ones, and standalone files.
+    //
+    std::vector<str_type>
+    keys (const manifest& m) const;
+
     db_type& db_;
     fs::path root_;
     strategy strat_;
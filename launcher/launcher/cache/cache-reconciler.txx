@@ -1,15 +1,18 @@
 #include <algorithm>
 #include <atomic>
 #include <exception>
+#include <future>
 #include <latch>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
 
 #include <launcher/launcher-manifest.hxx>
+#include <launcher/manifest/manifest-chunk.hxx>
 
 namespace launcher
 {
@@ -194,7 +197,7 @@ namespace launcher
   struct hash_task
   {
     fs::path       p;
-    std::string    exp; // The expected hash from the manifest.
+    blake3_digest  exp; // The expected hash from the manifest.
     std::string    key; // The canonical DB key.
     component_type c;
 
@@ -206,13 +209,14 @@ namespace launcher
     std::string   error; // If non-empty, implies an exception occurred.
   };
 
+  // Run f(i) for every i in [0, n) on a transient thread pool and wait for
+  // all of them to complete. The function must not throw.
+  //
+  template <typename F>
   inline void
-  run_hashes (std::vector<hash_task>& ts,
-              std::function<void (const std::string&,
-                                  std::size_t,
-                                  std::size_t)> cb)
+  run_parallel (std::size_t n, F f)
   {
-    if (ts.empty ()) return;
+    if (n == 0) return;
 
     // We need to be conservative with our concurrency choices here.
     //
@@ -226,84 +230,100 @@ namespace launcher
     // the disk bandwidth, so throwing 64 threads at it might just cause
     // thrashing, but let's trust the standard library hint anyways.
     //
-    unsigned int n (std::thread::hardware_concurrency ());
-    if (n == 0) n = 4;
+    unsigned int w (std::thread::hardware_concurrency ());
+    if (w == 0) w = 4;
 
-    launcher::log::trace_l2 (categories::cache{}, "spinning up thread pool with {} workers for {} hash tasks", n, ts.size ());
+    launcher::log::trace_l2 (categories::cache{}, "spinning up thread pool with {} workers for {} tasks", w, n);
 
-    asio::thread_pool pool (n);
-    std::atomic<std::size_t> d (0); // Completed count.
-    std::size_t tot (ts.size ());
+    asio::thread_pool pool (w);
 
     // We use a latch to fence execution. We cannot proceed to the
-    // reconcile decision phase until *all* hashes are computed. The
-    // alternative would be a complex chain of futures, but a latch is
-    // simpler for this "fork-join" pattern.
+    // reconcile decision phase until *all* tasks are done. The alternative
+    // would be a complex chain of futures, but a latch is simpler for this
+    // "fork-join" pattern.
     //
-    std::latch l (static_cast<std::ptrdiff_t> (tot));
+    std::latch l (static_cast<std::ptrdiff_t> (n));
 
-    for (auto& t : ts)
+    for (std::size_t i (0); i != n; ++i)
     {
       asio::post (pool,
-                  [&t, &d, tot, &l, &cb] ()
+                  [&f, &l, i] ()
+      {
+        f (i);
+        l.count_down ();
+      });
+    }
+
+    // Wait for the pool to drain.
+    l.wait ();
+    pool.join ();
+  }
+
+  inline void
+  run_hashes (std::vector<hash_task>& ts,
+              std::function<void (const std::string&,
+                                  std::size_t,
+                                  std::size_t)> cb)
+  {
+    if (ts.empty ()) return;
+
+    std::atomic<std::size_t> d (0); // Completed count.
+    std::size_t tot (ts.size ());
+
+    run_parallel (tot, [&ts, &d, tot, &cb] (std::size_t i)
+    {
+      hash_task& t (ts[i]);
+
+      // We must wrap the unit of work in a try-catch block. If a thread
+      // throws (e.g., bad allocation), it could terminate the pool or the
+      // program. We want to capture that failure and mark the file as
+      // "mismatched" so the reconciler simply downloads it again.
+      //
+      try
       {
-        // We must wrap the unit of work in a try-catch block. If a thread
-        // throws (e.g., bad allocation), it could terminate the pool or the
-        // program. We want to capture that failure and mark the file as
-        // "mismatched" so the reconciler simply downloads it again.
+        // Check existence again inside the thread to avoid TOCTOU races,
+        // though strict atomicity isn't required here.
         //
-        try
+        if (exists_quiet (t.p) && !t.exp.empty ())
         {
-          // Check existence again inside the thread to avoid TOCTOU races,
-          // though strict atomicity isn't required here.
-          //
-          if (exists_quiet (t.p) && !t.exp.empty ())
-          {
-            std::string a (compute_blake3 (t.p));
-            t.match = (a == t.exp);
+          t.match = (compute_blake3 (t.p) == t.exp);
 
-            // If the hash matches, we grab the stat data (mtime, size)
-            // immediately. The OS likely has the inode in cache right now. If
-            // we waited until the main thread resumed, the cache might be
-            // cold again. "Do you wanna build a snowman?"
-            //
-            if (t.match)
-            {
-              t.mtime = get_file_mtime (t.p);
-              t.size = size_quiet (t.p);
-            }
-          }
-          else
+          // If the hash matches, we grab the stat data (mtime, size)
+          // immediately. The OS likely has the inode in cache right now. If
+          // we waited until the main thread resumed, the cache might be
+          // cold again. "Do you wanna build a snowman?"
+          //
+          if (t.match)
           {
-            t.match = false;
+            t.mtime = get_file_mtime (t.p);
+            t.size = size_quiet (t.p);
           }
         }
-        catch (const std::exception& e)
-        {
-          // We don't abort on error, just assume the file is broken.
-          //
-          launcher::log::warning (categories::cache{}, "exception during parallel hash for {}: {}", t.p.string (), e.what ());
-          t.match = false;
-          t.error = e.what ();
-        }
-        catch (...)
+        else
         {
-          launcher::log::warning (categories::cache{}, "unknown exception during parallel hash for {}", t.p.string ());
           t.match = false;
-          t.error = "unknown exception during hashing";
         }
+      }
+      catch (const std::exception& e)
+      {
+        // We don't abort on error, just assume the file is broken.
+        //
+        launcher::log::warning (categories::cache{}, "exception during parallel hash for {}: {}", t.p.string (), e.what ());
+        t.match = false;
+        t.error = e.what ();
+      }
+      catch (...)
+      {
+        launcher::log::warning (categories::cache{}, "unknown exception during parallel hash for {}", t.p.string ());
+        t.match = false;
+        t.error = "unknown exception during hashing";
+      }
 
-        std::size_t c (++d);
-        if (cb)
-          cb ("Verifying", c, tot);
-
-        l.count_down ();
-      });
-    }
+      std::size_t c (++d);
+      if (cb)
+        cb ("Verifying", c, tot);
+    });
 
-    // Wait for the pool to drain.
-    l.wait ();
-    pool.join ();
     launcher::log::trace_l2 (categories::cache{}, "all hash tasks completed");
   }
 
@@ -311,9 +331,17 @@ namespace launcher
   std::vector<reconcile_item>
   basic_reconciler<T>::
   plan (const manifest& m, component_type c, const str_type& v)
+  {
+    return plan (index (m), c, v).items ();
+  }
+
+  template <typename T>
+  reconcile_plan
+  basic_reconciler<T>::
+  plan (const manifest_index& ix, component_type c, const str_type& v)
   {
     launcher::log::trace_l1 (categories::cache{}, "generating reconcile plan for component {} (target version {})", static_cast<int> (c), v);
-    std::vector<reconcile_item> r;
+    reconcile_plan r (ix, root_, c, std::string (v));
 
     // The order of planning operations is significant.
     //
@@ -326,29 +354,64 @@ namespace launcher
     // rules to prevent double-booking them in the individual file check pass
     // later.
     //
-    auto as (plan_archives (m.archives, c, v));
-    r.insert (r.end (),
-              std::make_move_iterator (as.begin ()),
-              std::make_move_iterator (as.end ()));
-
-    auto fs (plan_files (m.files, c, v));
-    r.insert (r.end (),
-              std::make_move_iterator (fs.begin ()),
-              std::make_move_iterator (fs.end ()));
+    plan_archives (r);
+    plan_files (r);
 
     launcher::log::info (categories::cache{}, "reconcile plan generated with {} items", r.size ());
     return r;
   }
 
   template <typename T>
-  std::vector<reconcile_item>
-  basic_reconciler<T>::
-  plan_archives (const std::vector<manifest_archive>& as,
-                 component_type c,
-                 const str_type& v)
+  std::future<void> basic_reconciler<T>::
+  plan (reconcile_plan& r, plan_channel& ch)
   {
+    launcher::log::trace_l1 (categories::cache{}, "generating streamed reconcile plan for component {} (target version {})", static_cast<int> (r.component ()), r.version ());
+
+    r.sink ([&ch] (const reconcile_plan::entry& e,
+                   std::span<const reconcile_chunk> cs)
+    {
+      if (!ch.try_send (boost::system::error_code (),
+                        e,
+                        std::vector<reconcile_chunk> (cs.begin (), cs.end ())))
+        launcher::log::error (categories::cache{}, "reconcile plan channel is full, entry {} not sent", e.index);
+    });
+
+    return std::async (std::launch::async, [this, &r, &ch] ()
+    {
+      // Whatever happens, the consumer must not be left waiting.
+      //
+      auto close ([&r, &ch] ()
+      {
+        r.sink (nullptr);
+        ch.close ();
+      });
+
+      try
+      {
+        plan_archives (r);
+        plan_files (r);
+      }
+      catch (...)
+      {
+        close ();
+        throw;
+      }
+
+      close ();
+      launcher::log::info (categories::cache{}, "reconcile plan generated with {} items", r.size ());
+    });
+  }
+
+  template <typename T>
+  void basic_reconciler<T>::
+  plan_archives (reconcile_plan& r)
+  {
+    const manifest_index& ix (r.index ());
+    const std::vector<manifest_archive>& as (ix.source ().archives);
+    component_type c (r.component ());
+    const str_type& v (r.version ());
+
     launcher::log::trace_l2 (categories::cache{}, "planning {} archives", as.size ());
-    std::vector<reconcile_item> r;
 
     // Reconciliation of archives is non-trivial compared to simple files. We
     // have to handle two distinct cases:
@@ -366,18 +429,18 @@ namespace launcher
     //
     struct link_info
     {
-      std::size_t i; // Index into 'as' vector.
-      fs::path    p;
-      std::string h; // Expected hash.
-      std::string k; // DB key.
+      std::size_t   i; // Index into 'as' vector.
+      fs::path      p;
+      blake3_digest h; // Expected hash.
+      std::string   k; // DB key.
     };
 
     struct file_info
     {
-      std::size_t i;
-      fs::path    p;
-      std::string h;
-      std::string k;
+      std::size_t   i;
+      fs::path      p;
+      blake3_digest h;
+      std::string   k;
     };
 
     std::vector<link_info> ls;
@@ -389,10 +452,43 @@ namespace launcher
       bool has_links; // True if this is an exploded archive.
       bool links_ok;  // Accumulator for the validity of inner files.
       bool dl;        // Final decision: do we download?
+      bool added;     // Already in the plan.
     };
 
     std::vector<state> ss (as.size ());
 
+    // Blob archives that we have a copy of are only added once we know
+    // whether they can be patched (see add_deltas()).
+    //
+    std::vector<delta_task> ds;
+
+    auto add ([&r, &ix, &as, &ss, &ds] (std::size_t i)
+    {
+      const auto& a (as[i]);
+      auto& s (ss[i]);
+
+      if (s.has_links)
+        r.add (reconcile_plan::kind::archive,
+               i,
+               reconcile_action::download,
+               reconcile_plan::exploded);
+      else if (!a.chunks.empty () && exists_quiet (ix.archive (i).path))
+        ds.push_back ({reconcile_plan::kind::archive,
+                       i,
+                       ix.archive (i).path,
+                       a.size,
+                       &a.chunks,
+                       {},
+                       {}});
+      else
+        r.add (reconcile_plan::kind::archive,
+               i,
+               reconcile_action::download);
+
+      s.added = true;
+      launcher::log::trace_l3 (categories::cache{}, "archive item added to reconcile plan: {}", a.name);
+    });
+
     // First, we must scan the manifest and DB to determine what is physically
     // missing or metadata-stale.
     //
@@ -405,6 +501,7 @@ namespace launcher
       s.has_links = !a.files.empty ();
       s.links_ok = true;
       s.dl = false;
+      s.added = false;
 
       // Corner case: If there is no URL, we cannot repair it.
       //
@@ -425,10 +522,14 @@ namespace launcher
         //     finer-grained, but in practice these archives mostly come from
         //     GitHub releases, so the added complexity is not justified here
         //
-        for (const auto& f : a.files)
+        auto es (ix.contents (i));
+
+        for (std::size_t j (0); j != a.files.size (); ++j)
         {
+          const auto& f (a.files[j]);
+
           fs::path p (root_ / f.path);
-          str_type k (key (p));
+          str_type k (es[j].key);
           auto cached (db_.find (k));
 
           // If we have a cache hit, we check if it matches our criteria
@@ -443,7 +544,7 @@ namespace launcher
               s.links_ok = false;
             }
           }
-          else if (exists_quiet (p) && !f.hash.value.empty ())
+          else if (exists_quiet (p) && !f.hash.empty ())
           {
             ls.push_back ({i, p, f.hash.value, k});
           }
@@ -460,8 +561,8 @@ namespace launcher
       {
         // Standalone archive (blob).
         //
-        fs::path p (path (a));
-        str_type k (key (p));
+        const fs::path& p (ix.archive (i).path);
+        str_type k (ix.archive (i).key);
         auto cached (db_.find (k));
 
         if (cached)
@@ -477,7 +578,7 @@ namespace launcher
 
           s.skip = !s.dl;
         }
-        else if (exists_quiet (p) && !a.hash.value.empty ())
+        else if (exists_quiet (p) && !a.hash.empty ())
         {
           // It exists on disk but the DB doesn't know about it. This happens
           // if the DB was deleted. Queue for hashing.
@@ -490,6 +591,13 @@ namespace launcher
           s.dl = true;
         }
       }
+
+      // If we already know we have to download it, there is no reason to
+      // wait for the hashing below. This way whoever is consuming the plan
+      // as it is produced can get the download going in the meantime.
+      //
+      if (s.dl || !s.links_ok)
+        add (i);
     }
 
     // Execute the hash verification queue, but only proceed if we actually
@@ -553,7 +661,6 @@ namespace launcher
     //
     for (std::size_t i (0); i < as.size (); ++i)
     {
-      const auto& a (as[i]);
       const auto& s (ss[i]);
 
       if (s.skip) continue;
@@ -566,42 +673,35 @@ namespace launcher
       if (s.has_links && !s.links_ok)
         dl = true;
 
-      if (dl)
-      {
-        reconcile_item ri;
-        ri.action = reconcile_action::download;
-        ri.path = s.has_links ? (root_ / a.name).string () : path (a).string ();
-        ri.url = a.url;
-        ri.expected_hash = a.hash.value;
-        ri.expected_size = a.size;
-        ri.component = c;
-        ri.version = v;
-
-        launcher::log::trace_l3 (categories::cache{}, "archive item added to reconcile plan: {}", ri.path);
-        r.push_back (std::move (ri));
-      }
+      if (dl && !s.added)
+        add (i);
     }
 
-    return r;
+    add_deltas (r, ds);
   }
 
   template <typename T>
-  std::vector<reconcile_item>
-  basic_reconciler<T>::
-  plan_files (const std::vector<manifest_file>& fs,
-              component_type c,
-              const str_type& v)
+  void basic_reconciler<T>::
+  plan_files (reconcile_plan& r)
   {
+    const manifest_index& ix (r.index ());
+    const std::vector<manifest_file>& fs (ix.source ().files);
+    component_type c (r.component ());
+    const str_type& v (r.version ());
+
     launcher::log::trace_l2 (categories::cache{}, "planning {} standalone files", fs.size ());
-    std::vector<reconcile_item> r;
     std::size_t i (0);
 
     // Unlike archives, we process standalone files serially.
     //
     // The number of standalone files is usually low compared to the bulk data
     // inside archives, so the overhead of spinning up threads for small files
-    // often outweighs the gain.
+    // often outweighs the gain. Chunking the local copies for deltas is
+    // another matter (it reads the whole file), so those are deferred and
+    // done in parallel at the end (see add_deltas()).
     //
+    std::vector<delta_task> ds;
+
     for (const auto& f : fs)
     {
       report ("Checking " + f.path, ++i, fs.size ());
@@ -615,8 +715,8 @@ namespace launcher
       //
       if (f.path.ends_with ("update.json")) continue;
 
-      fs::path p (path (f));
-      str_type k (key (p));
+      const fs::path& p (ix.file (i - 1).path);
+      str_type k (ix.file (i - 1).key);
       auto cached (db_.find (k));
       bool dl (false);
 
@@ -629,7 +729,7 @@ namespace launcher
           launcher::log::trace_l3 (categories::cache{}, "file {} missing from disk and db", f.path);
           dl = true;
         }
-        else if (!f.hash.value.empty ())
+        else if (!f.hash.empty ())
         {
           // Exists on disk, but unknown to DB.
           //
@@ -690,20 +790,24 @@ namespace launcher
 
       if (dl && f.asset_name)
       {
-        reconcile_item ri;
-        ri.action = reconcile_action::download;
-        ri.path = p.string ();
-        ri.expected_hash = f.hash.value;
-        ri.expected_size = f.size;
-        ri.component = c;
-        ri.version = v;
-        r.push_back (std::move (ri));
-
-        launcher::log::trace_l3 (categories::cache{}, "file item added to reconcile plan: {}", ri.path);
+        if (!f.chunks.empty () && exists_quiet (p))
+          ds.push_back ({reconcile_plan::kind::file,
+                         i - 1,
+                         p,
+                         f.size,
+                         &f.chunks,
+                         {},
+                         {}});
+        else
+          r.add (reconcile_plan::kind::file,
+                 i - 1,
+                 reconcile_action::download);
+
+        launcher::log::trace_l3 (categories::cache{}, "file item added to reconcile plan: {}", p.string ());
       }
     }
 
-    return r;
+    add_deltas (r, ds);
   }
 
   template <typename T>
@@ -720,7 +824,7 @@ namespace launcher
       switch (i.action)
       {
         case reconcile_action::download:
-          s.downloads_required++, s.bytes_to_download += i.expected_size;
+          s.downloads_required++, s.bytes_to_download += i.transfer_size ();
           break;
 
         case reconcile_action::verify: s.files_stale++;   break;
@@ -732,12 +836,136 @@ namespace launcher
     return s;
   }
 
+  template <typename T>
+  reconcile_summary basic_reconciler<T>::
+  summarize (const reconcile_plan& p) const
+  {
+    launcher::log::trace_l3 (categories::cache{}, "generating summary for {} entries", p.size ());
+    reconcile_summary s;
+
+    for (const auto& e : p)
+    {
+      switch (e.action)
+      {
+        case reconcile_action::download:
+          s.downloads_required++, s.bytes_to_download += p.transfer_size (e);
+          break;
+
+        case reconcile_action::verify: s.files_stale++;   break;
+        case reconcile_action::remove: s.files_unknown++; break;
+        case reconcile_action::none:   s.files_valid++;   break;
+      }
+    }
+
+    return s;
+  }
+
+  template <typename T>
+  void basic_reconciler<T>::
+  add_deltas (reconcile_plan& r, std::vector<delta_task>& ts)
+  {
+    if (ts.empty ()) return;
+
+    // Chunk the local copies with the same parameters the publisher used.
+    // This reads each file in full, so it goes on the pool just like the
+    // hashing.
+    //
+    std::atomic<std::size_t> d (0);
+    std::size_t tot (ts.size ());
+
+    run_parallel (tot, [&ts, &d, tot, this] (std::size_t i)
+    {
+      delta_task& t (ts[i]);
+
+      try
+      {
+        t.ls = compute_file_chunks (t.p);
+      }
+      catch (const std::exception& e)
+      {
+        t.error = e.what ();
+      }
+      catch (...)
+      {
+        t.error = "unknown exception during chunking";
+      }
+
+      std::size_t c (++d);
+      if (cb_)
+        cb_ ("Chunking", c, tot);
+    });
+
+    for (const auto& t : ts)
+      r.add (t.k, t.i, reconcile_action::download, 0, delta (t));
+  }
+
+  template <typename T>
+  std::vector<reconcile_chunk> basic_reconciler<T>::
+  delta (const delta_task& t) const
+  {
+    const fs::path& p (t.p);
+    const std::vector<manifest_chunk>& cs (*t.cs);
+
+    if (!t.error.empty ())
+    {
+      launcher::log::warning (categories::cache{}, "unable to chunk {} for delta: {}", p.string (), t.error);
+      return {};
+    }
+
+    // See which of the remote chunks we already have (anywhere in the file,
+    // since content-defined chunks survive shifting).
+    //
+    const std::vector<manifest_chunk>& ls (t.ls);
+
+    std::unordered_map<blake3_digest, std::uint64_t> have;
+    have.reserve (ls.size ());
+
+    for (const auto& l : ls)
+      have.emplace (l.hash.value, l.offset);
+
+    std::vector<reconcile_chunk> r;
+    r.reserve (cs.size ());
+
+    std::uint64_t fetch (0), total (0);
+
+    for (const auto& c : cs)
+    {
+      reconcile_chunk rc {c.offset, c.size, std::nullopt};
+
+      if (auto i (have.find (c.hash.value)); i != have.end ())
+        rc.source = i->second;
+      else
+        fetch += c.size;
+
+      total += c.size;
+      r.push_back (rc);
+    }
+
+    if (total != t.size)
+    {
+      launcher::log::warning (categories::cache{}, "chunks of {} don't add up to its size, ignoring them", p.string ());
+      return {};
+    }
+
+    // If nothing can be reused, a plain download is one request instead of
+    // many.
+    //
+    if (fetch == total)
+    {
+      launcher::log::trace_l3 (categories::cache{}, "no reusable chunks in {}, using full download", p.string ());
+      return {};
+    }
+
+    launcher::log::debug (categories::cache{}, "delta for {}: fetching {} of {} bytes", p.string (), fetch, t.size);
+    return r;
+  }
+
   template <typename T>
   void basic_reconciler<T>::
   track (const fs::path& p,
          component_type c,
          const str_type& v,
-         const str_type& h)
+         const blake3_digest& h)
   {
     // We only track files that successfully made it to disk. If the
     // extraction failed, the file won't exist, and we shouldn't record a lie
@@ -796,7 +1024,7 @@ namespace launcher
                          v,
                          c,
                          fs::file_size (p),
-                         "");
+                         blake3_digest ());
       }
       catch (...)
       {
@@ -819,6 +1047,38 @@ namespace launcher
     db_.version (c, tag);
   }
 
+  template <typename T>
+  void basic_reconciler<T>::
+  carry (const manifest& m, component_type c, const str_type& v)
+  {
+    auto ks (keys (m));
+
+    launcher::log::trace_l2 (categories::cache{}, "carrying {} unchanged entries over to version {}", ks.size (), v);
+
+    if (ks.empty ())
+      return;
+
+    std::sort (ks.begin (), ks.end ());
+
+    // One query for the whole component rather than a find() per entry.
+    //
+    std::vector<cached_file> es;
+
+    for (auto& f : db_.files (c))
+    {
+      if (f.version () != v &&
+          std::binary_search (ks.begin (), ks.end (), f.path ()))
+      {
+        f.set_version (v);
+        es.push_back (std::move (f));
+      }
+    }
+
+    launcher::log::debug (categories::cache{}, "carried {} database entries over to version {}", es.size (), v);
+
+    db_.store (es);
+  }
+
   template <typename T>
   void basic_reconciler<T>::
   forget (const fs::path& p)
@@ -915,6 +1175,69 @@ namespace launcher
     return orphans;
   }
 
+  template <typename T>
+  std::vector<typename basic_reconciler<T>::str_type>
+  basic_reconciler<T>::
+  clean (const manifest_diff& d, component_type c)
+  {
+    launcher::log::info (categories::cache{}, "cleaning removed files for component {}", static_cast<int> (c));
+
+    auto ks (keys (d.removed));
+    std::sort (ks.begin (), ks.end ());
+
+    // Only erase what we actually track for this component: the db refuses
+    // to erase what isn't there and we shouldn't touch other components.
+    //
+    std::vector<str_type> orphans;
+
+    for (const auto& f : db_.files (c))
+      if (std::binary_search (ks.begin (), ks.end (), f.path ()))
+        orphans.push_back (f.path ());
+
+    launcher::log::debug (categories::cache{}, "found {} removed database entries", orphans.size ());
+
+    if (traits::auto_prune && !orphans.empty ())
+    {
+      launcher::log::trace_l2 (categories::cache{}, "auto-pruning removed entries from db");
+      db_.erase (orphans);
+    }
+
+    return orphans;
+  }
+
+  template <typename T>
+  std::vector<typename basic_reconciler<T>::str_type>
+  basic_reconciler<T>::
+  keys (const manifest& m) const
+  {
+    std::vector<str_type> r;
+
+    // Note that inner files are keyed the same way plan_archives() looks
+    // them up, that is, relative to the root as is.
+    //
+    for (const auto& a : m.archives)
+    {
+      if (a.files.empty ())
+        r.push_back (key (path (a)));
+      else
+        for (const auto& f : a.files)
+          r.push_back (key (root_ / f.path));
+    }
+
+    for (const auto& f : m.files)
+      r.push_back (f.archive_name ? key (root_ / f.path) : key (path (f)));
+
+    return r;
+  }
+
+  template <typename T>
+  manifest_index basic_reconciler<T>::
+  index (const manifest& m) const
+  {
+    launcher::log::trace_l2 (categories::cache{}, "indexing {} archives and {} files", m.archives.size (), m.files.size ());
+    return manifest_index (m, *this);
+  }
+
   template <typename T>
   fs::path basic_reconciler<T>::
   path (const manifest_file& f) const
@@ -1,8 +1,6 @@
 #include <launcher/cache/cache-types.hxx>
 
 #include <fstream>
-#include <iomanip>
-#include <sstream>
 #include <vector>
 
 #include <launcher/blake3.h>
@@ -13,12 +11,12 @@ namespace launcher
 {
   // @@: consider relocating this to a more appropriate module.
   //
-  string
+  blake3_digest
   compute_blake3 (const fs::path& f)
   {
     ifstream is (f, ios::binary);
     if (!is)
-      return string ();
+      return blake3_digest ();
 
     blake3_hasher h;
     blake3_hasher_init (&h);
@@ -36,17 +34,9 @@ namespace launcher
         blake3_hasher_update (&h, b.data (), c);
     }
 
-    uint8_t d[BLAKE3_OUT_LEN];
-    blake3_hasher_finalize (&h, d, BLAKE3_OUT_LEN);
+    blake3_digest d;
+    blake3_hasher_finalize (&h, d.data (), d.size ());
 
-    // Format as a hex string.
-    //
-    ostringstream os;
-    os << hex << setfill ('0');
-
-    for (int i (0); i < BLAKE3_OUT_LEN; ++i)
-      os << setw (2) << static_cast<int> (d[i]);
-
-    return os.str ();
+    return d;
   }
 }
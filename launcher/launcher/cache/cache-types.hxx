@@ -10,6 +10,8 @@
 
 #include <odb/core.hxx>
 
+#include <launcher/manifest/manifest-digest.hxx>
+
 namespace launcher
 {
   namespace fs = std::filesystem;
@@ -103,13 +105,13 @@ namespace launcher
                  std::string v,
                  component_type c,
                  std::uint64_t s = 0,
-                 std::string h = "")
+                 const blake3_digest& h = blake3_digest ())
       : path_ (std::move (p)),
         mtime_ (mt),
         version_ (std::move (v)),
         component_ (c),
         size_ (s),
-        hash_ (std::move (h))
+        hash_ (h.bytes ())
     {
     }
 
@@ -130,8 +132,8 @@ namespace launcher
     std::uint64_t
     size () const noexcept { return size_; }
 
-    const std::string&
-    hash () const noexcept { return hash_; }
+    blake3_digest
+    hash () const noexcept { return blake3_digest (hash_); }
 
     // Mutators.
     //
@@ -145,7 +147,7 @@ namespace launcher
     set_size (std::uint64_t s) { size_ = s; }
 
     void
-    set_hash (std::string h) { hash_ = std::move (h); }
+    set_hash (const blake3_digest& h) { hash_ = h.bytes (); }
 
   private:
     friend class odb::access;
@@ -164,9 +166,10 @@ namespace launcher
 
     std::uint64_t size_;
 
-    // BLAKE3 hex string. Kept empty until we actually verify the file.
+    // BLAKE3 digest. Kept zero until we actually verify the file.
     //
-    std::string hash_;
+    #pragma db type("BLOB")
+    blake3_digest::bytes_type hash_ {};
   };
 
   // We track the currently installed version tag for each component group.
@@ -256,6 +259,80 @@ namespace launcher
     std::string val_;
   };
 
+  // A partial download (see download_journal), keyed by its target.
+  //
+  // The hasher state is an opaque memory image so it is only good for the
+  // build that wrote it, which is what the size and digest checks on restore
+  // are for.
+  //
+  #pragma db object table("download_journal")
+  class journaled_download
+  {
+  public:
+    journaled_download () = default;
+
+    journaled_download (std::string t,
+                        std::string u,
+                        std::uint64_t s,
+                        const blake3_digest& h,
+                        std::uint64_t c,
+                        std::vector<char> st,
+                        std::string e)
+      : target_ (std::move (t)),
+        url_ (std::move (u)),
+        size_ (s),
+        hash_ (h.bytes ()),
+        confirmed_ (c),
+        state_ (std::move (st)),
+        etag_ (std::move (e))
+    {
+    }
+
+    const std::string&
+    target () const noexcept { return target_; }
+
+    const std::string&
+    url () const noexcept { return url_; }
+
+    std::uint64_t
+    size () const noexcept { return size_; }
+
+    blake3_digest
+    hash () const noexcept { return blake3_digest (hash_); }
+
+    std::uint64_t
+    confirmed () const noexcept { return confirmed_; }
+
+    const std::vector<char>&
+    state () const noexcept { return state_; }
+
+    const std::string&
+    etag () const noexcept { return etag_; }
+
+  private:
+    friend class odb::access;
+
+    #pragma db id
+    std::string target_;
+
+    #pragma db not_null
+    std::string url_;
+
+    std::uint64_t size_;
+
+    #pragma db type("BLOB")
+    blake3_digest::bytes_type hash_ {};
+
+    // Bytes of the target that are written and hashed.
+    //
+    std::uint64_t confirmed_;
+
+    #pragma db type("BLOB")
+    std::vector<char> state_;
+
+    std::string etag_;
+  };
+
   // Map logical setting names to their database keys.
   //
   // Note that settings that need to be scoped per-installation (to support
@@ -280,11 +357,30 @@ namespace launcher
     {
       return "steam_prompt." + s + "." + d;
     }
+
+    // Format as "release_metadata.<owner>/<repo>" with the ".pre" suffix
+    // for the pre-release channel.
+    //
+    inline std::string
+    release_metadata (const std::string& o, const std::string& r, bool p)
+    {
+      return "release_metadata." + o + "/" + r + (p ? ".pre" : "");
+    }
   }
 
   // Refer to the legacy cache implementation for context.
   //
 
+  // One chunk of a delta download. If source is set, the chunk is already
+  // present in the local copy at that offset. Otherwise it must be fetched.
+  //
+  struct reconcile_chunk
+  {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::optional<std::uint64_t> source;
+  };
+
   // A transient unit of work for the reconciler.
   //
   struct reconcile_item
@@ -292,11 +388,15 @@ namespace launcher
     reconcile_action action;
     std::string path;
     std::string url;
-    std::string expected_hash;
+    blake3_digest expected_hash;
     std::uint64_t expected_size;
     component_type component;
     std::string version;
 
+    // If not empty, the download is a delta against the existing file.
+    //
+    std::vector<reconcile_chunk> chunks;
+
     reconcile_item ()
       : action (reconcile_action::none),
         expected_size (0),
@@ -307,14 +407,14 @@ namespace launcher
     reconcile_item (reconcile_action a,
                     std::string p,
                     std::string u,
-                    std::string h,
+                    const blake3_digest& h,
                     std::uint64_t s,
                     component_type c,
                     std::string v)
       : action (a),
         path (std::move (p)),
         url (std::move (u)),
-        expected_hash (std::move (h)),
+        expected_hash (h),
         expected_size (s),
         component (c),
         version (std::move (v))
@@ -326,6 +426,22 @@ namespace launcher
     {
       return action == reconcile_action::none && path.empty ();
     }
+
+    // Bytes that actually have to come over the wire.
+    //
+    std::uint64_t
+    transfer_size () const noexcept
+    {
+      if (chunks.empty ())
+        return expected_size;
+
+      std::uint64_t r (0);
+      for (const auto& c : chunks)
+        if (!c.source)
+          r += c.size;
+
+      return r;
+    }
   };
 
   // High-level stats to show the user what's happening.
@@ -382,20 +498,19 @@ namespace launcher
     return std::chrono::duration_cast<std::chrono::seconds> (e).count ();
   }
 
-  // Compute the BLAKE3 hash. Returns empty string on failure.
+  // Compute the BLAKE3 hash. Returns empty digest on failure.
   //
-  std::string
+  blake3_digest
   compute_blake3 (const fs::path& p);
 
   // Check if the file on disk matches the expected hash.
   //
   inline bool
-  verify_blake3 (const fs::path& p, const std::string& h)
+  verify_blake3 (const fs::path& p, const blake3_digest& h)
   {
     if (h.empty ())
       return false;
 
-    std::string a (compute_blake3 (p));
-    return !a.empty () && a == h;
+    return compute_blake3 (p) == h;
   }
 }
@@ -0,0 +1,81 @@
+#include <launcher/download/download-clone.hxx>
+
+#include <system_error>
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
+#endif
+
+using namespace std;
+
+namespace launcher
+{
+#ifdef __linux__
+  // Clone the file with FICLONE, which Btrfs, XFS and the like support.
+  // Return false if the filesystem doesn't (or anything else goes wrong),
+  // leaving it to the caller to try something else.
+  //
+  static bool
+  reflink (const fs::path& s, const fs::path& t)
+  {
+    int i (open (s.c_str (), O_RDONLY | O_CLOEXEC));
+    if (i == -1)
+      return false;
+
+    int o (open (t.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (o == -1)
+    {
+      close (i);
+      return false;
+    }
+
+    bool r (ioctl (o, FICLONE, i) == 0);
+
+    close (o);
+    close (i);
+
+    if (!r)
+    {
+      error_code ec;
+      fs::remove (t, ec);
+    }
+
+    return r;
+  }
+#endif
+
+  void
+  clone_file (const fs::path& s, const fs::path& t)
+  {
+    fs::path p (t);
+    p += ".clone";
+
+    error_code ec;
+    fs::remove (p, ec);
+
+    if (t.has_parent_path ())
+      fs::create_directories (t.parent_path ());
+
+    bool r (false);
+
+#ifdef __linux__
+    r = reflink (s, p);
+#endif
+
+    try
+    {
+      if (!r)
+        fs::copy_file (s, p, fs::copy_options::overwrite_existing);
+
+      fs::rename (p, t);
+    }
+    catch (...)
+    {
+      fs::remove (p, ec);
+      throw;
+    }
+  }
+}
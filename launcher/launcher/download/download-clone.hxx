@@ -0,0 +1,21 @@
+#pragma once
+
+#include <filesystem>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Make target a copy of source, sharing the storage if we can.
+  //
+  // We try a reflink (copy-on-write clone, where the filesystem supports
+  // it) and fall back to a plain copy. Note that a hardlink won't do: later
+  // downloads write into their target in place, so two paths that share
+  // content now but not in the next release would overwrite each other.
+  // The copy is assembled next to target and then moved over it so that
+  // whatever target was before is replaced rather than written through.
+  // Throw std::filesystem::filesystem_error on failure.
+  //
+  void
+  clone_file (const fs::path& source, const fs::path& target);
+}
@@ -0,0 +1,159 @@
+#include <launcher/download/download-journal.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+
+namespace launcher
+{
+  download_hasher::
+  download_hasher () noexcept
+  {
+    blake3_hasher_init (&hasher_);
+  }
+
+  void download_hasher::
+  update (const char* d, size_t n) noexcept
+  {
+    blake3_hasher_update (&hasher_, d, n);
+    size_ += n;
+  }
+
+  bool download_hasher::
+  update (const fs::path& f, uint64_t n)
+  {
+    ifstream is (f, ios::binary);
+
+    vector<char> buf (64 * 1024);
+
+    for (uint64_t r (n); r != 0; )
+    {
+      size_t m (static_cast<size_t> (min<uint64_t> (r, buf.size ())));
+
+      if (!is.read (buf.data (), static_cast<streamsize> (m)))
+      {
+        reset ();
+        return false;
+      }
+
+      update (buf.data (), m);
+      r -= m;
+    }
+
+    return true;
+  }
+
+  blake3_digest download_hasher::
+  digest () const noexcept
+  {
+    blake3_digest r;
+    blake3_hasher_finalize (&hasher_, r.data (), r.size ());
+    return r;
+  }
+
+  void download_hasher::
+  reset () noexcept
+  {
+    blake3_hasher_reset (&hasher_);
+    size_ = 0;
+  }
+
+  string download_hasher::
+  save () const
+  {
+    return string (reinterpret_cast<const char*> (&hasher_), sizeof (hasher_));
+  }
+
+  bool download_hasher::
+  restore (const string& s, uint64_t n) noexcept
+  {
+    reset ();
+
+    if (s.size () != sizeof (hasher_))
+      return false;
+
+    blake3_hasher h;
+    memcpy (&h, s.data (), sizeof (h));
+
+    // Make sure it is a plain (unkeyed) hash and that it has seen exactly
+    // the bytes we were told it did.
+    //
+    const blake3_chunk_state& c (h.chunk);
+
+    if (memcmp (h.key, hasher_.key, sizeof (h.key)) != 0 ||
+        c.chunk_counter * BLAKE3_CHUNK_LEN +
+        c.blocks_compressed * BLAKE3_BLOCK_LEN +
+        c.buf_len != n)
+      return false;
+
+    hasher_ = h;
+    size_ = n;
+
+    return true;
+  }
+
+  const download_journal::entry* download_journal::
+  find (const string& t) const
+  {
+    auto i (entries_.find (t));
+    return i != entries_.end () ? &i->second : nullptr;
+  }
+
+  void download_journal::
+  record (entry e)
+  {
+    string t (e.target);
+
+    erased_.erase (t);
+    updated_.insert (t);
+
+    entries_[move (t)] = move (e);
+  }
+
+  void download_journal::
+  erase (const string& t)
+  {
+    if (entries_.erase (t) == 0)
+      return;
+
+    updated_.erase (t);
+    erased_.insert (t);
+  }
+
+  void download_journal::
+  load (vector<entry> es)
+  {
+    entries_.clear ();
+    updated_.clear ();
+    erased_.clear ();
+
+    for (entry& e: es)
+    {
+      string t (e.target);
+      entries_[move (t)] = move (e);
+    }
+  }
+
+  void download_journal::
+  flush ()
+  {
+    if (held_ || (updated_.empty () && erased_.empty ()))
+      return;
+
+    vector<entry> us;
+    us.reserve (updated_.size ());
+
+    for (const string& t: updated_)
+      us.push_back (entries_[t]);
+
+    vector<string> es (erased_.begin (), erased_.end ());
+
+    updated_.clear ();
+    erased_.clear ();
+
+    if (store_)
+      store_ (us, es);
+  }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <filesystem>
+
+#include <launcher/blake3.h>
+
+#include <launcher/manifest/manifest-digest.hxx>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Streamed BLAKE3 digest of a file being downloaded.
+  //
+  // Besides the digest of what was written so far, the hasher state can be
+  // saved and restored which is what lets us resume a download without
+  // reading back what we already have.
+  //
+  class download_hasher
+  {
+  public:
+    download_hasher () noexcept;
+
+    void
+    update (const char* data, std::size_t size) noexcept;
+
+    // Hash the first n bytes of the file, for a partial download we have no
+    // saved state for. Return false if the file can't be read or has fewer
+    // bytes, in which case the hasher is reset.
+    //
+    bool
+    update (const fs::path& file, std::uint64_t n);
+
+    // Return the digest of the bytes so far.
+    //
+    blake3_digest
+    digest () const noexcept;
+
+    // Number of bytes hashed.
+    //
+    std::uint64_t
+    size () const noexcept
+    {
+      return size_;
+    }
+
+    void
+    reset () noexcept;
+
+    // Persistence.
+    //
+    // The saved state is the hasher's memory image so it is only meaningful
+    // to the same build, which is fine for a local journal. Restore rejects
+    // a state that is not of the right size or doesn't agree with the byte
+    // count, leaving the hasher reset.
+    //
+    std::string
+    save () const;
+
+    bool
+    restore (const std::string& state, std::uint64_t size) noexcept;
+
+  private:
+    blake3_hasher hasher_;
+    std::uint64_t size_ = 0;
+  };
+
+  // Journal of partial downloads.
+  //
+  // For each download in progress we record how many bytes made it to the
+  // target along with the digest state at that point and the validator
+  // (ETag) of the resource. This is what a restarted launcher needs to pick
+  // up where the last one left off: truncate the target to what was
+  // confirmed, restore the digest, and ask for the rest, checking that the
+  // resource didn't change in the meantime.
+  //
+  // Changes are collected in memory and handed to the store in batches (see
+  // flush()) so that the download loop doesn't hit the database for every
+  // checkpoint.
+  //
+  class download_journal
+  {
+  public:
+    struct entry
+    {
+      std::string url;
+      std::string target;
+      std::uint64_t size = 0;      // Expected size.
+      blake3_digest hash;          // Expected digest.
+      std::uint64_t confirmed = 0; // Bytes written and hashed.
+      std::string state;           // Hasher state at confirmed.
+      std::string etag;            // Resource validator, empty if none.
+    };
+
+    // Store the updated entries and erase the targets.
+    //
+    using store_function =
+      std::function<void (const std::vector<entry>& updated,
+                          const std::vector<std::string>& erased)>;
+
+    void
+    set_store (store_function f)
+    {
+      store_ = std::move (f);
+    }
+
+    // Return the entry for the target or NULL if there is none.
+    //
+    const entry*
+    find (const std::string& target) const;
+
+    void
+    record (entry);
+
+    void
+    erase (const std::string& target);
+
+    // Load the entries as persisted, replacing what we have.
+    //
+    void
+    load (std::vector<entry>);
+
+    // Hand the changes since the last flush to the store, if any.
+    //
+    void
+    flush ();
+
+    // Hold back flushes while the store is busy with something else (say,
+    // the reconciler planning against the same database). The changes keep
+    // accumulating and go out with the first flush after release().
+    //
+    void
+    hold () noexcept
+    {
+      held_ = true;
+    }
+
+    void
+    release () noexcept
+    {
+      held_ = false;
+    }
+
+    bool
+    empty () const noexcept
+    {
+      return entries_.empty ();
+    }
+
+  private:
+    std::map<std::string, entry> entries_;
+    std::set<std::string> updated_;
+    std::set<std::string> erased_;
+    store_function store_;
+    bool held_ = false;
+  };
+}
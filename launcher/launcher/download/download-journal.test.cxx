@@ -0,0 +1,208 @@
+#include <launcher/download/download-journal.hxx>
+
+#include <cassert>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace launcher;
+
+static string
+sample ()
+{
+  string r;
+  for (size_t i (0); i != 5000; ++i)
+    r += static_cast<char> ('a' + i % 26);
+  return r;
+}
+
+static blake3_digest
+whole (const string& s)
+{
+  download_hasher h;
+  h.update (s.data (), s.size ());
+  return h.digest ();
+}
+
+// Known digest of the empty input.
+//
+static void
+test_empty ()
+{
+  assert (download_hasher ().digest () ==
+          blake3_digest::from_hex (
+            "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"));
+}
+
+// Save part way through (not on a chunk boundary), restore, and finish:
+// same digest as in one go. The byte count must agree with the state.
+//
+static void
+test_restore ()
+{
+  string data (sample ());
+
+  download_hasher h;
+  h.update (data.data (), 1500);
+
+  {
+    download_hasher r;
+    assert (r.restore (h.save (), 1500));
+    assert (r.size () == 1500);
+
+    r.update (data.data () + 1500, data.size () - 1500);
+    assert (r.digest () == whole (data));
+  }
+
+  {
+    download_hasher r;
+    assert (!r.restore (h.save (), 1499));
+    assert (!r.restore ("garbage", 0));
+    assert (r.size () == 0);
+  }
+}
+
+// Catch up with a partial file.
+//
+static void
+test_file ()
+{
+  string data (sample ());
+  fs::path f (fs::temp_directory_path () / "iw4x-download-journal-test");
+
+  {
+    ofstream os (f, ios::binary);
+    os.write (data.data (), 3000);
+  }
+
+  download_hasher h;
+  assert (h.update (f, 3000));
+
+  h.update (data.data () + 3000, data.size () - 3000);
+  assert (h.digest () == whole (data));
+
+  download_hasher s;
+  assert (!s.update (f, 3001));
+  assert (s.size () == 0);
+
+  fs::remove (f);
+}
+
+// Changes are batched until flushed.
+//
+static void
+test_flush ()
+{
+  vector<download_journal::entry> us;
+  vector<string> es;
+
+  download_journal j;
+  j.set_store ([&us, &es] (const vector<download_journal::entry>& u,
+                           const vector<string>& e)
+  {
+    us = u;
+    es = e;
+  });
+
+  download_journal::entry a;
+  a.target = "a";
+  a.confirmed = 1;
+  a.hash = whole ("a");
+
+  download_journal::entry b;
+  b.target = "b";
+
+  j.record (a);
+  a.confirmed = 2;
+  j.record (a);
+  j.record (b);
+
+  assert (j.find ("a")->confirmed == 2);
+  assert (j.find ("a")->hash == whole ("a"));
+  assert (j.find ("c") == nullptr);
+
+  j.flush ();
+  assert (us.size () == 2 && us[0].confirmed == 2 && es.empty ());
+
+  j.erase ("b");
+  j.erase ("c");
+  j.flush ();
+  assert (us.empty () && es == vector<string> {"b"});
+
+  us.clear ();
+  es.clear ();
+  j.flush ();
+  assert (us.empty () && es.empty ());
+}
+
+// Loading replaces what we have and is not a change to flush.
+//
+static void
+test_load ()
+{
+  bool stored (false);
+
+  download_journal j;
+  j.set_store ([&stored] (const vector<download_journal::entry>&,
+                          const vector<string>&)
+  {
+    stored = true;
+  });
+
+  download_journal::entry a;
+  a.target = "a";
+  j.record (a);
+
+  download_journal::entry b;
+  b.target = "b";
+  b.hash = whole ("b");
+
+  j.load ({b});
+  assert (j.find ("a") == nullptr);
+  assert (j.find ("b") != nullptr && j.find ("b")->hash == whole ("b"));
+
+  j.flush ();
+  assert (!stored);
+
+  j.load ({});
+  assert (j.empty ());
+}
+
+// Held changes stay pending until released and flushed.
+//
+static void
+test_hold ()
+{
+  size_t stored (0);
+
+  download_journal j;
+  j.set_store ([&stored] (const vector<download_journal::entry>& u,
+                          const vector<string>&)
+  {
+    stored += u.size ();
+  });
+
+  download_journal::entry a;
+  a.target = "a";
+
+  j.hold ();
+  j.record (a);
+  j.flush ();
+  assert (stored == 0);
+
+  j.release ();
+  j.flush ();
+  assert (stored == 1);
+}
+
+int
+main ()
+{
+  test_empty ();
+  test_restore ();
+  test_file ();
+  test_flush ();
+  test_load ();
+  test_hold ();
+}
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <map>
+#include <string>
 #include <vector>
+#include <utility>
 #include <memory>
 #include <queue>
+#include <chrono>
+#include <optional>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 
 #include <boost/asio.hpp>
 
 #include <launcher/download/download-task.hxx>
 #include <launcher/download/download-types.hxx>
+#include <launcher/download/download-mirror.hxx>
+#include <launcher/download/download-clone.hxx>
+#include <launcher/download/download-journal.hxx>
 
 namespace launcher
 {
@@ -84,13 +93,99 @@ namespace launcher
       return max_parallel_;
     }
 
+    // Scheduling.
+    //
+    // Tasks are started in the order of their priority and, within the same
+    // priority, as the policy dictates. Note that this also applies to tasks
+    // added while download_all() is running (see hold()), which are slotted
+    // in among those not yet started.
+    //
+    void
+    set_schedule (download_schedule s)
+    {
+      schedule_ = s;
+    }
+
+    download_schedule
+    schedule () const
+    {
+      return schedule_;
+    }
+
+    // Mirror selection.
+    //
+    // If set, the URLs of a request with several are tried best mirror
+    // first, probing those we know nothing about, and every attempt is
+    // recorded. Note that the ranking must outlive the manager.
+    //
+    void
+    set_mirror_ranking (mirror_ranking* r)
+    {
+      mirrors_ = r;
+    }
+
+    // Hedging.
+    //
+    // If a plain download with another mirror to fall back to stays below
+    // floor bytes per second for window, start fetching the rest of it from
+    // that mirror as well and keep whichever finishes first. A zero floor
+    // (the default) disables hedging.
+    //
+    void
+    set_hedging (std::uint64_t floor, std::chrono::seconds window)
+    {
+      hedge_floor_ = floor;
+      hedge_window_ = window;
+    }
+
+    // Stall detection.
+    //
+    // Once there are no more tasks to start, a task is only as good as its
+    // connection and the batch only finishes when the slowest one does. So
+    // from then on, if a plain download (that is not being hedged) stays
+    // below floor bytes per second for window, drop the connection and
+    // resume it from where it got to on a new one. A zero floor (the
+    // default) disables this.
+    //
+    void
+    set_stall_detection (std::uint64_t floor, std::chrono::seconds window)
+    {
+      stall_floor_ = floor;
+      stall_window_ = window;
+    }
+
+    // Journaling.
+    //
+    // A download with an expected size and hash is hashed as it is written
+    // (delta downloads as they are assembled), which spares reading it back
+    // to verify. The exception is a hedged download which is written out of
+    // order and so is read back once complete. If the journal is
+    // set, the digest state is also checkpointed there every few seconds so
+    // that, should we get interrupted, the next run can resume the download
+    // without reading back what is already there (see download_journal).
+    // Note that the journal must outlive the manager.
+    //
+    void
+    set_journal (download_journal* j)
+    {
+      journal_ = j;
+    }
+
     // Task management.
     //
+    // A task that produces the same bytes as one added before it (same
+    // content identity or, failing that, same URL; see the request) is not
+    // downloaded but becomes a copy of the earlier one, its origin: once
+    // the origin completes, the copy's target is cloned from the origin's
+    // (see clone_file()). If the origin fails, its first copy is downloaded
+    // instead and becomes the origin of the rest. Tasks with a sink are
+    // neither origins nor copies since there is no target to clone.
+    //
     std::shared_ptr<task_type>
     add_task (request_type req)
     {
       auto task (std::make_shared<task_type> (std::move (req)));
-      tasks_.push_back (task);
+      add_task (task);
       return task;
     }
 
@@ -98,16 +193,33 @@ namespace launcher
     add_task (request_type req, handler_type hdl)
     {
       auto task (std::make_shared<task_type> (std::move (req), std::move (hdl)));
-      tasks_.push_back (task);
+      add_task (task);
       return task;
     }
 
     void
     add_task (std::shared_ptr<task_type> task)
     {
+      coalesce (task);
       tasks_.push_back (std::move (task));
     }
 
+    // Keep download_all() going, picking up tasks as they are added, until
+    // released. This is for when the tasks are discovered while the batch is
+    // already running.
+    //
+    void
+    hold ()
+    {
+      held_ = true;
+    }
+
+    void
+    release ()
+    {
+      held_ = false;
+    }
+
     // Access tasks.
     //
     const std::vector<std::shared_ptr<task_type>>&
@@ -233,20 +345,155 @@ namespace launcher
     clear ()
     {
       tasks_.clear ();
+      origins_.clear ();
+      origin_.clear ();
+      copies_.clear ();
     }
 
   private:
     boost::asio::io_context& ioc_;
     std::size_t max_parallel_;
     std::vector<std::shared_ptr<task_type>> tasks_;
+    bool held_ = false;
 
     completion_callback on_task_complete_;
     batch_completion_callback on_batch_complete_;
 
+    download_schedule schedule_ {download_schedule::fifo};
+
+    // Coalescing (see add_task()): origins by identity, the origin of each
+    // copy, and the copies of each origin. The identity is the expected
+    // digest or, if there is none, the URL (with an empty digest).
+    //
+    using identity_type = std::pair<blake3_digest, std::string>;
+
+    std::map<identity_type, std::shared_ptr<task_type>> origins_;
+    std::map<const task_type*, std::shared_ptr<task_type>> origin_;
+    std::map<const task_type*, std::vector<std::shared_ptr<task_type>>> copies_;
+
+    mirror_ranking* mirrors_ = nullptr;
+    std::uint64_t hedge_floor_ = 0;
+    std::chrono::seconds hedge_window_ {10};
+    std::uint64_t stall_floor_ = 0;
+    std::chrono::seconds stall_window_ {20};
+
+    download_journal* journal_ = nullptr;
+
+    // True once download_all() has no more tasks to start.
+    //
+    bool tail_ = false;
+
+    // Helper: Return once the transfer at offset stays below floor bytes per
+    // second for window, only counting the time in the tail of the batch if
+    // requested. Throw if the transfer is done first.
+    //
+    boost::asio::awaitable<void>
+    await_stall (const std::uint64_t& offset,
+                 const bool& done,
+                 std::uint64_t floor,
+                 std::chrono::seconds window,
+                 bool tail);
+
+    // Digest of a plain download as it is written (see set_journal()).
+    //
+    struct tracker
+    {
+      download_hasher hasher;
+      download_journal::entry entry;
+      std::chrono::steady_clock::time_point saved;
+    };
+
+    // Helper: Start tracking the task's download. If resuming, pick up the
+    // digest of what the target already has from the journal or, failing
+    // that, by hashing it.
+    //
+    void
+    track (const task_type& task, bool resume, std::optional<tracker>& r);
+
+    // Helper: Record the tracker's state in the journal.
+    //
+    void
+    checkpoint (tracker& t);
+
+    // Helper: Download the target from the URL, resuming from resume_from
+    // or, if tracked, from where the tracker got to.
+    //
+    template <typename C, typename P>
+    boost::asio::awaitable<std::uint64_t>
+    fetch (std::shared_ptr<task_type> task,
+           C& client,
+           const std::string& url,
+           std::optional<std::uint64_t> resume_from,
+           tracker* t,
+           P& progress);
+
+    // Helper: Download the target, restarting the transfer if it stalls in
+    // the tail of the batch. Update resume_from as it goes.
+    //
+    template <typename C, typename P>
+    boost::asio::awaitable<std::uint64_t>
+    download_watched (std::shared_ptr<task_type> task,
+                      C& client,
+                      const std::string& url,
+                      std::optional<std::uint64_t>& resume_from,
+                      tracker* t,
+                      P& progress);
+
+    // Helper: Measure the first-byte latency of the task's mirrors that we
+    // know nothing about yet.
+    //
+    boost::asio::awaitable<void>
+    probe_mirrors (std::shared_ptr<task_type> task);
+
+    // Helper: Download the target from the i-th URL, hedging with the next
+    // one if the transfer stalls.
+    //
+    template <typename C, typename P>
+    boost::asio::awaitable<std::uint64_t>
+    download_hedged (std::shared_ptr<task_type> task,
+                     C& client,
+                     std::size_t i,
+                     std::optional<std::uint64_t> resume_from,
+                     P& progress);
+
+    // Helper: Rebuild the target of a delta task, fetching only the missing
+    // chunks and hashing the result as it is written.
+    //
+    template <typename C>
+    boost::asio::awaitable<std::uint64_t>
+    download_delta (std::shared_ptr<task_type> task,
+                    C& client,
+                    const std::string& url,
+                    download_hasher& h);
+
+    // Helper: Return the identity of the request for coalescing or nullopt
+    // if it is not to be coalesced.
+    //
+    static std::optional<identity_type>
+    identity (const request_type&);
+
+    // Helper: Make the task a copy of an earlier one with the same identity,
+    // if any, or the origin for its identity otherwise.
+    //
+    void
+    coalesce (const std::shared_ptr<task_type>& task);
+
+    // Helper: Settle the copies of the origin if it is done, cloning their
+    // targets if it completed. If it failed, make the first copy the origin
+    // of the rest and return it so that it gets started.
+    //
+    std::shared_ptr<task_type>
+    settle (const task_type& origin);
+
     // Helper: Sort tasks by priority.
     //
     std::vector<std::shared_ptr<task_type>>
     sort_by_priority () const;
+
+    // Helper: Return true if task x should be started before y.
+    //
+    bool
+    before (const task_type& x, const task_type& y) const;
   };
 
   // Default manager type.
@@ -16,16 +16,89 @@ namespace launcher
 
     std::vector<task_ptr> r (tasks_);
 
+    std::stable_sort (r.begin (), r.end (), [this] (const auto& a,
+                                                    const auto& b)
+    {
+      return before (*a, *b);
+    });
+
+    return r;
+  }
+
+  template <typename H, typename T>
+  inline bool basic_download_manager<H, T>::
+  before (const task_type& x, const task_type& y) const
+  {
     // Sort descending.
     //
     // We assume that a higher integer value for priority corresponds to a
     // more urgent task (e.g., 10 runs before 1).
     //
-    std::stable_sort (r.begin (), r.end (), [] (const auto& a, const auto& b)
+    if (x.request.priority != y.request.priority)
+      return x.request.priority > y.request.priority;
+
+    // Go by what actually has to come over the wire: for a delta that's
+    // only the missing chunks. Note that a task of unknown size counts as
+    // empty.
+    //
+    auto size ([] (const request_type& r)
     {
-      return a->request.priority > b->request.priority;
+      if (r.chunks.empty ())
+        return r.expected_size.value_or (0);
+
+      std::uint64_t n (0);
+      for (const auto& c : r.chunks)
+        if (!c.source)
+          n += c.size;
+
+      return n;
     });
 
-    return r;
+    switch (schedule_)
+    {
+      case download_schedule::fifo:           break;
+      case download_schedule::largest_first:  return size (x.request) > size (y.request);
+      case download_schedule::smallest_first: return size (x.request) < size (y.request);
+    }
+
+    return false;
+  }
+
+  template <typename H, typename T>
+  inline std::optional<typename basic_download_manager<H, T>::identity_type>
+  basic_download_manager<H, T>::
+  identity (const request_type& r)
+  {
+    if (r.sink || !r.valid ())
+      return std::nullopt;
+
+    return r.content.empty ()
+      ? identity_type (blake3_digest (), std::string (r.urls.front ()))
+      : identity_type (r.content, std::string ());
+  }
+
+  template <typename H, typename T>
+  inline void basic_download_manager<H, T>::
+  coalesce (const std::shared_ptr<task_type>& task)
+  {
+    std::optional<identity_type> k (identity (task->request));
+
+    if (!k)
+      return;
+
+    // If the origin failed (say, its mirror served something that didn't
+    // match the hash), there is nothing to clone from so start over with
+    // this task.
+    //
+    auto i (origins_.find (*k));
+
+    if (i == origins_.end () || i->second->failed ())
+    {
+      origins_[std::move (*k)] = task;
+      return;
+    }
+
+    origin_[task.get ()] = i->second;
+    copies_[i->second.get ()].push_back (task);
   }
 }
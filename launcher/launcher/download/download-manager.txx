@@ -1,7 +1,10 @@
 #include <algorithm>
 #include <fstream>
+#include <optional>
+#include <chrono>
 
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/experimental/parallel_group.hpp>
@@ -17,21 +20,50 @@ namespace launcher
   boost::asio::awaitable<void> basic_download_manager<H, T>::
   download_all ()
   {
-    if (tasks_.empty ())
+    if (tasks_.empty () && !held_)
       co_return;
 
     // Sort tasks so that high-priority items (e.g., base game files) are
-    // downloaded before optional content or lower-priority assets.
+    // downloaded before optional content or lower-priority assets, and the
+    // rest according to the schedule.
+    //
+    // Tasks added while we are running (see hold()) are slotted in among
+    // those not yet started.
     //
     auto sorted_tasks (sort_by_priority ());
+    std::size_t seen (tasks_.size ());
+
+    tail_ = false;
 
     std::vector<std::shared_ptr<task_type>> active_tasks;
     std::size_t next_task_index (0);
 
-    // Start the initial batch of downloads up to the concurrency limit.
+    // Hand the journal over to the store now and then rather than on every
+    // checkpoint.
     //
-    while (next_task_index < sorted_tasks.size () &&
-           active_tasks.size () < max_parallel_)
+    auto flushed (std::chrono::steady_clock::now ());
+
+    auto cmp ([this] (const auto& a, const auto& b)
+    {
+      return before (*a, *b);
+    });
+
+    // Slot a copy that has to be downloaded after all (see settle()) in
+    // among the pending tasks, unless it is still pending anyway.
+    //
+    auto promote ([&sorted_tasks, &next_task_index, &cmp] (
+                    std::shared_ptr<task_type> t)
+    {
+      auto b (sorted_tasks.begin () + next_task_index);
+      auto e (sorted_tasks.end ());
+
+      if (t != nullptr && std::find (b, e, t) == e)
+        sorted_tasks.insert (std::upper_bound (b, e, t, cmp), std::move (t));
+    });
+
+    // Start the next pending task.
+    //
+    auto start ([&, this] ()
     {
       auto task (sorted_tasks[next_task_index++]);
 
@@ -39,7 +71,16 @@ namespace launcher
       // previously).
       //
       if (task->completed () || task->failed ())
-        continue;
+        return;
+
+      // A copy is not started but settled along with its origin, which may
+      // already be done (for example, if the copy was added later).
+      //
+      if (auto i (origin_.find (task.get ())); i != origin_.end ())
+      {
+        promote (settle (*i->second));
+        return;
+      }
 
       active_tasks.push_back (task);
 
@@ -47,29 +88,70 @@ namespace launcher
           ioc_,
           download_task (task),
           boost::asio::detached);
-    }
+    });
+
+    // Start the initial batch of downloads up to the concurrency limit.
+    //
+    while (next_task_index < sorted_tasks.size () &&
+           active_tasks.size () < max_parallel_)
+      start ();
 
     // Main event loop: wait for tasks to complete and replenish the queue.
     //
-    while (!active_tasks.empty () || next_task_index < sorted_tasks.size ())
+    while (!active_tasks.empty () ||
+           next_task_index < sorted_tasks.size () ||
+           held_ ||
+           tasks_.size () > seen)
     {
+      if (tasks_.size () > seen)
+      {
+        // Sort the newcomers and merge them into the pending ones rather
+        // than resorting everything since they trickle in while the plan is
+        // being built.
+        //
+        std::size_t n (sorted_tasks.size ());
+
+        sorted_tasks.insert (sorted_tasks.end (),
+                             tasks_.begin () + seen,
+                             tasks_.end ());
+        seen = tasks_.size ();
+
+        std::stable_sort (sorted_tasks.begin () + n, sorted_tasks.end (), cmp);
+        std::inplace_merge (sorted_tasks.begin () + next_task_index,
+                            sorted_tasks.begin () + n,
+                            sorted_tasks.end (),
+                            cmp);
+      }
+
       // Remove completed or failed tasks from the active list.
       //
       // We also trigger the per-task completion callback here to notify the UI
-      // or caller of incremental progress.
+      // or caller of incremental progress. Once a task is done, so are its
+      // copies (see add_task()).
       //
+      std::vector<std::shared_ptr<task_type>> promoted;
+
       active_tasks.erase (std::remove_if (active_tasks.begin (),
                                           active_tasks.end (),
-                                          [this] (const auto& t)
+                                          [this, &promoted] (const auto& t)
       {
         bool done (t->completed () || t->failed ());
 
-        if (done && on_task_complete_)
-          on_task_complete_ (t);
+        if (done)
+        {
+          if (on_task_complete_)
+            on_task_complete_ (t);
+
+          if (auto p = settle (*t))
+            promoted.push_back (std::move (p));
+        }
 
         return done;
       }), active_tasks.end ());
 
+      for (auto& p: promoted)
+        promote (std::move (p));
+
       // Replenish the active queue.
       //
       // If we have capacity and pending tasks, spawn new coroutines
@@ -77,18 +159,20 @@ namespace launcher
       //
       while (next_task_index < sorted_tasks.size () &&
              active_tasks.size () < max_parallel_)
-      {
-        auto task (sorted_tasks[next_task_index++]);
-
-        if (task->completed () || task->failed ())
-          continue;
+        start ();
 
-        active_tasks.push_back (task);
+      // Nothing left to start, the rest is up to the active tasks (see
+      // set_stall_detection()).
+      //
+      tail_ = next_task_index == sorted_tasks.size () &&
+              !held_ &&
+              tasks_.size () == seen;
 
-        boost::asio::co_spawn (
-            ioc_,
-            download_task (task),
-            boost::asio::detached);
+      if (journal_ != nullptr &&
+          std::chrono::steady_clock::now () - flushed >= std::chrono::seconds (1))
+      {
+        journal_->flush ();
+        flushed = std::chrono::steady_clock::now ();
       }
 
       // Throttle the loop.
@@ -101,10 +185,96 @@ namespace launcher
       co_await timer.async_wait (boost::asio::use_awaitable);
     }
 
+    tail_ = false;
+
+    if (journal_ != nullptr)
+      journal_->flush ();
+
     if (on_batch_complete_)
       on_batch_complete_ (completed_count (), failed_count ());
   }
 
+  template <typename H, typename T>
+  std::shared_ptr<typename basic_download_manager<H, T>::task_type>
+  basic_download_manager<H, T>::
+  settle (const task_type& o)
+  {
+    auto i (copies_.find (&o));
+
+    if (i == copies_.end () || !(o.completed () || o.failed ()))
+      return nullptr;
+
+    std::vector<std::shared_ptr<task_type>> cs (std::move (i->second));
+    copies_.erase (i);
+
+    for (const auto& c: cs)
+      origin_.erase (c.get ());
+
+    // Nothing to clone from, so download the first copy instead and clone
+    // the rest from that.
+    //
+    if (o.failed ())
+    {
+      std::shared_ptr<task_type> n (cs.front ());
+
+      for (auto j (cs.begin () + 1); j != cs.end (); ++j)
+      {
+        origin_[j->get ()] = n;
+        copies_[n.get ()].push_back (*j);
+      }
+
+      // Note that only requests with an identity have copies.
+      //
+      if (auto j (origins_.find (*identity (n->request)));
+          j != origins_.end () && j->second.get () == &o)
+        j->second = n;
+
+      return n;
+    }
+
+    const fs::path& f (o.request.target);
+    std::uint64_t n (o.total_bytes.load ());
+
+    for (const auto& c: cs)
+    {
+      c->response.start_time = std::chrono::steady_clock::now ();
+
+      if (c->should_cancel ())
+      {
+        c->response.outcome = download_outcome::cancelled;
+        c->set_error (download_error ("Download cancelled"));
+      }
+      else
+      {
+        try
+        {
+          // The same target may well be queued twice.
+          //
+          if (c->request.target != f)
+            clone_file (f, c->request.target);
+
+          c->update_progress (n, n);
+          c->response.outcome = download_outcome::ok;
+          c->response.successful_url_index = o.response.successful_url_index;
+          c->set_state (download_state::completed);
+        }
+        catch (const std::exception& e)
+        {
+          c->response.outcome = download_outcome::transfer;
+          c->set_error (download_error (
+              "Failed to clone " + f.string () + ": " + e.what ()));
+        }
+      }
+
+      c->response.end_time = std::chrono::steady_clock::now ();
+
+      if (on_task_complete_)
+        on_task_complete_ (c);
+    }
+
+    return nullptr;
+  }
+
   // Download a single task.
   //
   template <typename H, typename T>
@@ -113,6 +283,7 @@ namespace launcher
   {
     if (!task->request.valid ())
     {
+      task->response.outcome = download_outcome::transfer;
       task->set_error (download_error ("Invalid download request"));
       co_return;
     }
@@ -137,7 +308,10 @@ namespace launcher
     // corresponding to the beginning of the file.
     //
     std::optional<std::uint64_t> resume_from;
-    if (task->request.resume && fs::exists (task->request.target))
+    if (!task->request.sink &&
+        task->request.chunks.empty () &&
+        task->request.resume &&
+        fs::exists (task->request.target))
     {
       std::error_code ec;
       std::uint64_t existing_size (fs::file_size (task->request.target, ec));
@@ -150,6 +324,19 @@ namespace launcher
       }
     }
 
+    // Try the mirrors best first, getting to know those we haven't seen
+    // before.
+    //
+    if (mirrors_ != nullptr && task->request.urls.size () > 1)
+    {
+      co_await probe_mirrors (task);
+      task->request.urls = mirrors_->rank (std::move (task->request.urls));
+    }
+
+    // Digest of the target as it is written, if we track it.
+    //
+    std::optional<tracker> tr;
+
     // Iterate over mirrors and attempt to download.
     //
     bool success (false);
@@ -157,6 +344,7 @@ namespace launcher
     {
       if (task->should_cancel ())
       {
+        task->response.outcome = download_outcome::cancelled;
         task->set_error (download_error ("Download cancelled"));
         break;
       }
@@ -175,6 +363,55 @@ namespace launcher
 
       const auto& url (task->request.urls[i]);
 
+      // What went wrong if this attempt throws, unless it was the server
+      // (see below).
+      //
+      download_outcome fail (download_outcome::transfer);
+
+      // When the attempt started and its first byte arrived, for the mirror
+      // ranking.
+      //
+      auto started (std::chrono::steady_clock::now ());
+      std::optional<std::chrono::steady_clock::time_point> first;
+
+      // A plain download with a mirror to fall back to can be hedged, in
+      // which case download_hedged() does the ranking.
+      //
+      bool hedge (hedge_floor_ != 0 &&
+                  !task->request.sink &&
+                  task->request.chunks.empty () &&
+                  task->request.expected_size &&
+                  i + 1 < task->request.urls.size ());
+
+      // Otherwise, a plain download that we can resume is watched for
+      // stalls.
+      //
+      bool watch (stall_floor_ != 0 &&
+                  !hedge &&
+                  !task->request.sink &&
+                  task->request.chunks.empty () &&
+                  task->request.resume);
+
+      // Track a plain download with a known size and hash unless it is
+      // hedged, since the hedge writes out of order.
+      //
+      if (!hedge &&
+          !task->request.sink &&
+          task->request.chunks.empty () &&
+          task->request.expected_size.value_or (0) != 0 &&
+          !task->request.content.empty ())
+      {
+        if (!tr)
+          track (*task, resume_from.has_value (), tr);
+      }
+      else if (tr)
+      {
+        if (journal_ != nullptr)
+          journal_->erase (tr->entry.target);
+
+        tr.reset ();
+      }
+
       try
       {
         task->set_state (download_state::connecting);
@@ -186,26 +423,147 @@ namespace launcher
         // check for cancellation here, pausing is harder to handle
         // mid-transfer without dropping the connection.
         //
-        auto progress_callback ([task, this](std::uint64_t transferred,
-                                              std::uint64_t total)
+        auto progress_callback ([task, &first] (std::uint64_t transferred,
+                                                std::uint64_t total)
         {
           if (task->should_cancel ())
             throw std::runtime_error ("Download cancelled");
 
+          if (!first)
+            first = std::chrono::steady_clock::now ();
+
           task->update_progress (transferred, total);
           task->response.progress.speed_bps = 0; // calculated by caller/ui
         });
 
+        // If the request carries a delta plan, only fetch what's missing. If
+        // it carries a sink, stream the body into it rather than into the
+        // target file.
+        //
+        download_hasher dh;
+
         std::uint64_t bytes_downloaded (
-          co_await client.download (url,
-                                    task->request.target.string (),
+          !task->request.chunks.empty ()
+          ? co_await download_delta (task, client, url, dh)
+          : task->request.sink
+          ? co_await client.stream (url,
+                                    task->request.sink,
                                     progress_callback,
-                                    resume_from,
-                                    task->request.rate_limit_bytes_per_second));
+                                    task->request.rate_limit_bytes_per_second)
+          : hedge
+          ? co_await download_hedged (task,
+                                      client,
+                                      i,
+                                      resume_from,
+                                      progress_callback)
+          : watch
+          ? co_await download_watched (task,
+                                       client,
+                                       url,
+                                       resume_from,
+                                       tr ? &*tr : nullptr,
+                                       progress_callback)
+          : co_await fetch (task,
+                            client,
+                            url,
+                            resume_from,
+                            tr ? &*tr : nullptr,
+                            progress_callback));
+
+        // Check the result while we still have mirrors to fall back to.
+        // A result that doesn't check out is useless to resume from, so we
+        // start over.
+        //
+        if (!task->request.sink)
+        {
+          const fs::path& f (task->request.target);
+
+          auto discard ([this, &f, &resume_from, &tr] ()
+          {
+            std::error_code ec;
+            fs::remove (f, ec);
+            resume_from = std::nullopt;
+
+            if (tr)
+            {
+              tr->hasher.reset ();
+              tr->entry.etag.clear ();
+
+              if (journal_ != nullptr)
+                journal_->erase (tr->entry.target);
+            }
+          });
+
+          if (const auto& es = task->request.expected_size)
+          {
+            std::error_code ec;
+            std::uint64_t n (fs::file_size (f, ec));
+
+            if (ec || n != *es)
+            {
+              discard ();
+              fail = download_outcome::size_mismatch;
+              throw std::runtime_error (
+                "size mismatch: expected " + std::to_string (*es) +
+                ", got " + (ec ? ec.message () : std::to_string (n)));
+            }
+          }
+
+          // Tracked and delta downloads were hashed as they were written so
+          // there is no need to read them back. Anything else (a hedged
+          // download or one without a size to track) we have to.
+          //
+          if (const auto& c = task->request.content; !c.empty ())
+          {
+            std::optional<blake3_digest> d;
+
+            if (!task->request.chunks.empty ())
+              d = dh.digest ();
+            else if (tr && tr->hasher.size () == *task->request.expected_size)
+              d = tr->hasher.digest ();
+            else
+            {
+              std::error_code ec;
+              std::uint64_t n (fs::file_size (f, ec));
+
+              download_hasher h;
+              if (!ec && h.update (f, n))
+                d = h.digest ();
+            }
+
+            if (!d || *d != c)
+            {
+              discard ();
+              fail = download_outcome::hash_mismatch;
+              throw std::runtime_error ("hash mismatch");
+            }
+          }
+
+          if (tr && journal_ != nullptr)
+            journal_->erase (tr->entry.target);
+        }
+
+        if (mirrors_ != nullptr && !hedge && task->request.chunks.empty () &&
+            first)
+        {
+          using std::chrono::duration_cast;
+          using ms = mirror_ranking::duration;
+
+          std::uint64_t n (bytes_downloaded);
+
+          if (!task->request.sink && resume_from && n >= *resume_from)
+            n -= *resume_from;
+
+          mirrors_->record (url,
+                            n,
+                            duration_cast<ms> (std::chrono::steady_clock::now () - started),
+                            duration_cast<ms> (*first - started));
+        }
 
         task->update_progress (bytes_downloaded, bytes_downloaded);
-        task->response.http_status_code = 200; // Successful download
+        task->response.http_status_code = client.last_status ();
         task->response.server_reported_size = bytes_downloaded;
+        task->response.outcome = download_outcome::ok;
 
         task->response.successful_url_index = i;
         task->set_state (download_state::completed);
@@ -222,6 +580,29 @@ namespace launcher
       {
         std::string s (e.what ());
 
+        unsigned int st (client.last_status ());
+
+        if (st != 0)
+          task->response.http_status_code = st;
+
+        if (task->should_cancel ())
+          fail = download_outcome::cancelled;
+        else if (fail == download_outcome::transfer && st >= 400)
+          fail = download_outcome::http_status;
+
+        task->response.outcome = fail;
+
+        // If the delta failed (server ignores ranges, local copy changed
+        // underneath us, etc), retry the same URL with a plain download.
+        //
+        if (!task->request.chunks.empty ())
+        {
+          task->request.chunks.clear ();
+
+          --i;
+          continue;
+        }
+
         // 416 (Range Not Satisfiable).
         //
         // If we are resuming, this implies the local file state is invalid
@@ -235,12 +616,36 @@ namespace launcher
           fs::remove (task->request.target, ec);
           resume_from = std::nullopt;
 
+          if (tr)
+          {
+            tr->hasher.reset ();
+            tr->entry.etag.clear ();
+          }
+
           // Retry the same URL without resuming.
           //
           --i;
           continue;
         }
 
+        // Whatever else went wrong, this mirror let us down.
+        //
+        if (mirrors_ != nullptr && fail != download_outcome::cancelled)
+          mirrors_->fail (url);
+
+        // A sink has already consumed part of the body and cannot be
+        // replayed against another mirror, so fail the task and let the
+        // caller fall back.
+        //
+        if (task->request.sink)
+        {
+          task->set_error (download_error (
+              std::string ("Streamed download failed: ") + e.what (),
+              url,
+              static_cast<int> (st)));
+          break;
+        }
+
         if (i == task->request.urls.size () - 1)
         {
           // All mirrors failed.
@@ -248,7 +653,7 @@ namespace launcher
           task->set_error (download_error (
               std::string ("Download failed: ") + e.what (),
               url,
-              0));
+              static_cast<int> (st)));
         }
         else
         {
@@ -272,4 +677,753 @@ namespace launcher
 
     task->response.end_time = std::chrono::steady_clock::now ();
   }
+
+  // Probe the task's unknown mirrors.
+  //
+  // We ask each for the first byte of the resource which, besides the
+  // latency, also tells us that the mirror has it and honors ranges (which
+  // hedging relies on). Note that we probe one after another: there are
+  // normally only a couple of mirrors and a probe is cheap compared to the
+  // transfer that follows.
+  //
+  template <typename H, typename T>
+  boost::asio::awaitable<void> basic_download_manager<H, T>::
+  probe_mirrors (std::shared_ptr<task_type> task)
+  {
+    using namespace std::chrono;
+
+    http_client_traits<> traits;
+    traits.connect_timeout = task->request.connect_timeout * 1000;
+    traits.request_timeout = task->request.connect_timeout * 1000;
+
+    for (const auto& u : task->request.urls)
+    {
+      if (!mirrors_->probe (u))
+        continue;
+
+      basic_http_client<> client (ioc_, traits);
+      auto started (steady_clock::now ());
+
+      try
+      {
+        co_await client.stream (u,
+                                [] (const char*, std::size_t) {return false;},
+                                nullptr,
+                                0,
+                                std::make_pair (std::uint64_t (0),
+                                                std::uint64_t (0)));
+
+        mirrors_->record (
+          u, duration_cast<mirror_ranking::duration> (steady_clock::now () - started));
+      }
+      catch (const std::exception&)
+      {
+        mirrors_->fail (u);
+      }
+    }
+  }
+
+  // Wait for a stall.
+  //
+  // We sample the offset twice a second and compare the progress over the
+  // window against the floor, starting a new window each time it passes.
+  // Note that outside of the tail we keep restarting the window so that
+  // only the time spent in the tail counts.
+  //
+  template <typename H, typename T>
+  boost::asio::awaitable<void> basic_download_manager<H, T>::
+  await_stall (const std::uint64_t& off,
+               const bool& done,
+               std::uint64_t floor,
+               std::chrono::seconds window,
+               bool tail)
+  {
+    using namespace std::chrono;
+
+    boost::asio::steady_timer t (ioc_);
+
+    std::uint64_t mark (off);
+    auto since (steady_clock::now ());
+    auto w (duration_cast<milliseconds> (window).count ());
+
+    for (;;)
+    {
+      t.expires_after (milliseconds (500));
+      co_await t.async_wait (boost::asio::use_awaitable);
+
+      if (done)
+        throw std::runtime_error ("transfer is over");
+
+      auto now (steady_clock::now ());
+      auto el (duration_cast<milliseconds> (now - since).count ());
+
+      if (tail && !tail_)
+      {
+        mark = off;
+        since = now;
+        continue;
+      }
+
+      if (el >= w)
+      {
+        if ((off - mark) * 1000 / static_cast<std::uint64_t> (el) < floor)
+          co_return;
+
+        mark = off;
+        since = now;
+      }
+    }
+  }
+
+  template <typename H, typename T>
+  void basic_download_manager<H, T>::
+  track (const task_type& task, bool resume, std::optional<tracker>& r)
+  {
+    const auto& rq (task.request);
+
+    tracker& t (r.emplace ());
+    t.entry.url = rq.urls.empty () ? std::string () : rq.urls.front ();
+    t.entry.target = rq.target.string ();
+    t.entry.size = *rq.expected_size;
+    t.entry.hash = rq.content;
+    t.saved = std::chrono::steady_clock::now ();
+
+    if (!resume)
+      return;
+
+    std::error_code ec;
+    std::uint64_t z (fs::file_size (rq.target, ec));
+
+    if (ec || z == 0)
+      return;
+
+    // Prefer the journal since it saves us reading the target back. Only
+    // trust it for the same content and as long as the target still has
+    // what it says was confirmed.
+    //
+    if (journal_ != nullptr)
+    {
+      const download_journal::entry* e (journal_->find (t.entry.target));
+
+      if (e != nullptr           &&
+          e->hash == t.entry.hash &&
+          e->size == t.entry.size &&
+          e->confirmed <= z       &&
+          t.hasher.restore (e->state, e->confirmed))
+      {
+        t.entry.url = e->url;
+        t.entry.etag = e->etag;
+        return;
+      }
+    }
+
+    t.hasher.update (rq.target, std::min (z, t.entry.size));
+  }
+
+  template <typename H, typename T>
+  void basic_download_manager<H, T>::
+  checkpoint (tracker& t)
+  {
+    t.saved = std::chrono::steady_clock::now ();
+
+    if (journal_ == nullptr)
+      return;
+
+    t.entry.confirmed = t.hasher.size ();
+    t.entry.state = t.hasher.save ();
+    journal_->record (t.entry);
+  }
+
+  // Download, hashing as we go.
+  //
+  // Untracked, this is a plain client download. Otherwise we stream the
+  // body into the target ourselves, feeding the hasher and checkpointing it
+  // every few seconds. Note that the file is flushed before each checkpoint
+  // so that what we record as confirmed is never ahead of the target.
+  //
+  // A tracked download resumes from what the hasher has seen, cutting back
+  // whatever the target may have past that. If the resource changed since
+  // (its ETag differs from the one we recorded for the same URL) or the
+  // server won't serve the range, we start over.
+  //
+  template <typename H, typename T>
+  template <typename C, typename P>
+  boost::asio::awaitable<std::uint64_t> basic_download_manager<H, T>::
+  fetch (std::shared_ptr<task_type> task,
+         C& client,
+         const std::string& url,
+         std::optional<std::uint64_t> resume_from,
+         tracker* tr,
+         P& progress)
+  {
+    using byte_range = typename C::byte_range;
+
+    const auto& rq (task->request);
+
+    if (tr == nullptr)
+      co_return co_await client.download (url,
+                                          rq.target.string (),
+                                          progress,
+                                          resume_from,
+                                          rq.rate_limit_bytes_per_second);
+
+    download_hasher& h (tr->hasher);
+    const std::uint64_t size (tr->entry.size);
+
+    if (!rq.resume)
+    {
+      h.reset ();
+      tr->entry.etag.clear ();
+    }
+
+    for (;;)
+    {
+      // Make the target agree with the hasher. If it is shorter (say, a
+      // write didn't make it), what we hashed is of no use.
+      //
+      std::error_code ec;
+      std::uint64_t z (fs::file_size (rq.target, ec));
+
+      if (ec || z < h.size ())
+      {
+        h.reset ();
+        tr->entry.etag.clear ();
+      }
+      else if (z != h.size ())
+        fs::resize_file (rq.target, h.size ());
+
+      std::uint64_t off (h.size ());
+
+      if (off == size)
+        co_return off;
+
+      std::ofstream os (rq.target,
+                        std::ios::binary |
+                        (off != 0 ? std::ios::app : std::ios::trunc));
+
+      if (!os)
+        throw std::runtime_error ("failed to open file for writing");
+
+      bool first (true);
+      bool stale (false);
+
+      auto sink ([&] (const char* d, std::size_t n) -> bool
+      {
+        if (first)
+        {
+          first = false;
+
+          const std::string& e (client.last_etag ());
+
+          if (off != 0                 &&
+              !e.empty ()              &&
+              !tr->entry.etag.empty () &&
+              tr->entry.url == url     &&
+              e != tr->entry.etag)
+          {
+            stale = true;
+            return false;
+          }
+
+          tr->entry.url = url;
+          tr->entry.etag = e;
+        }
+
+        if (!os.write (d, static_cast<std::streamsize> (n)))
+          return false;
+
+        h.update (d, n);
+
+        if (std::chrono::steady_clock::now () - tr->saved >=
+            std::chrono::seconds (2))
+        {
+          if (!os.flush ())
+            return false;
+
+          checkpoint (*tr);
+        }
+
+        return true;
+      });
+
+      bool restart (false);
+
+      try
+      {
+        co_await client.stream (
+          url,
+          sink,
+          progress,
+          rq.rate_limit_bytes_per_second,
+          off != 0 ? std::optional<byte_range> (byte_range (off, size - 1))
+                   : std::nullopt);
+      }
+      catch (const std::exception& e)
+      {
+        os.flush ();
+
+        std::string s (e.what ());
+
+        if (off == 0 ||
+            (s.find ("416") == std::string::npos &&
+             s.find ("ignored range") == std::string::npos))
+        {
+          checkpoint (*tr);
+          throw;
+        }
+
+        restart = true;
+      }
+
+      os.close ();
+
+      if (restart || stale)
+      {
+        h.reset ();
+        tr->entry.etag.clear ();
+        continue;
+      }
+
+      if (!os)
+        throw std::runtime_error ("failed to write " + rq.target.string ());
+
+      co_return h.size ();
+    }
+  }
+
+  // Download with stall detection.
+  //
+  // The transfer races a watchdog (see await_stall()). If the watchdog wins,
+  // the transfer is cancelled and we resume from what made it to the target
+  // over a new connection. Note that every download_impl() call connects
+  // anew so there is no risk of picking up the same slow connection from
+  // the pool.
+  //
+  // We give up after a few restarts, letting the caller move on to the next
+  // mirror: at that point it is probably not the connection.
+  //
+  template <typename H, typename T>
+  template <typename C, typename P>
+  boost::asio::awaitable<std::uint64_t> basic_download_manager<H, T>::
+  download_watched (std::shared_ptr<task_type> task,
+                    C& client,
+                    const std::string& url,
+                    std::optional<std::uint64_t>& resume_from,
+                    tracker* tr,
+                    P& progress)
+  {
+    using namespace boost::asio::experimental;
+
+    const std::size_t max_restarts (3);
+
+    const auto& rq (task->request);
+
+    for (std::size_t r (0);; ++r)
+    {
+      std::uint64_t off (resume_from.value_or (0));
+      bool done (false);
+
+      auto transfer ([&] () -> boost::asio::awaitable<std::uint64_t>
+      {
+        try
+        {
+          auto p ([&] (std::uint64_t t, std::uint64_t tot)
+          {
+            off = t;
+            progress (t, tot);
+          });
+
+          std::uint64_t n (
+            co_await fetch (task, client, url, resume_from, tr, p));
+
+          done = true;
+          co_return n;
+        }
+        catch (...)
+        {
+          done = true;
+          throw;
+        }
+      });
+
+      auto ex (co_await boost::asio::this_coro::executor);
+
+      auto [ord, ex_t, n, ex_w] =
+        co_await make_parallel_group (
+          boost::asio::co_spawn (ex, transfer (), boost::asio::deferred),
+          boost::asio::co_spawn (
+            ex,
+            await_stall (off, done, stall_floor_, stall_window_, true),
+            boost::asio::deferred))
+        .async_wait (wait_for_one (), boost::asio::use_awaitable);
+
+      // Note that the watchdog may also notice that the transfer is over
+      // before we do.
+      //
+      if (ord[0] == 0 || ex_w)
+      {
+        if (ex_t)
+          std::rethrow_exception (ex_t);
+
+        co_return n;
+      }
+
+      if (task->should_cancel ())
+        throw std::runtime_error ("Download cancelled");
+
+      if (r == max_restarts)
+        throw std::runtime_error ("transfer stalled");
+
+      // Resume from what actually made it to the disk rather than what we
+      // were told about.
+      //
+      std::error_code ec;
+      std::uint64_t z (fs::file_size (rq.target, ec));
+
+      if (!ec && z != 0)
+        resume_from = z;
+      else
+        resume_from = std::nullopt;
+    }
+  }
+
+  // Download with hedging.
+  //
+  // The transfer from the i-th URL (the primary) is watched and, if its
+  // throughput stays below the floor for the hedging window, we request the
+  // rest of the file (from where the primary is at that point) from the
+  // next URL into a side file. Whichever finishes first wins and the other
+  // is cancelled. If it is the hedge, the target is cut back to where the
+  // hedge started and the side file appended.
+  //
+  // Note that the primary keeps going while we hedge so if it was only
+  // going through a rough patch it may well still win.
+  //
+  template <typename H, typename T>
+  template <typename C, typename P>
+  boost::asio::awaitable<std::uint64_t> basic_download_manager<H, T>::
+  download_hedged (std::shared_ptr<task_type> task,
+                   C& client,
+                   std::size_t i,
+                   std::optional<std::uint64_t> resume_from,
+                   P& progress)
+  {
+    using namespace std::chrono;
+    using namespace boost::asio::experimental;
+    using ms = mirror_ranking::duration;
+
+    const auto& rq (task->request);
+    const std::string& url (rq.urls[i]);
+    const std::string& alt (rq.urls[i + 1]);
+    const std::uint64_t size (*rq.expected_size);
+
+    fs::path part (rq.target);
+    part += ".hedge";
+
+    // State shared by the two transfers. Note that both run on our
+    // executor so there is no need to synchronize.
+    //
+    std::uint64_t off (resume_from.value_or (0)); // Primary offset.
+    std::uint64_t from (0);                       // Hedge start offset.
+    std::uint64_t got (0);                        // Hedge bytes.
+    bool done (false);                            // Primary is over.
+    bool lost (false);                            // Hedge finished first.
+
+    auto started (steady_clock::now ());
+    std::optional<steady_clock::time_point> first;
+
+    auto primary ([&] () -> boost::asio::awaitable<std::uint64_t>
+    {
+      try
+      {
+        std::uint64_t n (
+          co_await client.download (
+            url,
+            rq.target.string (),
+            [&] (std::uint64_t t, std::uint64_t tot)
+            {
+              // Don't let the loser keep writing if its cancellation didn't
+              // get through.
+              //
+              if (lost)
+                throw std::runtime_error ("overtaken by hedged transfer");
+
+              if (!first)
+                first = steady_clock::now ();
+
+              off = t;
+              progress (std::max (t, from + got), tot);
+            },
+            resume_from,
+            rq.rate_limit_bytes_per_second));
+
+        done = true;
+        co_return n;
+      }
+      catch (...)
+      {
+        done = true;
+        throw;
+      }
+    });
+
+    auto hedge ([&] () -> boost::asio::awaitable<std::uint64_t>
+    {
+      co_await await_stall (off, done, hedge_floor_, hedge_window_, false);
+
+      from = off;
+
+      if (from >= size)
+        throw std::runtime_error ("nothing left to hedge");
+
+      std::ofstream os (part, std::ios::binary | std::ios::trunc);
+      if (!os)
+        throw std::runtime_error ("failed to open file for writing: " +
+                                  part.string ());
+
+      basic_http_client<> hc (ioc_, client.session ().traits ());
+
+      auto hs (steady_clock::now ());
+      std::optional<steady_clock::time_point> hf;
+
+      try
+      {
+        std::uint64_t n (
+          co_await hc.stream (
+            alt,
+            [&] (const char* d, std::size_t n)
+            {
+              if (task->should_cancel ())
+                throw std::runtime_error ("Download cancelled");
+
+              if (!hf)
+                hf = steady_clock::now ();
+
+              os.write (d, static_cast<std::streamsize> (n));
+              got += n;
+
+              if (from + got > off)
+                progress (from + got, size);
+
+              return static_cast<bool> (os);
+            },
+            nullptr,
+            rq.rate_limit_bytes_per_second,
+            std::make_pair (from, size - 1)));
+
+        os.close ();
+
+        if (!os || n != size - from)
+          throw std::runtime_error ("short hedged response");
+
+        lost = true;
+
+        if (mirrors_ != nullptr && hf)
+          mirrors_->record (alt,
+                            n,
+                            duration_cast<ms> (steady_clock::now () - hs),
+                            duration_cast<ms> (*hf - hs));
+
+        co_return n;
+      }
+      catch (const std::exception&)
+      {
+        if (mirrors_ != nullptr && !task->should_cancel ())
+          mirrors_->fail (alt);
+
+        throw;
+      }
+    });
+
+    auto ex (co_await boost::asio::this_coro::executor);
+
+    auto [ord, ex_p, p, ex_h, h] =
+      co_await make_parallel_group (
+        boost::asio::co_spawn (ex, primary (), boost::asio::deferred),
+        boost::asio::co_spawn (ex, hedge (), boost::asio::deferred))
+      .async_wait (wait_for_one_success (), boost::asio::use_awaitable);
+
+    std::error_code ec;
+
+    // The primary won (or both did, but it was first).
+    //
+    if (!ex_p && (ex_h || ord[0] == 0))
+    {
+      fs::remove (part, ec);
+
+      if (mirrors_ != nullptr && first)
+      {
+        std::uint64_t n (p - std::min (p, resume_from.value_or (0)));
+
+        mirrors_->record (url,
+                          n,
+                          duration_cast<ms> (steady_clock::now () - started),
+                          duration_cast<ms> (*first - started));
+      }
+
+      co_return p;
+    }
+
+    // Neither did. The primary's failure is what the caller handles (and
+    // records).
+    //
+    if (ex_h)
+    {
+      fs::remove (part, ec);
+      std::rethrow_exception (ex_p);
+    }
+
+    // The hedge won so splice it onto the primary's prefix. The primary may
+    // have written past where the hedge started, so cut it back first.
+    //
+    if (mirrors_ != nullptr)
+      mirrors_->fail (url);
+
+    fs::resize_file (rq.target, from);
+
+    {
+      std::ifstream is (part, std::ios::binary);
+      std::ofstream os (rq.target, std::ios::binary | std::ios::app);
+
+      os << is.rdbuf ();
+      os.close ();
+
+      if (!is || !os)
+        throw std::runtime_error ("failed to splice hedged transfer into " +
+                                  rq.target.string ());
+    }
+
+    fs::remove (part, ec);
+
+    co_return size;
+  }
+
+  template <typename H, typename T>
+  template <typename C>
+  boost::asio::awaitable<std::uint64_t> basic_download_manager<H, T>::
+  download_delta (std::shared_ptr<task_type> task,
+                  C& client,
+                  const std::string& url,
+                  download_hasher& h)
+  {
+    const auto& rq (task->request);
+    const auto& cs (rq.chunks);
+
+    std::uint64_t total (0);
+    for (const auto& c : cs)
+      total += c.size;
+
+    // We assemble the new file next to the old one rather than truly in
+    // place: chunks may have moved, so overwriting the base as we go could
+    // clobber data that a later chunk still needs.
+    //
+    fs::path tmp (rq.target);
+    tmp += ".delta";
+
+    std::uint64_t done (0);
+    h.reset ();
+
+    try
+    {
+      std::ifstream is (rq.target, std::ios::binary);
+      if (!is)
+        throw std::runtime_error ("failed to open delta base: " +
+                                  rq.target.string ());
+
+      std::ofstream os (tmp, std::ios::binary | std::ios::trunc);
+      if (!os)
+        throw std::runtime_error ("failed to open file for writing: " +
+                                  tmp.string ());
+
+      std::vector<char> buf (64 * 1024);
+
+      for (std::size_t i (0); i != cs.size (); )
+      {
+        if (task->should_cancel ())
+          throw std::runtime_error ("Download cancelled");
+
+        const auto& c (cs[i]);
+
+        if (c.source)
+        {
+          is.seekg (static_cast<std::streamoff> (*c.source));
+
+          for (std::uint64_t n (c.size); n != 0; )
+          {
+            std::size_t m (static_cast<std::size_t> (
+              std::min<std::uint64_t> (n, buf.size ())));
+
+            if (!is.read (buf.data (), static_cast<std::streamsize> (m)))
+              throw std::runtime_error ("short read from delta base");
+
+            os.write (buf.data (), static_cast<std::streamsize> (m));
+            h.update (buf.data (), m);
+            n -= m;
+          }
+
+          done += c.size;
+          task->update_progress (done, total);
+
+          ++i;
+          continue;
+        }
+
+        // Coalesce a run of adjacent missing chunks into a single request.
+        // Since the chunks tile the file, the run is a contiguous range.
+        //
+        std::size_t j (i + 1);
+        while (j != cs.size () && !cs[j].source)
+          ++j;
+
+        std::uint64_t f (c.offset);
+        std::uint64_t l (cs[j - 1].offset + cs[j - 1].size - 1);
+
+        std::uint64_t n (
+          co_await client.stream (
+            url,
+            [&os, &h, &done, total, task] (const char* d, std::size_t n)
+            {
+              if (task->should_cancel ())
+                throw std::runtime_error ("Download cancelled");
+
+              os.write (d, static_cast<std::streamsize> (n));
+              h.update (d, n);
+
+              done += n;
+              task->update_progress (done, total);
+
+              return static_cast<bool> (os);
+            },
+            nullptr,
+            rq.rate_limit_bytes_per_second,
+            std::make_pair (f, l)));
+
+        if (n != l - f + 1)
+          throw std::runtime_error ("short range response");
+
+        i = j;
+      }
+
+      os.close ();
+      if (!os)
+        throw std::runtime_error ("failed to write file: " + tmp.string ());
+
+      is.close ();
+
+      std::error_code ec;
+      fs::rename (tmp, rq.target, ec);
+
+      if (ec)
+        throw std::runtime_error ("failed to replace " +
+                                  rq.target.string () + ": " + ec.message ());
+    }
+    catch (...)
+    {
+      std::error_code ec;
+      fs::remove (tmp, ec);
+      throw;
+    }
+
+    co_return total;
+  }
 }
@@ -0,0 +1,168 @@
+#include <launcher/download/download-mirror.hxx>
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+namespace launcher
+{
+  // Weight of the latest sample in the averages. High enough for a mirror
+  // that went bad to drop down within a few transfers.
+  //
+  static const double sample_weight (0.3);
+
+  static inline void
+  average (double& a, double v)
+  {
+    a = a == 0 ? v : a + sample_weight * (v - a);
+  }
+
+  string mirror_ranking::
+  key (const string& u)
+  {
+    string s ("http");
+    size_t p (0);
+
+    if (size_t n = u.find ("://"); n != string::npos)
+    {
+      s = u.substr (0, n);
+      p = n + 3;
+    }
+
+    string a (u.substr (p, u.find_first_of ("/?#", p) - p));
+
+    transform (s.begin (), s.end (), s.begin (), [] (unsigned char c)
+    {
+      return static_cast<char> (tolower (c));
+    });
+
+    transform (a.begin (), a.end (), a.begin (), [] (unsigned char c)
+    {
+      return static_cast<char> (tolower (c));
+    });
+
+    if (a.find (':') == string::npos)
+      a += s == "https" ? ":443" : ":80";
+
+    return s + "://" + a;
+  }
+
+  void mirror_ranking::
+  record (const string& u, uint64_t b, duration e, duration f)
+  {
+    stats& s (mirrors_[key (u)]);
+
+    // Clamp to a millisecond so that a transfer from a local cache doesn't
+    // divide by zero.
+    //
+    double ms (static_cast<double> (max<duration::rep> (e.count (), 1)));
+
+    average (s.throughput, static_cast<double> (b) * 1000 / ms);
+    average (s.latency, static_cast<double> (max<duration::rep> (f.count (), 1)));
+
+    s.samples++;
+    s.failures /= 2;
+  }
+
+  void mirror_ranking::
+  record (const string& u, duration f)
+  {
+    stats& s (mirrors_[key (u)]);
+    average (s.latency, static_cast<double> (max<duration::rep> (f.count (), 1)));
+  }
+
+  void mirror_ranking::
+  fail (const string& u)
+  {
+    mirrors_[key (u)].failures++;
+  }
+
+  const mirror_ranking::stats* mirror_ranking::
+  find (const string& u) const
+  {
+    auto i (mirrors_.find (key (u)));
+    return i != mirrors_.end () ? &i->second : nullptr;
+  }
+
+  bool mirror_ranking::
+  probe (const string& u)
+  {
+    string k (key (u));
+    return mirrors_.find (k) == mirrors_.end () && probing_.insert (k).second;
+  }
+
+  vector<string> mirror_ranking::
+  rank (vector<string> us) const
+  {
+    // Mirrors we have transferred from come first, fastest first, followed
+    // by those we only probed, quickest to respond first. Then those we know
+    // nothing about and, finally, those that only ever failed us.
+    //
+    auto order ([this] (const string& u) -> pair<int, double>
+    {
+      const stats* s (find (u));
+
+      if (s == nullptr)
+        return {2, 0};
+
+      double p (1.0 + s->failures);
+
+      if (s->samples != 0)
+        return {0, -s->throughput / p};
+
+      if (s->latency != 0)
+        return {1, s->latency * p};
+
+      return {3, static_cast<double> (s->failures)};
+    });
+
+    stable_sort (us.begin (), us.end (), [&order] (const auto& x,
+                                                   const auto& y)
+    {
+      return order (x) < order (y);
+    });
+
+    return us;
+  }
+
+  string mirror_ranking::
+  serialize () const
+  {
+    ostringstream os;
+
+    for (const auto& [k, s]: mirrors_)
+      os << k << ' '
+         << static_cast<uint64_t> (s.throughput) << ' '
+         << static_cast<uint64_t> (s.latency) << ' '
+         << s.samples << ' '
+         << s.failures << '\n';
+
+    return os.str ();
+  }
+
+  void mirror_ranking::
+  load (const string& v)
+  {
+    istringstream is (v);
+
+    for (string l; getline (is, l); )
+    {
+      istringstream ls (l);
+
+      string k;
+      uint64_t t, r;
+      stats s;
+
+      if (ls >> k >> t >> r >> s.samples >> s.failures)
+      {
+        s.throughput = static_cast<double> (t);
+        s.latency = static_cast<double> (r);
+
+        mirrors_[move (k)] = s;
+      }
+    }
+  }
+}
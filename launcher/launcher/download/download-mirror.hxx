@@ -0,0 +1,101 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace launcher
+{
+  // Observed mirror performance.
+  //
+  // Mirrors are identified by their origin (scheme://host:port) since that
+  // is what the performance depends on, not the resource. For each we keep
+  // exponentially weighted averages of the transfer throughput and the
+  // first-byte latency along with the failure count, and order the URLs of
+  // a request best first.
+  //
+  // The ranking is meant to outlive the run (see serialize() and load()) so
+  // that we start with the mirror that served us best last time rather than
+  // with whatever the manifest happens to list first.
+  //
+  class mirror_ranking
+  {
+  public:
+    using duration = std::chrono::milliseconds;
+
+    struct stats
+    {
+      double throughput = 0;       // Bytes per second, 0 if unknown.
+      double latency = 0;          // First byte in milliseconds, 0 if unknown.
+      std::uint32_t samples = 0;   // Completed transfers.
+      std::uint32_t failures = 0;  // Failed transfers and probes, decayed.
+    };
+
+    // Return the mirror (origin) of the URL.
+    //
+    static std::string
+    key (const std::string& url);
+
+    // Record a completed transfer of bytes that took elapsed in total, of
+    // which first_byte until the first byte arrived.
+    //
+    void
+    record (const std::string& url,
+            std::uint64_t bytes,
+            duration elapsed,
+            duration first_byte);
+
+    // Record the first-byte latency of a probe.
+    //
+    void
+    record (const std::string& url, duration first_byte);
+
+    // Record a failed transfer or probe.
+    //
+    void
+    fail (const std::string& url);
+
+    // Return the stats of the URL's mirror or NULL if we know nothing about
+    // it yet.
+    //
+    const stats*
+    find (const std::string& url) const;
+
+    // Return true if the URL's mirror is neither known nor being probed and
+    // mark it as being probed. This is how concurrent tasks sharing mirrors
+    // make sure each is only probed once.
+    //
+    bool
+    probe (const std::string& url);
+
+    // Return the URLs ordered best mirror first. The order is stable so
+    // mirrors we can't tell apart keep the order they came in.
+    //
+    std::vector<std::string>
+    rank (std::vector<std::string> urls) const;
+
+    // Persistence.
+    //
+    // One mirror per line: key, throughput, latency, samples, failures,
+    // separated with spaces. Load ignores lines it cannot parse.
+    //
+    std::string
+    serialize () const;
+
+    void
+    load (const std::string&);
+
+    bool
+    empty () const noexcept
+    {
+      return mirrors_.empty ();
+    }
+
+  private:
+    std::map<std::string, stats> mirrors_;
+    std::set<std::string> probing_;
+  };
+}
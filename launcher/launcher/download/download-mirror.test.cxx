@@ -0,0 +1,106 @@
+#include <launcher/download/download-mirror.hxx>
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace launcher;
+
+using ms = mirror_ranking::duration;
+
+static const vector<string> us {
+  "https://a/1", "https://b/1", "https://c/1", "https://d/1"};
+
+// The ranking of us after ranked() below.
+//
+static const vector<string> order {
+  "https://c/1", "https://a/1", "https://b/1", "https://d/1"};
+
+// One mirror of each kind: two transferred from (c faster than a), one
+// probed (b), and one failed (d).
+//
+static mirror_ranking
+ranked ()
+{
+  mirror_ranking r;
+  r.record ("https://c/2", 1000000, ms (1000), ms (10));
+  r.record ("https://a/2", 100000, ms (1000), ms (10));
+  r.record ("https://b/2", ms (50));
+  r.fail ("https://d/2");
+  return r;
+}
+
+// Mirrors are keyed by origin with the default port spelled out.
+//
+static void
+test_key ()
+{
+  assert (mirror_ranking::key ("HTTPS://A.com/x/y?z") == "https://a.com:443");
+  assert (mirror_ranking::key ("http://b:8080") == "http://b:8080");
+  assert (mirror_ranking::key ("c/d") == "http://c:80");
+}
+
+// Transferred from, fastest first, then probed, then unknown, then failed.
+// With nothing known, nothing changes.
+//
+static void
+test_rank ()
+{
+  assert (mirror_ranking ().rank (us) == us);
+
+  mirror_ranking r (ranked ());
+  assert (r.rank (us) == order);
+
+  vector<string> e {"https://c/1", "https://e/1", "https://d/1"};
+  assert (r.rank ({"https://d/1", "https://e/1", "https://c/1"}) == e);
+}
+
+// Failures push a mirror down even if it used to be fast.
+//
+static void
+test_fail ()
+{
+  mirror_ranking r;
+  r.record ("https://a/", 1000, ms (1000), ms (10));
+  r.record ("https://b/", 800, ms (1000), ms (10));
+  r.fail ("https://a/");
+
+  assert (r.rank ({"https://a/", "https://b/"}).front () == "https://b/");
+}
+
+// Each unknown mirror is probed once.
+//
+static void
+test_probe ()
+{
+  mirror_ranking r (ranked ());
+
+  assert (r.probe ("https://e/1"));
+  assert (!r.probe ("https://e/2"));
+  assert (!r.probe ("https://a/1"));
+}
+
+// Round trip, skipping garbage.
+//
+static void
+test_serialize ()
+{
+  mirror_ranking l;
+  l.load (ranked ().serialize () + "garbage\n\nhttps://x:443 1\n");
+
+  assert (l.rank (us) == order);
+  assert (l.find ("https://c/") != nullptr);
+  assert (l.find ("https://c/")->samples == 1);
+  assert (l.find ("https://x/") == nullptr);
+}
+
+int
+main ()
+{
+  test_key ();
+  test_rank ();
+  test_fail ();
+  test_probe ();
+  test_serialize ();
+}
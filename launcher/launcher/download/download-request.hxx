@@ -4,8 +4,11 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
+#include <functional>
 #include <filesystem>
 
+#include <launcher/manifest/manifest-digest.hxx>
+
 #include <launcher/download/download-types.hxx>
 
 namespace launcher
@@ -48,6 +51,39 @@ namespace launcher
     //
     std::uint64_t rate_limit_bytes_per_second {0};
 
+    // Optional body sink.
+    //
+    // If set, the response body is handed to the sink as it arrives and
+    // nothing is written to target (which then only names the request).
+    // Returning false stops the transfer. Resume and mirror fallback are
+    // disabled in this mode since the sink cannot rewind.
+    //
+    std::function<bool (const char*, std::size_t)> sink;
+
+    // Optional delta plan, in target order.
+    //
+    // If set, the target is rebuilt next to the existing copy from local
+    // chunks and Range requests for the missing ones, then swapped in. On
+    // failure we fall back to a full download.
+    //
+    std::vector<download_chunk> chunks;
+
+    // Optional expected BLAKE3 digest of the result.
+    //
+    // If set, the result is checked against it once the transfer completes
+    // and expected_size (if any) checks out, with a mismatch failing the
+    // attempt with download_outcome::hash_mismatch. The bytes are hashed as
+    // they are written (see basic_download_manager::set_journal()) so this
+    // normally costs no extra read. Not checked with a sink since then
+    // there is nothing at the target to check.
+    //
+    // Requests with the same digest are also taken to produce the same
+    // bytes, as are requests for the same URL (without a sink). Such
+    // requests are only downloaded once and the other targets cloned from
+    // the result (see basic_download_manager::add_task()).
+    //
+    blake3_digest content;
+
     // Request metadata.
     //
     string_type name;        // Human-readable name
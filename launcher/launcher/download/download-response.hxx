@@ -27,6 +27,10 @@ namespace launcher
     //
     std::optional<download_error> error;
 
+    // Outcome of the last attempt.
+    //
+    download_outcome outcome {download_outcome::none};
+
     // Timing information.
     //
     time_point start_time;
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <utility>
 #include <ostream>
+#include <optional>
 #include <filesystem>
 
 namespace launcher
@@ -37,6 +38,38 @@ namespace launcher
     return os;
   }
 
+  // Download outcome.
+  //
+  // Why a task ended up where it did. This is what the caller needs to
+  // decide whether and how to retry without going back to the disk.
+  //
+  enum class download_outcome
+  {
+    none,          // Not finished yet
+    ok,            // Transferred and passed the checks
+    transfer,      // Connection or I/O failure
+    http_status,   // Server responded with an error status
+    size_mismatch, // Result is not of the expected size
+    hash_mismatch, // Result failed verification
+    cancelled      // Cancelled by user
+  };
+
+  inline std::ostream&
+  operator<< (std::ostream& os, download_outcome o)
+  {
+    switch (o)
+    {
+    case download_outcome::none:          return os << "none";
+    case download_outcome::ok:            return os << "ok";
+    case download_outcome::transfer:      return os << "transfer";
+    case download_outcome::http_status:   return os << "http status";
+    case download_outcome::size_mismatch: return os << "size mismatch";
+    case download_outcome::hash_mismatch: return os << "hash mismatch";
+    case download_outcome::cancelled:     return os << "cancelled";
+    }
+    return os;
+  }
+
   // Download priority enumeration.
   //
   enum class download_priority
@@ -60,6 +93,29 @@ namespace launcher
     return os;
   }
 
+  // Download scheduling policy.
+  //
+  // The order in which the tasks of the same priority are started.
+  //
+  enum class download_schedule
+  {
+    fifo,          // In the order they were added
+    largest_first, // Biggest transfer first, to finish the batch soonest
+    smallest_first // Smallest transfer first, to finish most files soonest
+  };
+
+  inline std::ostream&
+  operator<< (std::ostream& os, download_schedule s)
+  {
+    switch (s)
+    {
+      case download_schedule::fifo:           return os << "fifo";
+      case download_schedule::largest_first:  return os << "largest first";
+      case download_schedule::smallest_first: return os << "smallest first";
+    }
+    return os;
+  }
+
   // Download progress information.
   //
   struct download_progress
@@ -95,6 +151,18 @@ namespace launcher
               << " (" << p.progress_percent << "%)";
   }
 
+  // Delta download chunk.
+  //
+  // A piece of the target at offset. If source is set, the bytes are taken
+  // from the existing target at that offset. Otherwise they are fetched.
+  //
+  struct download_chunk
+  {
+    std::uint64_t offset {0};
+    std::uint64_t size {0};
+    std::optional<std::uint64_t> source;
+  };
+
   // Download error information.
   //
   struct download_error
@@ -4,6 +4,9 @@
 #include <launcher/download/download-request.hxx>
 #include <launcher/download/download-response.hxx>
 #include <launcher/download/download-task.hxx>
+#include <launcher/download/download-mirror.hxx>
+#include <launcher/download/download-clone.hxx>
+#include <launcher/download/download-journal.hxx>
 #include <launcher/download/download-manager.hxx>
 
 namespace launcher
@@ -12,6 +15,7 @@ namespace launcher
   {
     using launcher::download_state;
     using launcher::download_priority;
+    using launcher::download_schedule;
     using launcher::download_progress;
     using launcher::download_error;
 
@@ -19,6 +23,8 @@ namespace launcher
     using launcher::download_response;
     using launcher::download_task;
     using launcher::download_manager;
+    using launcher::mirror_ranking;
+    using launcher::download_journal;
 
     using launcher::make_download_task;
   }
@@ -432,37 +432,71 @@ namespace launcher
       obj["body"] = r.body;
     obj["draft"] = r.draft;
     obj["prerelease"] = r.prerelease;
+    if (!r.node_id.empty ())
+      obj["node_id"] = r.node_id;
+    if (!r.target_commitish.empty ())
+      obj["target_commitish"] = r.target_commitish;
+    if (!r.author.login.empty ())
+      obj["author"] = to_json (r.author);
+    if (!r.html_url.empty ())
+      obj["html_url"] = r.html_url;
+    if (!r.tarball_url.empty ())
+      obj["tarball_url"] = r.tarball_url;
+    if (!r.zipball_url.empty ())
+      obj["zipball_url"] = r.zipball_url;
+
+    // Include the assets so that the result can be fed back to
+    // parse_release() (see the release metadata cache in the launcher).
+    //
+    json::array as;
+    for (const auto& a : r.assets)
+      as.push_back (to_json (a));
+    obj["assets"] = move (as);
+
     return obj;
   }
 
+  json::value github_api_traits::
+  to_json (const asset_type& a)
+  {
+    json::object obj;
+    obj["id"] = a.id;
+    obj["name"] = a.name;
+    if (!a.node_id.empty ())
+      obj["node_id"] = a.node_id;
+    if (!a.label.empty ())
+      obj["label"] = a.label;
+    if (!a.content_type.empty ())
+      obj["content_type"] = a.content_type;
+    if (!a.state.empty ())
+      obj["state"] = a.state;
+    obj["size"] = a.size;
+    obj["download_count"] = a.download_count;
+    obj["browser_download_url"] = a.browser_download_url;
+    if (!a.url.empty ())
+      obj["url"] = a.url;
+    return obj;
+  }
+
+  // FIXME: SSL certificate verification is currently disabled (see
+  // http_client_traits::verify_ssl) due to unresolved handshake errors. This
+  // needs to be investigated and corrected before it can be re-enabled.
+  //
   template <typename T> github_api<T>::
   github_api (asio::io_context& ioc)
     : ioc_ (ioc),
-      ssl_ctx_ (ssl::context::tlsv12_client)
+      client_ (ioc),
+      http_ (&client_)
   {
-    // FIXME: SSL is currently disabled due to unresolved handshake errors. This
-    // needs to be investigated and corrected before SSL can be re-enabled.
-    //
-    ssl_ctx_.set_default_verify_paths ();
-    ssl_ctx_.set_verify_mode (ssl::verify_none);
-    ssl_ctx_.set_options (ssl::context::default_workarounds |
-                          ssl::context::no_sslv2 |
-                          ssl::context::no_sslv3 |
-                          ssl::context::single_dh_use);
   }
 
   template <typename T> github_api<T>::
   github_api (asio::io_context& ioc, string token)
     : ioc_ (ioc),
-      ssl_ctx_ (ssl::context::tlsv12_client),
+      client_ (ioc),
+      http_ (&client_),
       token_ (move (token))
   {
-    ssl_ctx_.set_default_verify_paths ();
-    ssl_ctx_.set_verify_mode (ssl::verify_none);
-    ssl_ctx_.set_options (ssl::context::default_workarounds |
-                          ssl::context::no_sslv2 |
-                          ssl::context::no_sslv3 |
-                          ssl::context::single_dh_use);
   }
 
   template <typename T> void github_api<T>::
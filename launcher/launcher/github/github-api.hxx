@@ -13,6 +13,9 @@
 #include <launcher/github/github-endpoint.hxx>
 #include <launcher/github/github-request.hxx>
 
+#include <launcher/http/http-cache.hxx>
+#include <launcher/http/http-client.hxx>
+
 namespace launcher
 {
   namespace asio = boost::asio;
@@ -67,10 +70,13 @@ namespace launcher
 
   // GitHub API response.
   //
+  // Note that the body is parsed as JSON while it is being received. It is
+  // null if there was none or it wasn't JSON.
+  //
   struct github_response
   {
     unsigned status_code;
-    std::string body;
+    json::value body;
     std::map<std::string, std::string> headers;
     std::optional<std::string> error_message;
     std::optional<github_rate_limit> rate_limit;
@@ -79,7 +85,7 @@ namespace launcher
     success () const {return status_code >= 200 && status_code < 300;}
 
     bool
-    empty () const {return body.empty ();}
+    empty () const {return body.is_null ();}
 
     bool
     is_rate_limited () const {return status_code == 403 || status_code == 429;}
@@ -158,6 +164,9 @@ namespace launcher
     static json::value
     to_json (const release_type& r);
 
+    static json::value
+    to_json (const asset_type& a);
+
     // Default User-Agent header.
     //
     static std::string
@@ -225,6 +234,22 @@ namespace launcher
       progress_callback_ = std::move (callback);
     }
 
+    // Set the cache to make GET requests conditional on. If null (default),
+    // every request is a full one.
+    //
+    void
+    set_http_cache (http_cache* cache) {cache_ = cache;}
+
+    // Set the HTTP client to send requests over. This way several API
+    // instances can share the client's pooled connections to the API host.
+    // If null, we go back to our own client.
+    //
+    void
+    set_http_client (http_client* c) {http_ = c != nullptr ? c : &client_;}
+
+    http_client&
+    client () noexcept {return *http_;}
+
     // Execute generic request.
     //
     asio::awaitable<response_type>
@@ -307,17 +332,18 @@ namespace launcher
 
   private:
     asio::io_context& ioc_;
-    ssl::context ssl_ctx_;
+    http_client client_;
+    http_client* http_;
     std::optional<std::string> token_;
     std::optional<github_rate_limit> last_rate_limit_;
     progress_callback_type progress_callback_;
+    http_cache* cache_ = nullptr;
 
     // Internal HTTP operations.
     //
     asio::awaitable<response_type>
-    perform_request (const std::string& host,
-                     const std::string& target,
-                     http::verb method,
+    perform_request (const std::string& url,
+                     http_method method,
                      const std::map<std::string, std::string>& headers,
                      const std::optional<std::string>& body = std::nullopt);
 
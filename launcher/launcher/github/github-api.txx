@@ -23,23 +23,49 @@ namespace launcher
     if (target.find (prefix) == 0)
       target = target.substr (prefix.length ());
 
+    url = "https://" + host + target;
+
     std::map<std::string, std::string> headers (request.headers);
     add_default_headers (headers);
 
     if (request.token)
       headers["Authorization"] = "Bearer " + *request.token;
 
-    http::verb verb (http::verb::get);
+    http_method method (http_method::get);
     switch (request.method)
     {
-      case request_type::method_type::get:     verb = http::verb::get;     break;
-      case request_type::method_type::post:    verb = http::verb::post;    break;
-      case request_type::method_type::put:     verb = http::verb::put;     break;
-      case request_type::method_type::patch:   verb = http::verb::patch;   break;
-      case request_type::method_type::delete_: verb = http::verb::delete_; break;
+      case request_type::method_type::get:     method = http_method::get;     break;
+      case request_type::method_type::post:    method = http_method::post;    break;
+      case request_type::method_type::put:     method = http_method::put;     break;
+      case request_type::method_type::patch:   method = http_method::patch;   break;
+      case request_type::method_type::delete_: method = http_method::delete_; break;
     }
 
-    response_type resp (co_await perform_request (host, target, verb, headers, request.body));
+    // Make a GET conditional on the response we have cached, if any. Note
+    // that the token is part of the key since it can change what we get to
+    // see.
+    //
+    bool conditional (cache_ != nullptr && method == http_method::get);
+
+    std::string key;
+    std::optional<http_cache::entry> cached;
+
+    if (conditional)
+    {
+      key = url + (request.token ? " (token)" : "");
+      cached = cache_->load (key);
+
+      if (cached)
+      {
+        if (!cached->etag.empty ())
+          headers["If-None-Match"] = cached->etag;
+
+        if (!cached->last_modified.empty ())
+          headers["If-Modified-Since"] = cached->last_modified;
+      }
+    }
+
+    response_type resp (co_await perform_request (url, method, headers, request.body));
 
     // If we hit a wall, we might need to retry. This is tricky because there
     // are two types of limits: the standard quota (X-RateLimit-*) and the
@@ -88,7 +114,34 @@ namespace launcher
         co_await handle_rate_limit (rl);
       }
 
-      resp = co_await perform_request (host, target, verb, headers, request.body);
+      resp = co_await perform_request (url, method, headers, request.body);
+    }
+
+    // Serve 304 Not Modified from the cache and remember anything else we
+    // can make the next request conditional on.
+    //
+    if (conditional)
+    {
+      if (resp.status_code == 304 && cached)
+      {
+        resp.status_code = 200;
+        resp.body = json::parse (cached->body);
+        resp.error_message = std::nullopt;
+      }
+      else if (resp.success ())
+      {
+        http_cache::entry e;
+
+        if (auto i (resp.headers.find ("etag")); i != resp.headers.end ())
+          e.etag = i->second;
+
+        if (auto i (resp.headers.find ("last-modified"));
+            i != resp.headers.end ())
+          e.last_modified = i->second;
+
+        e.body = json::serialize (resp.body);
+        cache_->save (key, e);
+      }
     }
 
     co_return resp;
@@ -97,63 +150,74 @@ namespace launcher
   template <typename T>
   asio::awaitable<typename github_api<T>::response_type>
   github_api<T>::
-  perform_request (const std::string& host,
-                   const std::string& target,
-                   http::verb method,
+  perform_request (const std::string& url,
+                   http_method method,
                    const std::map<std::string, std::string>& headers,
                    const std::optional<std::string>& body)
   {
-    using tcp = asio::ip::tcp;
-
     response_type resp;
 
     try
     {
-      tcp::resolver resolver (ioc_);
-      auto const results (co_await resolver.async_resolve (
-          host, "443", asio::use_awaitable));
+      // Go through the HTTP client so that consecutive requests reuse its
+      // pooled keep-alive connection to the API host rather than each doing
+      // its own connect and TLS handshake.
+      //
+      http_request req (method, url);
 
-      asio::ssl::stream<beast::tcp_stream> stream (ioc_, ssl_ctx_);
+      for (const auto& [key, value] : headers)
+        req.set_header (key, value);
 
-      if (!SSL_set_tlsext_host_name (stream.native_handle (), host.c_str ()))
-      {
-        beast::error_code ec {static_cast<int> (::ERR_get_error ()),
-                              asio::error::get_ssl_category ()};
-        throw beast::system_error {ec};
-      }
+      if (body)
+        req.set_body (*body);
 
-      beast::get_lowest_layer (stream).expires_after (std::chrono::seconds (30));
-      co_await beast::get_lowest_layer (stream).async_connect (
-          results, asio::use_awaitable);
+      req.normalize ();
 
-      co_await stream.async_handshake (ssl::stream_base::client, asio::use_awaitable);
+      // Parse the body as it arrives instead of buffering it first. If it
+      // turns out not to be JSON, skip the rest.
+      //
+      json::stream_parser p;
+      bool bad (false);
 
-      http::request<http::string_body> req {method, target, 11};
-      req.set (http::field::host, host);
+      http_response res (
+        co_await http_->request (req, [&p, &bad] (const char* d, std::size_t n)
+        {
+          json::error_code ec;
+          p.write (d, n, ec);
 
-      for (const auto& [key, value] : headers)
-        req.set (key, value);
+          if (ec)
+            bad = true;
 
-      if (body)
-      {
-        req.body () = *body;
-        req.prepare_payload ();
-      }
+          return !bad;
+        }));
 
-      beast::get_lowest_layer (stream).expires_after (std::chrono::seconds (30));
-      co_await http::async_write (stream, req, asio::use_awaitable);
+      resp.status_code = res.status_code ();
 
-      beast::flat_buffer buffer;
-      http::response<http::string_body> res;
+      // Only the body of a successful response goes to the sink. That of
+      // any other (normally an error message) comes back in the response.
+      //
+      if (res.body)
+      {
+        json::error_code ec;
+        json::value v (json::parse (*res.body, ec));
 
-      co_await http::async_read (stream, buffer, res, asio::use_awaitable);
+        if (!ec)
+          resp.body = std::move (v);
+      }
+      else if (!bad)
+      {
+        // Note that this fails if there was no body at all.
+        //
+        json::error_code ec;
+        p.finish (ec);
 
-      resp.status_code = res.result_int ();
-      resp.body = res.body ();
+        if (!ec)
+          resp.body = p.release ();
+      }
 
-      for (const auto& field : res)
+      for (const auto& field : res.headers)
       {
-        std::string n (field.name_string ());
+        std::string n (field.name);
         std::transform (n.begin (),
                         n.end (),
                         n.begin (),
@@ -162,7 +226,7 @@ namespace launcher
           return std::tolower (c);
         });
 
-        resp.headers[std::move (n)] = std::string (field.value ());
+        resp.headers[std::move (n)] = field.value;
       }
 
       // Extract rate limit information from response headers.
@@ -173,29 +237,16 @@ namespace launcher
 
       if (!resp.success ())
       {
-        try
-        {
-          json::value jv (json::parse (resp.body));
-          if (jv.is_object () && jv.as_object ().contains ("message"))
-            resp.error_message = json::value_to<std::string> (jv.as_object ().at ("message"));
-        }
-        catch (...)
-        {
+        const json::value& jv (resp.body);
+
+        if (jv.is_null ())
           resp.error_message = "HTTP error: " + std::to_string (resp.status_code);
+        else if (const json::object* o = jv.if_object ())
+        {
+          if (auto i (o->find ("message")); i != o->end () && i->value ().is_string ())
+            resp.error_message = std::string (i->value ().as_string ());
         }
       }
-
-      beast::get_lowest_layer (stream).expires_after (std::chrono::seconds (30));
-      beast::error_code ec;
-      co_await stream.async_shutdown (asio::redirect_error (asio::use_awaitable, ec));
-
-      // Ignore "short read" errors during shutdown.
-      //
-      if (ec == asio::error::eof || ec == ssl::error::stream_truncated)
-        ec = {};
-
-      if (ec)
-        throw beast::system_error {ec};
     }
     catch (const boost::system::system_error& e)
     {
@@ -226,8 +277,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get repository"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_repository (jv);
+    co_return traits_type::parse_repository (resp.body);
   }
 
   template <typename T>
@@ -248,8 +298,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get releases"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_releases (jv);
+    co_return traits_type::parse_releases (resp.body);
   }
 
   template <typename T>
@@ -265,8 +314,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get latest release"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_release (jv);
+    co_return traits_type::parse_release (resp.body);
   }
 
   template <typename T>
@@ -284,8 +332,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get release by tag"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_release (jv);
+    co_return traits_type::parse_release (resp.body);
   }
 
   template <typename T>
@@ -303,8 +350,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get release by ID"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_release (jv);
+    co_return traits_type::parse_release (resp.body);
   }
 
   template <typename T>
@@ -325,8 +371,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get commits"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_commits (jv);
+    co_return traits_type::parse_commits (resp.body);
   }
 
   template <typename T>
@@ -344,8 +389,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get commit"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_commit (jv);
+    co_return traits_type::parse_commit (resp.body);
   }
 
   template <typename T>
@@ -361,8 +405,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get branches"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_branches (jv);
+    co_return traits_type::parse_branches (resp.body);
   }
 
   template <typename T>
@@ -380,8 +423,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get branch"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_branch (jv);
+    co_return traits_type::parse_branch (resp.body);
   }
 
   template <typename T>
@@ -397,8 +439,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get tags"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_tags (jv);
+    co_return traits_type::parse_tags (resp.body);
   }
 
   template <typename T>
@@ -419,8 +460,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get issues"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_issues (jv);
+    co_return traits_type::parse_issues (resp.body);
   }
 
   template <typename T>
@@ -438,8 +478,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get issue"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_issue (jv);
+    co_return traits_type::parse_issue (resp.body);
   }
 
   template <typename T>
@@ -455,8 +494,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get user"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_user (jv);
+    co_return traits_type::parse_user (resp.body);
   }
 
   template <typename T>
@@ -472,8 +510,7 @@ namespace launcher
     if (!resp.success ())
       throw std::runtime_error (resp.error_message.value_or ("Unable to get authenticated user"));
 
-    json::value jv (json::parse (resp.body));
-    co_return traits_type::parse_user (jv);
+    co_return traits_type::parse_user (resp.body);
   }
 
   template <typename T>
@@ -0,0 +1,212 @@
+#include <launcher/http/http-cache.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <launcher/blake3.h>
+#include <launcher/launcher-log.hxx>
+#include <launcher/manifest/manifest-digest.hxx>
+
+using namespace std;
+
+namespace launcher
+{
+  static const char entry_magic[8] = {'I', 'W', '4', 'X', 'H', 'T', 'T', 'P'};
+  static const uint32_t entry_version (1);
+
+  static const size_t header_size (28);
+
+  static const char* const entry_ext (".response");
+
+  // Little-endian helpers.
+  //
+  static inline void
+  put (string& b, uint64_t v, size_t n)
+  {
+    for (size_t i (0); i != n; ++i)
+      b.push_back (static_cast<char> (v >> (i * 8)));
+  }
+
+  static inline uint64_t
+  get (const char* d, size_t n)
+  {
+    uint64_t r (0);
+    for (size_t i (0); i != n; ++i)
+      r |= static_cast<uint64_t> (static_cast<unsigned char> (d[i])) << (i * 8);
+    return r;
+  }
+
+  http_cache::
+  http_cache (fs::path d, size_t c)
+    : dir_ (move (d)), capacity_ (c)
+  {
+  }
+
+  const fs::path& http_cache::
+  directory () const noexcept
+  {
+    return dir_;
+  }
+
+  fs::path http_cache::
+  path (const string& k) const
+  {
+    // Keys are URLs, so name the entry after the key's hash.
+    //
+    blake3_digest o;
+
+    blake3_hasher h;
+    blake3_hasher_init (&h);
+    blake3_hasher_update (&h, k.data (), k.size ());
+    blake3_hasher_finalize (&h, o.data (), o.size ());
+
+    return dir_ / (o.hex ().substr (0, 32) + entry_ext);
+  }
+
+  optional<http_cache::entry> http_cache::
+  load (const string& k) const
+  {
+    fs::path p (path (k));
+
+    error_code ec;
+    if (!fs::exists (p, ec))
+      return nullopt;
+
+    string b;
+    {
+      ifstream ifs (p, ios::binary);
+      if (ifs)
+        b.assign (istreambuf_iterator<char> (ifs), istreambuf_iterator<char> ());
+    }
+
+    auto bad ([&p, &ec] ()
+    {
+      launcher::log::warning (categories::http{}, "discarding unusable http cache entry {}", p.string ());
+      fs::remove (p, ec);
+      return nullopt;
+    });
+
+    if (b.size () < header_size ||
+        memcmp (b.data (), entry_magic, sizeof (entry_magic)) != 0 ||
+        get (b.data () + 8, 4) != entry_version)
+      return bad ();
+
+    uint64_t en (get (b.data () + 12, 4));
+    uint64_t ln (get (b.data () + 16, 4));
+    uint64_t bn (get (b.data () + 20, 8));
+
+    if (b.size () - header_size != en + ln + bn)
+      return bad ();
+
+    const char* d (b.data () + header_size);
+
+    entry r;
+    r.etag.assign (d, en);
+    r.last_modified.assign (d + en, ln);
+    r.body.assign (d + en + ln, bn);
+
+    launcher::log::trace_l3 (categories::http{}, "http cache hit for {}", k);
+    return r;
+  }
+
+  void http_cache::
+  save (const string& k, const entry& e)
+  {
+    if (!e.validated ())
+      return;
+
+    fs::path p (path (k));
+    fs::path t (p.string () + ".tmp");
+
+    try
+    {
+      string b;
+      b.reserve (header_size +
+                 e.etag.size () + e.last_modified.size () + e.body.size ());
+
+      b.append (entry_magic, sizeof (entry_magic));
+      put (b, entry_version, 4);
+      put (b, e.etag.size (), 4);
+      put (b, e.last_modified.size (), 4);
+      put (b, e.body.size (), 8);
+
+      b += e.etag;
+      b += e.last_modified;
+      b += e.body;
+
+      error_code ec;
+      fs::create_directories (dir_, ec);
+
+      {
+        ofstream ofs (t, ios::binary | ios::trunc);
+        ofs.write (b.data (), static_cast<streamsize> (b.size ()));
+
+        if (!ofs)
+          throw runtime_error ("failed to write " + t.string ());
+      }
+
+      fs::rename (t, p, ec);
+      if (ec)
+      {
+        fs::remove (p, ec);
+        fs::rename (t, p);
+      }
+
+      launcher::log::trace_l2 (categories::http{}, "cached response for {} ({} bytes)", k, e.body.size ());
+    }
+    catch (const exception& x)
+    {
+      launcher::log::warning (categories::http{}, "failed to cache response for {}: {}", k, x.what ());
+
+      error_code ec;
+      fs::remove (t, ec);
+      return;
+    }
+
+    evict ();
+  }
+
+  void http_cache::
+  remove (const string& k)
+  {
+    error_code ec;
+    fs::remove (path (k), ec);
+  }
+
+  void http_cache::
+  evict () const
+  {
+    error_code ec;
+    vector<pair<fs::file_time_type, fs::path>> es;
+
+    for (fs::directory_iterator i (dir_, ec), e; !ec && i != e; i.increment (ec))
+    {
+      if (i->path ().extension () != entry_ext)
+        continue;
+
+      fs::file_time_type t (fs::last_write_time (i->path (), ec));
+      if (!ec)
+        es.emplace_back (t, i->path ());
+    }
+
+    if (es.size () <= capacity_)
+      return;
+
+    sort (es.begin (), es.end (), [] (const auto& x, const auto& y)
+    {
+      return x.first > y.first;
+    });
+
+    for (size_t i (capacity_); i != es.size (); ++i)
+    {
+      launcher::log::trace_l3 (categories::http{}, "evicting http cache entry {}", es[i].second.string ());
+      fs::remove (es[i].second, ec);
+    }
+  }
+}
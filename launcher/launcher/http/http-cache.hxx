@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <optional>
+#include <filesystem>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // On-disk cache of HTTP responses for conditional requests.
+  //
+  // Most of what we GET on every launch (release JSON, update.json) hardly
+  // ever changes. So we keep the last body along with its validators (ETag,
+  // Last-Modified) and send them back as If-None-Match/If-Modified-Since. If
+  // the server answers 304 Not Modified, the body is served from here. Note
+  // that with the GitHub API such a request also doesn't count against the
+  // rate limit.
+  //
+  // Each entry is a file named after the key's hash. All integers are
+  // little-endian:
+  //
+  // "IW4XHTTP", u32 version, u32 etag size, u32 last-modified size,
+  // u64 body size, followed by the etag, last-modified, and body bytes.
+  //
+  class http_cache
+  {
+  public:
+    struct entry
+    {
+      std::string etag;
+      std::string last_modified;
+      std::string body;
+
+      // True if there is something to make the request conditional on.
+      //
+      bool
+      validated () const noexcept
+      {
+        return !etag.empty () || !last_modified.empty ();
+      }
+    };
+
+    // Keep at most capacity entries, evicting the least recently written.
+    //
+    explicit
+    http_cache (fs::path directory, std::size_t capacity = 64);
+
+    http_cache (const http_cache&) = delete;
+    http_cache& operator= (const http_cache&) = delete;
+
+    // Return the cached entry or nullopt if there is none (or it is
+    // unusable, in which case it is removed).
+    //
+    std::optional<entry>
+    load (const std::string& key) const;
+
+    // Store the entry unless it has no validators. This is best-effort:
+    // failures are logged and otherwise ignored since all it costs us is a
+    // full request next time.
+    //
+    void
+    save (const std::string& key, const entry&);
+
+    // Drop the entry, if any.
+    //
+    void
+    remove (const std::string& key);
+
+    const fs::path&
+    directory () const noexcept;
+
+  private:
+    fs::path
+    path (const std::string& key) const;
+
+    void
+    evict () const;
+
+    fs::path dir_;
+    std::size_t capacity_;
+  };
+}
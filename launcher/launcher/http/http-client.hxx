@@ -1,10 +1,13 @@
 #pragma once
 
+#include <map>
 #include <string>
 #include <memory>
 #include <functional>
 #include <cstdint>
 #include <chrono>
+#include <utility>
+#include <stdexcept>
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
@@ -13,6 +16,7 @@
 #include <optional>
 
 #include <launcher/http/http-types.hxx>
+#include <launcher/http/http-decoder.hxx>
 #include <launcher/http/http-request.hxx>
 #include <launcher/http/http-response.hxx>
 
@@ -62,11 +66,33 @@ namespace launcher
     // Whether to keep connections alive.
     //
     bool keep_alive = true;
+
+    // Whether to ask for gzip/deflate compressed responses and decode them
+    // on the fly. Only applies to requests: downloads are normally already
+    // compressed and are resumed and ranged by byte offsets, which would
+    // then refer to the encoded body.
+    //
+    bool decode_content = true;
+
+    // Maximum number of idle connections to keep per host.
+    //
+    std::size_t max_idle = 4;
+
+    // Time in milliseconds after which an idle connection is no longer
+    // reused. Servers close them on their end sooner or later.
+    //
+    std::uint32_t idle_timeout = 30000;
   };
 
   // HTTP client session context.
   //
-  // Manages connection state and reuse for a specific host.
+  // Manages connection state and reuse. That is, once a response has been
+  // read off a keep-alive connection, it is returned to the session and
+  // taken by the next request to the same host and port, sparing it the
+  // connect and TLS handshake.
+  //
+  // Note that only one request at a time goes over a connection (there is no
+  // pipelining) so concurrent requests to the same host each get their own.
   //
   template <typename T = http_client_traits<>>
   class basic_http_session
@@ -74,6 +100,7 @@ namespace launcher
   public:
     using traits_type = T;
     using string_type = typename traits_type::string_type;
+    using ssl_stream_type = beast::ssl_stream<beast::tcp_stream>;
 
     explicit
     basic_http_session (asio::io_context& ioc, const traits_type& traits)
@@ -103,14 +130,38 @@ namespace launcher
       return ssl_ctx_;
     }
 
+    // Connection pool.
+    //
+    // The key identifies the peer, normally as host:port.
+    //
+
+    // Take an idle connection to the peer or return null if there is none.
+    //
+    std::unique_ptr<ssl_stream_type>
+    acquire (const string_type& key);
+
+    // Return the connection to the pool, closing it if the pool is full.
+    //
+    void
+    release (const string_type& key, std::unique_ptr<ssl_stream_type>);
+
   private:
     void
     configure_ssl ();
 
   private:
+    using clock = std::chrono::steady_clock;
+
+    struct idle_connection
+    {
+      clock::time_point since;
+      std::unique_ptr<ssl_stream_type> stream;
+    };
+
     asio::io_context& ioc_;
     traits_type traits_;
     ssl::context ssl_ctx_;
+    std::multimap<string_type, idle_connection> idle_;
   };
 
   // HTTP client.
@@ -133,6 +184,14 @@ namespace launcher
     //
     using progress_callback = std::function<void(std::uint64_t, std::uint64_t)>;
 
+    // Body sink: (data, size). Return false to stop the transfer early.
+    //
+    using sink_callback = std::function<bool (const char*, std::size_t)>;
+
+    // Byte range (first, last), both inclusive as in the Range header.
+    //
+    using byte_range = std::pair<std::uint64_t, std::uint64_t>;
+
     // Constructors.
     //
     explicit
@@ -150,6 +209,21 @@ namespace launcher
     asio::awaitable<response_type>
     request (const request_type& req);
 
+    // Perform an HTTP request, passing the response body to the sink as it
+    // arrives rather than buffering it in the response. This way a consumer
+    // such as a JSON parser can work through the body while it is still
+    // being received and without ever holding all of it.
+    //
+    // Note that the body of a redirect that we follow is not passed to the
+    // sink and, if the sink returns false, the rest of the body is skipped.
+    // Note also that only the body of a successful (2xx) response is passed
+    // to the sink. That of any other is returned in the response body
+    // (truncated if large) so check the status before trusting the sink's
+    // outcome.
+    //
+    asio::awaitable<response_type>
+    request (const request_type& req, sink_callback sink);
+
     // Perform a GET request.
     //
     asio::awaitable<response_type>
@@ -190,6 +264,21 @@ namespace launcher
               std::optional<std::uint64_t> resume_from = std::nullopt,
               std::uint64_t rate_limit_bytes_per_second = 0);
 
+    // Stream a response body into the sink as it arrives instead of writing
+    // it to a file. Resume is not supported since the sink is stateful.
+    //
+    // If range is specified, only that part of the resource is requested and
+    // the server must honor it (206), otherwise we throw.
+    //
+    // Returns the number of bytes passed to the sink.
+    //
+    asio::awaitable<std::uint64_t>
+    stream (const string_type& url,
+            sink_callback sink,
+            progress_callback progress = nullptr,
+            std::uint64_t rate_limit_bytes_per_second = 0,
+            std::optional<byte_range> range = std::nullopt);
+
     // Get the session.
     //
     session_type&
@@ -204,34 +293,64 @@ namespace launcher
       return *session_;
     }
 
+    // Status of the last response that download() or stream() got, even if
+    // they then threw because of it. Zero if there was none.
+    //
+    unsigned int
+    last_status () const noexcept
+    {
+      return last_status_;
+    }
+
+    // ETag of the last response that download() or stream() got, empty if
+    // there was none.
+    //
+    const string_type&
+    last_etag () const noexcept
+    {
+      return last_etag_;
+    }
+
   private:
     // Internal request implementation with redirect handling.
     //
     asio::awaitable<response_type>
-    request_impl (request_type req, std::uint8_t redirect_count = 0);
+    request_impl (request_type req,
+                  sink_callback sink,
+                  std::uint8_t redirect_count = 0);
 
-    // Internal download implementation with redirect handling.
+    // Internal download implementation with redirect handling. If the sink
+    // is set, the body goes there and target_path is ignored.
     //
     asio::awaitable<std::uint64_t>
     download_impl (const string_type& url,
                    const string_type& target_path,
+                   sink_callback sink,
                    progress_callback progress,
                    std::optional<std::uint64_t> resume_from,
+                   std::optional<std::uint64_t> range_last,
                    std::uint64_t rate_limit_bytes_per_second,
                    std::uint8_t redirect_count);
 
-    // Perform request over SSL.
+    // Perform request over SSL, reusing a pooled connection if possible.
     //
     asio::awaitable<response_type>
-    request_ssl (const request_type& req);
+    request_ssl (const request_type& req, const sink_callback& sink);
+
+    // Establish a new SSL connection.
+    //
+    asio::awaitable<std::unique_ptr<typename session_type::ssl_stream_type>>
+    connect_ssl (const string_type& host, const string_type& port);
 
     // Perform request over plain TCP.
     //
     asio::awaitable<response_type>
-    request_tcp (const request_type& req);
+    request_tcp (const request_type& req, const sink_callback& sink);
 
   private:
     std::unique_ptr<session_type> session_;
+    unsigned int last_status_ = 0;
+    string_type last_etag_;
   };
 
   // Common typedefs.
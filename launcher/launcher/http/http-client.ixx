@@ -35,6 +35,42 @@ namespace launcher
     SSL_CTX_set_tlsext_servername_callback (ssl_ctx_.native_handle (), nullptr);
   }
 
+  template <typename T>
+  inline std::unique_ptr<typename basic_http_session<T>::ssl_stream_type>
+  basic_http_session<T>::
+  acquire (const string_type& k)
+  {
+    auto now (clock::now ());
+    auto to (std::chrono::milliseconds (traits_.idle_timeout));
+
+    // Take the first connection that is still fresh, dropping those that
+    // have been idle for too long along the way.
+    //
+    std::unique_ptr<ssl_stream_type> r;
+
+    for (auto p (idle_.equal_range (k)); p.first != p.second && !r; )
+    {
+      auto i (p.first++);
+
+      if (now - i->second.since < to)
+        r = std::move (i->second.stream);
+
+      idle_.erase (i);
+    }
+
+    return r;
+  }
+
+  template <typename T>
+  inline void basic_http_session<T>::
+  release (const string_type& k, std::unique_ptr<ssl_stream_type> s)
+  {
+    if (idle_.count (k) >= traits_.max_idle)
+      return;
+
+    idle_.emplace (k, idle_connection {clock::now (), std::move (s)});
+  }
+
   template <typename T>
   inline asio::awaitable<typename basic_http_client<T>::response_type>
   basic_http_client<T>::
@@ -98,6 +134,17 @@ namespace launcher
   basic_http_client<T>::
   request (const request_type& req)
   {
-    co_return co_await request_impl (req, 0);
+    co_return co_await request_impl (req, nullptr, 0);
+  }
+
+  template <typename T>
+  inline asio::awaitable<typename basic_http_client<T>::response_type>
+  basic_http_client<T>::
+  request (const request_type& req, sink_callback sink)
+  {
+    if (!sink)
+      throw std::invalid_argument ("request sink must be set");
+
+    co_return co_await request_impl (req, std::move (sink), 0);
   }
 }
@@ -1,4 +1,10 @@
+#include <algorithm>
 #include <fstream>
+#include <limits>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <exception>
 #include <stdexcept>
 #include <iostream>
 
@@ -118,12 +124,255 @@ namespace launcher
     return static_cast<http_status> (static_cast<std::uint16_t> (s));
   }
 
+  // Beast body that passes the data to a sink as it is parsed rather than
+  // storing it.
+  //
+  // The body of a redirect that is going to be followed is skipped, as is
+  // the rest of the body once the sink has declined it. If only successful
+  // responses are for the sink, the body of any other (say, an error page)
+  // is kept aside instead, up to a limit. If the body has a
+  // content coding we can decode (and decoding is enabled), it is inflated
+  // on the way so that the sink only ever sees the decoded bytes.
+  //
+  // Note that the sink is called from within the read operation where an
+  // exception has nowhere to go. So if the sink throws, we stop calling it
+  // and save the exception for the caller to rethrow once the read is done.
+  // The same goes for corrupt encoded data.
+  //
+  struct sink_body
+  {
+    struct value_type
+    {
+      std::function<bool (const char*, std::size_t)> sink;
+      bool follow_redirects = true;
+      bool decode = true;
+      bool success_only = false;
+      bool decoded = false;
+      bool stopped = false;
+      std::string other; // Body of an unsuccessful response.
+      std::exception_ptr error;
+    };
+
+    static constexpr std::size_t other_limit = 64 * 1024;
+
+    class reader
+    {
+    public:
+      template <bool R, typename F>
+      reader (http::header<R, F>& h, value_type& v)
+        : v_ (v), out_ (v.sink)
+      {
+        if constexpr (!R)
+        {
+          auto s (h.result_int ());
+
+          skip_ = v_.follow_redirects && s >= 300 && s < 400 &&
+                  h.find (http::field::location) != h.end ();
+
+          if (!skip_ && v_.success_only && (s < 200 || s >= 300))
+          {
+            out_ = [&v = v_] (const char* d, std::size_t n)
+            {
+              std::size_t m (std::min (n, other_limit - v.other.size ()));
+              v.other.append (d, m);
+              return v.other.size () < other_limit;
+            };
+          }
+        }
+
+        if (skip_ || !v_.decode)
+          return;
+
+        auto i (h.find (http::field::content_encoding));
+
+        if (i != h.end ())
+        {
+          auto e (i->value ());
+
+          if (auto c = content_decoder::parse (
+                std::string_view (e.data (), e.size ())))
+          {
+            d_ = std::make_unique<content_decoder> (*c, out_);
+            v_.decoded = true;
+          }
+        }
+      }
+
+      void
+      init (const boost::optional<std::uint64_t>&, beast::error_code& ec)
+      {
+        ec = {};
+      }
+
+      template <typename B>
+      std::size_t
+      put (const B& bs, beast::error_code& ec)
+      {
+        ec = {};
+        std::size_t n (0);
+
+        for (auto b : beast::buffers_range_ref (bs))
+        {
+          n += b.size ();
+          n_ += b.size ();
+
+          if (skip_ || v_.stopped)
+            continue;
+
+          try
+          {
+            const char* d (static_cast<const char*> (b.data ()));
+
+            if (!(d_ ? d_->write (d, b.size ()) : out_ (d, b.size ())))
+              v_.stopped = true;
+          }
+          catch (...)
+          {
+            v_.error = std::current_exception ();
+            v_.stopped = true;
+          }
+        }
+
+        return n;
+      }
+
+      void
+      finish (beast::error_code& ec)
+      {
+        ec = {};
+
+        // An empty body (say, of a 304) carries the coding header but no
+        // stream to check.
+        //
+        if (d_ && n_ != 0 && !v_.stopped)
+        {
+          try
+          {
+            d_->finish ();
+          }
+          catch (...)
+          {
+            v_.error = std::current_exception ();
+          }
+        }
+      }
+
+    private:
+      value_type& v_;
+      std::function<bool (const char*, std::size_t)> out_;
+      bool skip_ = false;
+      std::uint64_t n_ = 0;
+      std::unique_ptr<content_decoder> d_;
+    };
+  };
+
+  // Read the response, into the sink if there is one and into the body
+  // otherwise. Set keep to whether the connection can be reused after it
+  // and sunk to whether any of the body reached the sink.
+  //
+  // Only the body of a successful (2xx) response goes to the sink. That of
+  // any other is returned in the response body (truncated if large) so that
+  // an error page doesn't end up in, say, a JSON parser whose complaint
+  // would then hide the status.
+  //
+  // Either way the body is parsed with sink_body so that it is decoded as it
+  // arrives instead of being buffered encoded first. If it was decoded, the
+  // Content-Encoding and Content-Length headers are dropped from the result
+  // since they describe the encoded body.
+  //
+  // Note that errors are reported via ec rather than thrown so that the
+  // caller can tell a stale connection from a failed request.
+  //
+  template <typename R, typename S>
+  asio::awaitable<R>
+  read_response (S& s,
+                 beast::flat_buffer& b,
+                 const std::function<bool (const char*, std::size_t)>& sink,
+                 bool follow_redirects,
+                 bool decode,
+                 bool& keep,
+                 bool& sunk,
+                 beast::error_code& ec)
+  {
+    using string_type = typename R::string_type;
+
+    R r;
+    string_type body;
+
+    // Since nothing is buffered with a sink, there is no reason to limit the
+    // body size. Otherwise stick to what Beast would allow a string_body.
+    //
+    http::response_parser<sink_body> p;
+    p.body_limit (sink
+                  ? std::numeric_limits<std::uint64_t>::max ()
+                  : std::uint64_t (8 * 1024 * 1024));
+
+    auto& v (p.get ().body ());
+    v.follow_redirects = follow_redirects;
+    v.decode = decode;
+
+    sunk = false;
+
+    if (sink)
+    {
+      v.success_only = true;
+      v.sink = [&sink, &sunk] (const char* d, std::size_t n)
+      {
+        sunk = true;
+        return sink (d, n);
+      };
+    }
+    else
+      v.sink = [&body] (const char* d, std::size_t n)
+      {
+        body.append (d, n);
+        return true;
+      };
+
+    co_await http::async_read (
+      s, b, p, asio::redirect_error (asio::use_awaitable, ec));
+
+    if (v.error)
+      std::rethrow_exception (v.error);
+
+    if (!ec)
+    {
+      const auto& m (p.get ());
+
+      r.status  = from_beast_status (m.result  ());
+      r.version = http_version      (m.version () / 10,
+                                     m.version () % 10);
+      r.reason  = string_type       (m.reason  ());
+
+      for (const auto& h : m)
+        r.headers.add (string_type (h.name_string ()),
+                       string_type (h.value ()));
+
+      if (v.decoded)
+      {
+        r.headers.remove (string_type ("Content-Encoding"));
+        r.headers.remove (string_type ("Content-Length"));
+      }
+
+      keep = m.keep_alive ();
+
+      if (!body.empty ())
+        r.body = std::move (body);
+      else if (!v.other.empty ())
+        r.body = string_type (std::move (v.other));
+    }
+
+    co_return r;
+  }
+
   // Execute a request with automatic redirect handling.
   //
   template <typename T>
   asio::awaitable<typename basic_http_client<T>::response_type>
   basic_http_client<T>::
-  request_impl (request_type req, std::uint8_t redirect_count)
+  request_impl (request_type req,
+                sink_callback sink,
+                std::uint8_t redirect_count)
   {
     const auto& traits (session_->traits ());
 
@@ -136,8 +385,8 @@ namespace launcher
     bool ssl (parts.scheme == "https");
 
     response_type r (ssl
-                     ? co_await request_ssl (req)
-                     : co_await request_tcp (req));
+                     ? co_await request_ssl (req, sink)
+                     : co_await request_tcp (req, sink));
 
     // Handle redirects (3xx).
     //
@@ -180,6 +429,7 @@ namespace launcher
         next_req.normalize ();
 
         co_return co_await request_impl (std::move (next_req),
+                                         std::move (sink),
                                          redirect_count + 1);
       }
     }
@@ -192,11 +442,121 @@ namespace launcher
   template <typename T>
   asio::awaitable<typename basic_http_client<T>::response_type>
   basic_http_client<T>::
-  request_ssl (const request_type& req)
+  request_ssl (const request_type& req, const sink_callback& sink)
   {
-    using stream_type = beast::ssl_stream<beast::tcp_stream>;
-    using beast_req   = http::request<http::string_body>;
-    using beast_res   = http::response<http::string_body>;
+    using beast_req = http::request<http::string_body>;
+
+    const auto& tr (session_->traits ());
+
+    url_parts parts (parse_url (req.url));
+    string_type key (parts.host + ':' + parts.port);
+
+    // Prepare the Beast request object.
+    //
+    beast_req br;
+    br.method (to_beast_verb (req.method));
+    br.target (req.target ());
+    br.version (req.version.major * 10 + req.version.minor);
+
+    for (const auto& h : req.headers)
+      br.set (h.name, h.value);
+
+    // Ask for a compressed response unless the caller has an opinion.
+    //
+    if (tr.decode_content &&
+        br.find (http::field::accept_encoding) == br.end ())
+      br.set (http::field::accept_encoding, content_decoder::accept);
+
+    if (req.body)
+    {
+      br.body () = *req.body;
+      br.prepare_payload ();
+    }
+
+    br.keep_alive (tr.keep_alive);
+
+    for (;;)
+    {
+      std::unique_ptr<typename session_type::ssl_stream_type> s;
+
+      if (tr.keep_alive)
+        s = session_->acquire (key);
+
+      bool reused (s != nullptr);
+
+      if (!s)
+        s = co_await connect_ssl (parts.host, parts.port);
+
+      // We cache the reference to the lowest layer (the TCP stream) here.
+      // This allows us to set the timeout on the underlying socket without
+      // verbose casting calls cluttering the logic.
+      //
+      auto& layer (beast::get_lowest_layer (*s));
+
+      // Send the request and receive the response.
+      //
+      // We reset the timeout on the lowest layer to the request timeout value
+      // before writing.
+      //
+      beast::error_code ec;
+      beast::flat_buffer b;
+      bool keep (false);
+      bool sunk (false);
+      response_type r;
+
+      layer.expires_after (std::chrono::milliseconds (tr.request_timeout));
+      co_await http::async_write (
+        *s, br, asio::redirect_error (asio::use_awaitable, ec));
+
+      if (!ec)
+        r = co_await read_response<response_type> (
+          *s, b, sink, tr.follow_redirects, tr.decode_content, keep, sunk, ec);
+
+      if (ec)
+      {
+        // The server may have closed a pooled connection while it was idle,
+        // which we only find out now. If so, retry over a new one, but only
+        // if none of the body has reached the sink: it is stateful and we
+        // cannot take back what it has already consumed. Past that point
+        // this is a failed transfer like any other.
+        //
+        if (reused && !sunk && (ec == http::error::end_of_stream ||
+                                ec == asio::error::eof ||
+                                ec == asio::error::connection_reset ||
+                                ec == asio::error::connection_aborted ||
+                                ec == asio::error::broken_pipe ||
+                                ec == ssl::error::stream_truncated))
+          continue;
+
+        throw beast::system_error (ec);
+      }
+
+      // Return the connection to the pool if the server is willing to keep
+      // it open. Otherwise we just close it.
+      //
+      // Note that we don't attempt an SSL shutdown: many servers simply close
+      // the TCP connection after sending the response without performing a
+      // proper TLS shutdown sequence and even attempting one in this case can
+      // block until timeout.
+      //
+      if (tr.keep_alive && keep)
+        session_->release (key, std::move (s));
+      else
+        layer.socket ().shutdown (tcp::socket::shutdown_both, ec);
+
+      co_return r;
+    }
+  }
+
+  // Establish an SSL connection.
+  //
+  template <typename T>
+  asio::awaitable<std::unique_ptr<
+    typename basic_http_client<T>::session_type::ssl_stream_type>>
+  basic_http_client<T>::
+  connect_ssl (const string_type& host, const string_type& port)
+  {
+    using stream_type = typename session_type::ssl_stream_type;
 
     // Grab references to the session context to keep the code flat.
     //
@@ -204,15 +564,12 @@ namespace launcher
     auto& ssl (session_->ssl_context ());
     const auto& tr (session_->traits ());
 
-    url_parts parts (parse_url (req.url));
-
     // Resolve the hostname.
     //
     tcp::resolver rslv (ctx);
-    auto addrs (co_await rslv.async_resolve (
-      parts.host, parts.port, asio::use_awaitable));
+    auto addrs (co_await rslv.async_resolve (host, port, asio::use_awaitable));
 
-    stream_type s (ctx, ssl);
+    auto s (std::make_unique<stream_type> (ctx, ssl));
 
     // Set the SNI (Server Name Indication) hostname.
     //
@@ -223,7 +580,7 @@ namespace launcher
     // Note also that If we fail here, the handshake will almost certainly fail
     // or return the wrong certificate later, so we treat it as a system error.
     //
-    if (!SSL_set_tlsext_host_name (s.native_handle (), parts.host.c_str ()))
+    if (!SSL_set_tlsext_host_name (s->native_handle (), host.c_str ()))
     {
       int v (static_cast<int> (::ERR_get_error ()));
       beast::error_code ec (v, asio::error::get_ssl_category ());
@@ -233,81 +590,17 @@ namespace launcher
 
     // Connect to the TCP endpoint.
     //
-    // We cache the reference to the lowest layer (the TCP stream) here. This
-    // allows us to set the timeout on the underlying socket without verbose
-    // casting calls cluttering the logic.
-    //
-    auto& layer (beast::get_lowest_layer (s));
+    auto& layer (beast::get_lowest_layer (*s));
     layer.expires_after (std::chrono::milliseconds (tr.connect_timeout));
 
     co_await layer.async_connect (addrs, asio::use_awaitable);
 
     // Perform the SSL handshake.
     //
-    co_await s.async_handshake (
+    co_await s->async_handshake (
       ssl::stream_base::client, asio::use_awaitable);
 
-    // Prepare the Beast request object.
-    //
-    beast_req br;
-    br.method (to_beast_verb (req.method));
-    br.target (req.target ());
-    br.version (req.version.major * 10 + req.version.minor);
-
-    for (const auto& h : req.headers)
-      br.set (h.name, h.value);
-
-    if (req.body)
-    {
-      br.body () = *req.body;
-      br.prepare_payload ();
-    }
-
-    // Send the request.
-    //
-    // We reset the timeout on the lowest layer to the request timeout value
-    // before writing.
-    //
-    layer.expires_after (std::chrono::milliseconds (tr.request_timeout));
-    co_await http::async_write (s, br, asio::use_awaitable);
-
-    // Receive the response.
-    //
-    beast::flat_buffer b;
-    beast_res bres;
-    co_await http::async_read (s, b, bres, asio::use_awaitable);
-
-    // Shutdown.
-    //
-    // We attempt to shut down the SSL layer, but note that we explicitly ignore
-    // the error code here. The reality is that many servers simply close the
-    // TCP connection after sending the response without performing a proper TLS
-    // shutdown sequence. Treating that as a failure would cause us to throw
-    // errors on perfectly valid requests.
-    //
-    // ... Turn out that even attempting an SSL shutdown in this case can
-    // block until timeout, so disable it altogether.
-    //
-    // beast::error_code ec;
-    // co_await s.async_shutdown (
-    //   asio::redirect_error (asio::use_awaitable, ec));
-
-    // Convert to our internal response type.
-    //
-    response_type r;
-    r.status  = from_beast_status (bres.result  ());
-    r.version = http_version      (bres.version () / 10,
-                                   bres.version () % 10);
-    r.reason  = string_type       (bres.reason  ());
-
-    for (const auto& h : bres)
-      r.headers.add (string_type (h.name_string ()),
-                     string_type (h.value ()));
-
-    if (!bres.body ().empty ())
-      r.body = bres.body ();
-
-    co_return r;
+    co_return s;
   }
 
   // Request implementation (TCP).
@@ -318,10 +611,9 @@ namespace launcher
   template <typename T>
   asio::awaitable<typename basic_http_client<T>::response_type>
   basic_http_client<T>::
-  request_tcp (const request_type& req)
+  request_tcp (const request_type& req, const sink_callback& sink)
   {
     using beast_req = http::request<http::string_body>;
-    using beast_res = http::response<http::string_body>;
 
     auto& ctx (session_->io_context ());
     const auto& tr (session_->traits ());
@@ -351,6 +643,12 @@ namespace launcher
     for (const auto& h : req.headers)
       br.set (h.name, h.value);
 
+    // Ask for a compressed response unless the caller has an opinion.
+    //
+    if (tr.decode_content &&
+        br.find (http::field::accept_encoding) == br.end ())
+      br.set (http::field::accept_encoding, content_decoder::accept);
+
     if (req.body)
     {
       br.body () = *req.body;
@@ -364,30 +662,22 @@ namespace launcher
 
     // Receive.
     //
+    beast::error_code ec;
     beast::flat_buffer b;
-    beast_res bres;
-    co_await http::async_read (s, b, bres, asio::use_awaitable);
+    bool keep (false);
+    bool sunk (false);
+
+    response_type r (
+      co_await read_response<response_type> (
+        s, b, sink, tr.follow_redirects, tr.decode_content, keep, sunk, ec));
+
+    if (ec)
+      throw beast::system_error (ec);
 
     // Shutdown.
     //
-    beast::error_code ec;
     ec = s.socket ().shutdown (tcp::socket::shutdown_both, ec);
 
-    // Convert.
-    //
-    response_type r;
-    r.status = from_beast_status (bres.result ());
-    r.version = http_version (bres.version () / 10,
-                              bres.version () % 10);
-    r.reason = string_type (bres.reason ());
-
-    for (const auto& h : bres)
-      r.headers.add (string_type (h.name_string ()),
-                     string_type (h.value ()));
-
-    if (!bres.body ().empty ())
-      r.body = bres.body ();
-
     co_return r;
   }
 
@@ -402,7 +692,41 @@ namespace launcher
             std::optional<std::uint64_t> resume,
             std::uint64_t rate_limit_bytes_per_second)
   {
-    co_return co_await download_impl (url, file, progress, resume, rate_limit_bytes_per_second, 0);
+    co_return co_await download_impl (url, file, nullptr, progress, resume, std::nullopt, rate_limit_bytes_per_second, 0);
+  }
+
+  // Streaming entry point.
+  //
+  template <typename T>
+  asio::awaitable<std::uint64_t>
+  basic_http_client<T>::
+  stream (const string_type& url,
+          sink_callback sink,
+          progress_callback progress,
+          std::uint64_t rate_limit_bytes_per_second,
+          std::optional<byte_range> range)
+  {
+    if (!sink)
+      throw std::invalid_argument ("stream sink must be set");
+
+    if (range && range->first > range->second)
+      throw std::invalid_argument ("invalid byte range");
+
+    // Note that download_impl() counts from the start of the range.
+    //
+    std::uint64_t n (
+      co_await download_impl (url,
+                              string_type (),
+                              std::move (sink),
+                              progress,
+                              range ? std::optional<std::uint64_t> (range->first)
+                                    : std::nullopt,
+                              range ? std::optional<std::uint64_t> (range->second)
+                                    : std::nullopt,
+                              rate_limit_bytes_per_second,
+                              0));
+
+    co_return range ? n - range->first : n;
   }
 
   // Internal download implementation.
@@ -416,8 +740,10 @@ namespace launcher
   basic_http_client<T>::
   download_impl (const string_type& url,
                  const string_type& file,
+                 sink_callback sink,
                  progress_callback progress,
                  std::optional<std::uint64_t> resume,
+                 std::optional<std::uint64_t> last,
                  std::uint64_t rate_limit_bytes_per_second,
                  std::uint8_t redirect_count)
   {
@@ -433,7 +759,8 @@ namespace launcher
     //
     // If we are resuming a download, we need to instruct the server to skip
     // the bytes we already have. Note that the Range header is inclusive,
-    // so we request from the current size onwards.
+    // so we request from the current size onwards (or up to the last byte
+    // if we were asked for a bounded range).
     //
     request_type req (http_method::get, url);
 
@@ -441,7 +768,8 @@ namespace launcher
       req.set_header (string_type ("Range"),
                       string_type ("bytes=") +
                       std::to_string (*resume) +
-                      string_type ("-"));
+                      string_type ("-") +
+                      (last ? std::to_string (*last) : string_type ()));
 
     req.normalize ();
 
@@ -456,17 +784,22 @@ namespace launcher
                                              parts.port,
                                              asio::use_awaitable));
 
-    // Open the output file.
+    // Open the output file unless the body goes to a sink.
     //
     // If we are resuming, we append. Otherwise, we truncate so that we don't
     // leave garbage at the end if the file already existed.
     //
-    std::ios_base::openmode mode (std::ios::binary | std::ios::out);
-    mode |= (resume ? std::ios::app : std::ios::trunc);
+    std::ofstream ofs;
+
+    if (!sink)
+    {
+      std::ios_base::openmode mode (std::ios::binary | std::ios::out);
+      mode |= (resume ? std::ios::app : std::ios::trunc);
 
-    std::ofstream ofs (file, mode);
-    if (!ofs)
-      throw std::runtime_error ("failed to open file for writing");
+      ofs.open (file, mode);
+      if (!ofs)
+        throw std::runtime_error ("failed to open file for writing");
+    }
 
     std::uint64_t off (resume ? *resume : 0);
     std::uint64_t tot (0);
@@ -509,13 +842,16 @@ namespace launcher
       // with the new URL.
       //
       auto status (p.get ().result_int ());
+      last_status_ = status;
+      last_etag_ = string_type (p.get ()[http::field::etag]);
 
       if (tr.follow_redirects && status >= 300 && status < 400)
       {
         auto loc (p.get ()[http::field::location]);
         if (!loc.empty ())
         {
-          ofs.close ();
+          if (ofs.is_open ())
+            ofs.close ();
 
           // Note that we don't need to explicitly shutdown the socket here
           // because we are about to detach from this stack frame. The
@@ -523,8 +859,10 @@ namespace launcher
           //
           co_return co_await download_impl (string_type (loc),
                                             file,
+                                            sink,
                                             progress,
                                             resume,
+                                            last,
                                             rate_limit_bytes_per_second,
                                             redirect_count + 1);
         }
@@ -537,6 +875,12 @@ namespace launcher
         throw std::runtime_error ("download failed with status: " +
                                   std::to_string (status));
 
+      // A server that ignores a bounded range would hand us the whole
+      // resource, which is never what the caller wants.
+      //
+      if (last && status != 206)
+        throw std::runtime_error ("server ignored range request");
+
       if (p.content_length ())
         tot = *p.content_length () + off;
 
@@ -563,7 +907,21 @@ namespace launcher
 
         if (n > 0)
         {
-          ofs.write (dbuf, n);
+          // If the sink declines further data, we simply stop reading. The
+          // connection is torn down below and the caller decides what the
+          // partial transfer means.
+          //
+          if (sink)
+          {
+            if (!sink (dbuf, n))
+            {
+              off += n;
+              break;
+            }
+          }
+          else
+            ofs.write (dbuf, n);
+
           off += n;
           trans += n;
 
@@ -602,7 +960,9 @@ namespace launcher
         }
       }
 
-      ofs.flush ();
+      if (ofs.is_open ())
+        ofs.flush ();
+
       co_return off;
     };
 
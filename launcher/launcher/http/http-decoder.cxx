@@ -0,0 +1,320 @@
+#include <launcher/http/http-decoder.hxx>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <miniz.h>
+
+using namespace std;
+
+namespace launcher
+{
+  // gzip member layout (RFC 1952 2.3).
+  //
+  static const size_t gzip_header_size  (10);
+  static const size_t gzip_trailer_size (8);
+
+  static const uint8_t gzip_fhcrc    (0x02);
+  static const uint8_t gzip_fextra   (0x04);
+  static const uint8_t gzip_fname    (0x08);
+  static const uint8_t gzip_fcomment (0x10);
+  static const uint8_t gzip_reserved (0xe0);
+
+  // zlib header size (RFC 1950 2.2), without the preset dictionary which
+  // HTTP has no use for.
+  //
+  static const size_t zlib_header_size (2);
+
+  static inline uint32_t
+  get32 (const string& b, size_t o)
+  {
+    auto u ([&b] (size_t i)
+    {
+      return static_cast<uint32_t> (static_cast<unsigned char> (b[i]));
+    });
+
+    return u (o) | u (o + 1) << 8 | u (o + 2) << 16 | u (o + 3) << 24;
+  }
+
+  static inline const char*
+  coding_name (content_decoder::coding c)
+  {
+    return c == content_decoder::coding::gzip ? "gzip" : "deflate";
+  }
+
+  struct content_decoder::inflater
+  {
+    mz_stream s;
+    vector<unsigned char> out;
+
+    // Negative window bits mean raw deflate, positive ones the zlib format,
+    // whose header and Adler-32 trailer miniz then checks for us.
+    //
+    explicit
+    inflater (int window_bits)
+      : out (64 * 1024)
+    {
+      memset (&s, 0, sizeof (s));
+
+      if (mz_inflateInit2 (&s, window_bits) != MZ_OK)
+        throw runtime_error ("failed to initialize inflate stream");
+    }
+
+    ~inflater ()
+    {
+      mz_inflateEnd (&s);
+    }
+  };
+
+  optional<content_decoder::coding> content_decoder::
+  parse (string_view v)
+  {
+    auto ws ([] (char c) {return c == ' ' || c == '\t';});
+
+    while (!v.empty () && ws (v.front ())) v.remove_prefix (1);
+    while (!v.empty () && ws (v.back ()))  v.remove_suffix (1);
+
+    // Note that a list of codings (say, "gzip, br") is not something we
+    // ever ask for, so we don't bother decoding it.
+    //
+    string s (v);
+    transform (s.begin (), s.end (), s.begin (), [] (unsigned char c)
+    {
+      return static_cast<char> (tolower (c));
+    });
+
+    if (s == "gzip" || s == "x-gzip") return coding::gzip;
+    if (s == "deflate")               return coding::deflate;
+
+    return nullopt;
+  }
+
+  content_decoder::
+  content_decoder (coding c, sink_type s)
+    : coding_ (c), sink_ (move (s))
+  {
+    if (!sink_)
+      throw invalid_argument ("content decoder sink must be set");
+  }
+
+  content_decoder::
+  ~content_decoder () = default;
+
+  bool content_decoder::
+  write (const char* d, size_t n)
+  {
+    while (n != 0 && !stopped_)
+    {
+      size_t u (0);
+
+      switch (state_)
+      {
+      case state::header:  u = header (d, n);  break;
+      case state::data:    u = data (d, n);    break;
+      case state::trailer: u = trailer (d, n); break;
+      case state::done:
+        throw runtime_error (string ("unexpected data after end of ") +
+                             coding_name (coding_) + " content");
+      }
+
+      d += u;
+      n -= u;
+    }
+
+    return !stopped_;
+  }
+
+  void content_decoder::
+  finish () const
+  {
+    if (state_ != state::done && !stopped_)
+      throw runtime_error (string ("truncated ") + coding_name (coding_) +
+                           " content");
+  }
+
+  size_t content_decoder::
+  header (const char* d, size_t n)
+  {
+    // For deflate all we need is enough to tell zlib from raw deflate. If
+    // the first two bytes are a valid zlib header (the method is deflate
+    // and they are a multiple of 31), that's what it is: a raw stream can
+    // start like that but only by accident.
+    //
+    if (coding_ == coding::deflate)
+    {
+      size_t m (min (zlib_header_size - buf_.size (), n));
+      buf_.append (d, m);
+
+      if (buf_.size () < zlib_header_size)
+        return m;
+
+      auto b ([this] (size_t i) {return static_cast<uint8_t> (buf_[i]);});
+
+      bool zlib ((b (0) & 0x0f) == 8 &&
+                 (b (0) >> 4) <= 7 &&
+                 (b (0) << 8 | b (1)) % 31 == 0);
+
+      inf_ = make_unique<inflater> (zlib
+                                    ? MZ_DEFAULT_WINDOW_BITS
+                                    : -MZ_DEFAULT_WINDOW_BITS);
+      state_ = state::data;
+
+      // Either way the header bytes belong to the stream.
+      //
+      string h (move (buf_));
+      buf_.clear ();
+
+      if (data (h.data (), h.size ()) != h.size () && !stopped_)
+        throw runtime_error ("unexpected data after end of deflate content");
+
+      return m;
+    }
+
+    // The gzip header is a fixed part followed by optional fields that the
+    // flags announce. We don't care about any of them, but we have to know
+    // how long they are, so accumulate byte by byte until we can tell.
+    //
+    // Return 0 while more bytes are needed, the full length otherwise.
+    //
+    auto parse ([this] () -> size_t
+    {
+      if (buf_.size () < gzip_header_size)
+        return 0;
+
+      auto b ([this] (size_t i) {return static_cast<uint8_t> (buf_[i]);});
+
+      if (b (0) != 0x1f || b (1) != 0x8b)
+        throw runtime_error ("not gzip content");
+
+      if (b (2) != 8)
+        throw runtime_error ("unsupported gzip compression method");
+
+      uint8_t f (b (3));
+
+      if (f & gzip_reserved)
+        throw runtime_error ("unsupported gzip header flags");
+
+      size_t o (gzip_header_size);
+
+      if (f & gzip_fextra)
+      {
+        if (buf_.size () < o + 2)
+          return 0;
+
+        o += 2 + (b (o) | b (o + 1) << 8);
+      }
+
+      for (uint8_t z : {gzip_fname, gzip_fcomment})
+      {
+        if (!(f & z))
+          continue;
+
+        size_t e (buf_.find ('\0', o));
+        if (e == string::npos)
+          return 0;
+
+        o = e + 1;
+      }
+
+      if (f & gzip_fhcrc)
+        o += 2;
+
+      return buf_.size () >= o ? o : 0;
+    });
+
+    size_t m (0);
+
+    while (m != n)
+    {
+      buf_.push_back (d[m++]);
+
+      if (parse () != 0)
+      {
+        buf_.clear ();
+        inf_ = make_unique<inflater> (-MZ_DEFAULT_WINDOW_BITS);
+        state_ = state::data;
+        break;
+      }
+    }
+
+    return m;
+  }
+
+  size_t content_decoder::
+  data (const char* d, size_t n)
+  {
+    auto& s (inf_->s);
+    auto& o (inf_->out);
+
+    s.next_in = reinterpret_cast<const unsigned char*> (d);
+    s.avail_in = static_cast<unsigned int> (n);
+
+    int r;
+    for (;;)
+    {
+      s.next_out = o.data ();
+      s.avail_out = static_cast<unsigned int> (o.size ());
+
+      r = mz_inflate (&s, MZ_NO_FLUSH);
+
+      if (r != MZ_OK && r != MZ_STREAM_END && r != MZ_BUF_ERROR)
+        throw runtime_error (string ("corrupt ") + coding_name (coding_) +
+                             " content");
+
+      size_t p (o.size () - s.avail_out);
+
+      if (p != 0)
+      {
+        if (coding_ == coding::gzip)
+          crc_ = static_cast<uint32_t> (mz_crc32 (crc_, o.data (), p));
+
+        size_ += p;
+
+        // If the sink had enough, there is no point inflating the rest.
+        //
+        if (!sink_ (reinterpret_cast<const char*> (o.data ()), p))
+        {
+          stopped_ = true;
+          return n;
+        }
+      }
+
+      if (r == MZ_STREAM_END || (s.avail_in == 0 && s.avail_out != 0))
+        break;
+
+      if (r == MZ_BUF_ERROR && p == 0)
+        break;
+    }
+
+    if (r == MZ_STREAM_END)
+      state_ = coding_ == coding::gzip ? state::trailer : state::done;
+
+    return n - s.avail_in;
+  }
+
+  size_t content_decoder::
+  trailer (const char* d, size_t n)
+  {
+    size_t m (min (gzip_trailer_size - buf_.size (), n));
+    buf_.append (d, m);
+
+    if (buf_.size () < gzip_trailer_size)
+      return m;
+
+    // The size is recorded modulo 2^32.
+    //
+    if (get32 (buf_, 0) != crc_)
+      throw runtime_error ("gzip content crc mismatch");
+
+    if (get32 (buf_, 4) != static_cast<uint32_t> (size_))
+      throw runtime_error ("gzip content size mismatch");
+
+    buf_.clear ();
+    state_ = state::done;
+    return m;
+  }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <string_view>
+
+namespace launcher
+{
+  // Streaming decoder for the gzip and deflate content codings.
+  //
+  // Sits between the HTTP parser and the body sink, inflating the body as
+  // it comes off the wire. Note that per RFC 9110 deflate means the zlib
+  // format (RFC 1950) but some servers send raw deflate instead, so we
+  // accept both.
+  //
+  class content_decoder
+  {
+  public:
+    enum class coding
+    {
+      gzip,   // RFC 1952, single member.
+      deflate // RFC 1950 or raw RFC 1951.
+    };
+
+    // Decoded body sink. Return false to stop decoding.
+    //
+    using sink_type = std::function<bool (const char*, std::size_t)>;
+
+    // Value for the Accept-Encoding request header.
+    //
+    static constexpr const char* accept = "gzip, deflate";
+
+    // Map a Content-Encoding header value to the coding. Return nullopt if
+    // it is something we cannot decode (or identity, which there is nothing
+    // to decode for).
+    //
+    static std::optional<coding>
+    parse (std::string_view content_encoding);
+
+    content_decoder (coding, sink_type);
+
+    ~content_decoder ();
+
+    content_decoder (const content_decoder&) = delete;
+    content_decoder& operator= (const content_decoder&) = delete;
+
+    // Consume the next chunk of the encoded body. Return false if the sink
+    // declined further data. Throw on corrupt data, including anything past
+    // the end of the stream.
+    //
+    bool
+    write (const char* data, std::size_t size);
+
+    // Throw if the body ended before the stream did.
+    //
+    void
+    finish () const;
+
+    // Return true if the stream ended and its trailer (if any) checked out.
+    //
+    bool
+    complete () const noexcept
+    {
+      return state_ == state::done;
+    }
+
+    // Number of decoded bytes so far.
+    //
+    std::uint64_t
+    size () const noexcept
+    {
+      return size_;
+    }
+
+  private:
+    enum class state
+    {
+      header,  // Accumulating the gzip member or zlib header.
+      data,    // Inside deflate data.
+      trailer, // Accumulating the gzip CRC and size trailer.
+      done
+    };
+
+    std::size_t
+    header (const char*, std::size_t);
+
+    std::size_t
+    data (const char*, std::size_t);
+
+    std::size_t
+    trailer (const char*, std::size_t);
+
+  private:
+    struct inflater;
+
+    coding coding_;
+    sink_type sink_;
+    state state_ = state::header;
+    bool stopped_ = false;
+    std::string buf_; // Partial header or trailer.
+    std::uint32_t crc_ = 0;
+    std::uint64_t size_ = 0;
+    std::unique_ptr<inflater> inf_;
+  };
+}
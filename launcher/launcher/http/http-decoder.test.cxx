@@ -0,0 +1,257 @@
+#include <launcher/http/http-decoder.hxx>
+
+#include <string>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include <miniz.h>
+
+using namespace std;
+using namespace launcher;
+
+// Body construction.
+//
+// miniz only produces the zlib format, so raw deflate and gzip are cut out
+// of (or wrapped around) that.
+//
+static void
+put32 (string& b, uint32_t v)
+{
+  for (int i (0); i != 4; ++i)
+    b += static_cast<char> (v >> (i * 8) & 0xff);
+}
+
+static string
+zlib (const string& s)
+{
+  mz_ulong n (mz_compressBound (static_cast<mz_ulong> (s.size ())));
+  string r (n, '\0');
+
+  int e (mz_compress (reinterpret_cast<unsigned char*> (&r[0]),
+                      &n,
+                      reinterpret_cast<const unsigned char*> (s.data ()),
+                      static_cast<mz_ulong> (s.size ())));
+  assert (e == MZ_OK);
+
+  r.resize (n);
+  return r;
+}
+
+// Raw deflate, that is, a zlib stream without its 2-byte header and
+// 4-byte Adler-32 trailer.
+//
+static string
+raw (const string& s)
+{
+  string r (zlib (s));
+  return r.substr (2, r.size () - 6);
+}
+
+static string
+gzip (const string& s, uint32_t crc_adjust = 0)
+{
+  string r ("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+  r += raw (s);
+
+  put32 (r, static_cast<uint32_t> (
+         mz_crc32 (0,
+                   reinterpret_cast<const unsigned char*> (s.data ()),
+                   s.size ())) + crc_adjust);
+  put32 (r, static_cast<uint32_t> (s.size ()));
+
+  return r;
+}
+
+static string
+big ()
+{
+  string r;
+  for (size_t i (0); i != 200000; ++i)
+    r += static_cast<char> ('a' + i * 7 % 23);
+  return r;
+}
+
+// Decode the body fed in pieces of (at most) n bytes and return what came
+// out the other end.
+//
+static string
+decode (content_decoder::coding c, const string& b, size_t n)
+{
+  string r;
+  content_decoder x (c, [&r] (const char* d, size_t s)
+  {
+    r.append (d, s);
+    return true;
+  });
+
+  for (size_t o (0); o < b.size (); o += n)
+  {
+    assert (!x.complete ());
+    assert (x.write (b.data () + o, min (n, b.size () - o)));
+  }
+
+  assert (x.complete ());
+  assert (x.size () == r.size ());
+  x.finish ();
+
+  return r;
+}
+
+static bool
+fails (content_decoder::coding c, const string& b, bool finish = false)
+{
+  content_decoder x (c, [] (const char*, size_t) {return true;});
+
+  try
+  {
+    x.write (b.data (), b.size ());
+
+    if (finish)
+      x.finish ();
+
+    return false;
+  }
+  catch (const runtime_error&)
+  {
+    return true;
+  }
+}
+
+// Content-Encoding values.
+//
+static void
+test_parse ()
+{
+  using coding = content_decoder::coding;
+
+  assert (content_decoder::parse ("gzip") == coding::gzip);
+  assert (content_decoder::parse (" GZip\t") == coding::gzip);
+  assert (content_decoder::parse ("x-gzip") == coding::gzip);
+  assert (content_decoder::parse ("Deflate") == coding::deflate);
+
+  assert (!content_decoder::parse (""));
+  assert (!content_decoder::parse ("identity"));
+  assert (!content_decoder::parse ("br"));
+  assert (!content_decoder::parse ("gzip, br"));
+}
+
+// Split writes. Whatever the network hands us, the header, data, and
+// trailer may be cut anywhere, so decode the same body with a range of
+// chunk sizes, down to a byte at a time.
+//
+static void
+test_gzip ()
+{
+  string c (big ());
+  string g (gzip (c));
+
+  for (size_t n: {size_t (1), size_t (3), size_t (29), size_t (4096),
+                  g.size ()})
+    assert (decode (content_decoder::coding::gzip, g, n) == c);
+
+  assert (decode (content_decoder::coding::gzip, gzip (""), 1).empty ());
+}
+
+// Deflate. The zlib format is what RFC 9110 means but raw deflate is what
+// some servers send, so the first two bytes decide which it is (including
+// when they arrive one at a time).
+//
+static void
+test_deflate ()
+{
+  string c (big ());
+
+  for (const string& b: {zlib (c), raw (c)})
+    for (size_t n: {size_t (1), size_t (2), size_t (3), size_t (4096),
+                    b.size ()})
+      assert (decode (content_decoder::coding::deflate, b, n) == c);
+
+  assert (decode (content_decoder::coding::deflate, zlib (""), 1).empty ());
+  assert (decode (content_decoder::coding::deflate, raw (""), 1).empty ());
+
+  // For zlib the Adler-32 trailer is checked.
+  //
+  {
+    string b (zlib (c));
+    b.back () ^= 1;
+    assert (fails (content_decoder::coding::deflate, b));
+  }
+}
+
+// Corruption and truncation.
+//
+static void
+test_corrupt ()
+{
+  using coding = content_decoder::coding;
+
+  string c (big ());
+
+  assert (fails (coding::gzip, gzip (c, 1)));
+  assert (fails (coding::gzip, "PK\x03\x04 and then some more bytes"));
+  assert (fails (coding::gzip, gzip (c) + "garbage"));
+  assert (fails (coding::deflate, zlib (c) + "garbage"));
+
+  // A body that ends early only shows up on finish().
+  //
+  {
+    string g (gzip (c));
+    g.resize (g.size () - 3);
+
+    assert (!fails (coding::gzip, g));
+    assert (fails (coding::gzip, g, true));
+  }
+
+  assert (fails (coding::deflate, "", true));
+
+  // No sink, no decoder.
+  //
+  {
+    bool thrown (false);
+    try
+    {
+      content_decoder x (coding::gzip, nullptr);
+    }
+    catch (const invalid_argument&)
+    {
+      thrown = true;
+    }
+
+    assert (thrown);
+  }
+}
+
+// A sink that has had enough stops the decoding, after which the rest of
+// the body is neither decoded nor checked.
+//
+static void
+test_stop ()
+{
+  string g (gzip (big ()));
+
+  size_t calls (0);
+  content_decoder x (content_decoder::coding::gzip,
+                     [&calls] (const char*, size_t)
+  {
+    ++calls;
+    return false;
+  });
+
+  assert (!x.write (g.data (), g.size () / 2));
+  assert (!x.write (g.data () + g.size () / 2, g.size () - g.size () / 2));
+  assert (calls == 1);
+  assert (!x.complete ());
+
+  x.finish ();
+}
+
+int
+main ()
+{
+  test_parse ();
+  test_gzip ();
+  test_deflate ();
+  test_corrupt ();
+  test_stop ();
+}
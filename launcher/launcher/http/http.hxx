@@ -6,3 +6,5 @@
 #include <launcher/http/http-client.hxx>
 #include <launcher/http/http-endpoint.hxx>
 #include <launcher/http/http-json.hxx>
+#include <launcher/http/http-cache.hxx>
+#include <launcher/http/http-decoder.hxx>
@@ -1,8 +1,14 @@
 #include <launcher/launcher-cache.hxx>
 
 #include <iostream>
+#include <exception>
+#include <type_traits>
 #include <unordered_map>
 
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+
 #include <launcher/launcher-download.hxx>
 #include <launcher/launcher-progress.hxx>
 
@@ -24,6 +30,47 @@ namespace launcher
     return os;
   }
 
+  // Call f(i) for every i in [0, n) on its own thread of the pool and return
+  // the results in order once all of them are done. If any of them threw,
+  // rethrow the first such exception.
+  //
+  template <typename F>
+  static asio::awaitable<vector<invoke_result_t<F&, size_t>>>
+  fan_out (asio::thread_pool& p, size_t n, F f)
+  {
+    using namespace asio::experimental;
+    using result = invoke_result_t<F&, size_t>;
+
+    auto op ([&p, &f] (size_t i)
+    {
+      return asio::co_spawn (p,
+                             [&f, i] () -> asio::awaitable<result>
+                             {
+                               co_return f (i);
+                             },
+                             asio::deferred);
+    });
+
+    vector<decltype (op (0))> ops;
+    ops.reserve (n);
+
+    for (size_t i (0); i != n; ++i)
+      ops.push_back (op (i));
+
+    auto [ord, exs, rs] =
+      co_await make_parallel_group (move (ops)).async_wait (
+        wait_for_all (),
+        asio::use_awaitable);
+
+    for (const auto& e: exs)
+    {
+      if (e)
+        rethrow_exception (e);
+    }
+
+    co_return move (rs);
+  }
+
   cache_result::
   cache_result ()
     : status (cache_status::up_to_date)
@@ -71,7 +118,8 @@ namespace launcher
       rec_ (make_unique<reconciler_type> (*db_, d)),
       dl_ (nullptr),
       prog_ (nullptr),
-      gh_ (nullptr)
+      gh_ (nullptr),
+      pool_ (4)
   {
   }
 
@@ -139,6 +187,35 @@ namespace launcher
     return rec_->audit (c);
   }
 
+  asio::awaitable<vector<vector<pair<cached_file, file_state>>>>
+  cache_coordinator::
+  audit (vector<component_type> cs)
+  {
+    // Only the stat()s go to the pool. The database is opened with an
+    // exclusive lock so another (pooled) connection would only find it
+    // busy, which means it may only be used from this thread.
+    //
+    vector<vector<cached_file>> fs;
+    fs.reserve (cs.size ());
+
+    for (component_type c: cs)
+      fs.push_back (database ().files (c));
+
+    co_return co_await fan_out (pool_, cs.size (), [this, &fs] (size_t i)
+    {
+      vector<pair<cached_file, file_state>> r;
+      r.reserve (fs[i].size ());
+
+      for (cached_file& f: fs[i])
+      {
+        file_state s (rec_->stat (f.path (), f));
+        r.emplace_back (move (f), s);
+      }
+
+      return r;
+    });
+  }
+
   vector<reconcile_item> cache_coordinator::
   plan (const manifest& m,
         component_type c,
@@ -227,77 +304,11 @@ namespace launcher
     co_return co_await sync (m, c, t);
   }
 
-  asio::awaitable<cache_result> cache_coordinator::
-  sync_all (const vector<tuple<manifest, component_type, string>>& is)
-  {
-    reconcile_summary total;
-    vector<reconcile_item> ais; // All items.
-
-    // Aggregate plans for all components so we can batch the downloads.
-    //
-    for (const auto& [m, c, v] : is)
-    {
-      auto cis (rec_->plan (m, c, v));
-      auto s (rec_->summarize (cis));
-
-      total.files_valid += s.files_valid;
-      total.files_stale += s.files_stale;
-      total.files_missing += s.files_missing;
-      total.downloads_required += s.downloads_required;
-      total.bytes_to_download += s.bytes_to_download;
-
-      ais.insert (ais.end (),
-                  make_move_iterator (cis.begin ()),
-                  make_move_iterator (cis.end ()));
-    }
-
-    if (total.up_to_date ())
-      co_return cache_result (cache_status::up_to_date, total);
-
-    if (dl_ == nullptr)
-      co_return cache_result (cache_status::update_failed,
-                              "download coordinator not configured");
-
-    // Queue everything up.
-    //
-    for (const auto& i : ais)
-    {
-      if (i.action != reconcile_action::download)
-        continue;
-
-      if (i.url.empty ())
-        continue;
-
-      download_request r;
-      r.urls.push_back (i.url);
-      r.target = fs::path (i.path);
-      r.name = fs::path (i.path).filename ().string ();
-      r.expected_size = i.expected_size;
-
-      dl_->queue_download (move (r));
-    }
-
-    // Run the batch.
-    //
-    co_await dl_->execute_all ();
-
-    if (dl_->failed_count () > 0)
-      co_return cache_result (cache_status::update_failed,
-                              "some downloads failed");
-
-    // If we survived the downloads, stamp all the versions in the DB.
-    //
-    for (const auto& [m, c, v] : is)
-      rec_->stamp (c, v);
-
-    co_return cache_result (cache_status::update_applied, total);
-  }
-
   void cache_coordinator::
   track (const fs::path& p,
          component_type c,
          const string& v,
-         const string& h)
+         const blake3_digest& h)
   {
     rec_->track (p, c, v, h);
   }
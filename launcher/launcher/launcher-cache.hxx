@@ -8,6 +8,7 @@
 #include <vector>
 
 #include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <launcher/cache/cache.hxx>
 
@@ -169,6 +170,12 @@ namespace launcher
     std::vector<std::pair<cached_file, file_state>>
     audit (component_type c) const;
 
+    // Same but for several components at once, each stat'ed on a thread of
+    // the compute pool. The results are in the order of the components.
+    //
+    asio::awaitable<std::vector<std::vector<std::pair<cached_file, file_state>>>>
+    audit (std::vector<component_type> cs);
+
     // Planning.
     //
 
@@ -216,17 +223,6 @@ namespace launcher
                 component_type c,
                 const std::string& tag);
 
-    // Batch processor.
-    //
-    // We chain the coroutines here to avoid the overhead of spinning up
-    // multiple execution contexts.
-    //
-    asio::awaitable<cache_result>
-    sync_all (
-      const std::vector<std::tuple<manifest,
-                                   component_type,
-                                   std::string>>& items);
-
     // Database / Tracking.
     //
 
@@ -238,7 +234,7 @@ namespace launcher
     track (const fs::path& p,
            component_type c,
            const std::string& v,
-           const std::string& h = "");
+           const blake3_digest& h = blake3_digest ());
 
     // Batch tracking for archive extraction (avoids transaction thrashing).
     //
@@ -332,5 +328,11 @@ namespace launcher
     github_coordinator* gh_ = nullptr;
 
     progress_callback cb_;
+
+    // Compute pool for component-level work (audits). Note that there is no
+    // point in making this larger than the number of components we deal
+    // with.
+    //
+    asio::thread_pool pool_;
   };
 }
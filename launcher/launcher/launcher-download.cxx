@@ -147,6 +147,18 @@ namespace launcher
     co_return;
   }
 
+  void download_coordinator::
+  hold ()
+  {
+    manager_->hold ();
+  }
+
+  void download_coordinator::
+  release ()
+  {
+    manager_->release ();
+  }
+
   void download_coordinator::
   clear ()
   {
@@ -112,6 +112,15 @@ namespace launcher
     asio::awaitable<void>
     execute_all ();
 
+    // Keep execute_all() running, starting tasks as they are queued, until
+    // released. Note that the completion counts only settle after that.
+    //
+    void
+    hold ();
+
+    void
+    release ();
+
     // Clear all tasks.
     //
     void
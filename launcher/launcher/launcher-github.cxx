@@ -11,6 +11,7 @@
 #include <launcher/github/github-api.hxx>
 #include <launcher/launcher-http.hxx>
 #include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-decoder.hxx>
 
 using namespace std;
 
@@ -42,6 +43,12 @@ namespace launcher
     api_->set_progress_callback (move (cb));
   }
 
+  void github_coordinator::
+  set_manifest_cache (manifest_cache* c)
+  {
+    cache_ = c;
+  }
+
   asio::awaitable<github_coordinator::release_type> github_coordinator::
   fetch_latest_release (const string& own,
                         const string& rep,
@@ -91,10 +98,9 @@ namespace launcher
       throw runtime_error ("manifest asset '" + n + "' not found in " +
                            r.tag_name);
 
-    // Download, parse, and then stitch the URLs.
+    // Download (or load), parse, and then stitch the URLs.
     //
-    manifest m (
-      co_await download_and_parse_manifest (a->browser_download_url, fmt));
+    manifest m (co_await load_manifest (r, *a, fmt));
 
     m.link_files ();
     resolve_manifest_urls (m, r);
@@ -116,8 +122,7 @@ namespace launcher
       throw runtime_error ("no manifest asset matching '" + pat +
                            "' found in " + r.tag_name);
 
-    manifest m (
-      co_await download_and_parse_manifest (a->browser_download_url, fmt));
+    manifest m (co_await load_manifest (r, *a, fmt));
 
     m.link_files ();
     resolve_manifest_urls (m, r);
@@ -213,13 +218,72 @@ namespace launcher
   asio::awaitable<manifest> github_coordinator::
   download_and_parse_manifest (const string& u, manifest_format fmt)
   {
-    http_coordinator h (ioc_);
-    string s (co_await h.get (u));
+    // Decode the manifest as it arrives rather than downloading it first.
+    //
+    manifest m;
+    m.kind = fmt;
 
-    if (s.empty ())
+    manifest_decoder<manifest>::stream d (m);
+    uint64_t n (0);
+
+    auto fail ([] (const exception& e)
+    {
+      return runtime_error (string ("failed to parse manifest: ") + e.what ());
+    });
+
+    http_coordinator h (ioc_);
+    co_await h.get (u, [&d, &n, &fail] (const char* p, size_t s)
+    {
+      try
+      {
+        d.write (p, s);
+      }
+      catch (const invalid_argument& e)
+      {
+        throw fail (e);
+      }
+
+      n += s;
+      return true;
+    });
+
+    if (n == 0)
       throw runtime_error ("manifest is empty");
 
-    manifest m (s, fmt);
+    try
+    {
+      d.finish ();
+    }
+    catch (const invalid_argument& e)
+    {
+      throw fail (e);
+    }
+
+    co_return m;
+  }
+
+  asio::awaitable<manifest> github_coordinator::
+  load_manifest (const release_type& r,
+                 const asset_type& a,
+                 manifest_format fmt)
+  {
+    // Release assets are immutable (replacing one gives it a new id), so
+    // the tag and asset id pin down the content.
+    //
+    string k (manifest_cache::release_key (r.tag_name, a.id));
+
+    if (cache_ != nullptr)
+    {
+      if (optional<manifest> c (cache_->load (k, fmt)))
+        co_return move (*c);
+    }
+
+    manifest m (
+      co_await download_and_parse_manifest (a.browser_download_url, fmt));
+
+    if (cache_ != nullptr)
+      cache_->save (k, m);
+
     co_return m;
   }
 
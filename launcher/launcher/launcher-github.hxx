@@ -2,6 +2,7 @@
 
 #include <launcher/github/github-api.hxx>
 #include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-cache.hxx>
 
 #include <boost/asio.hpp>
 
@@ -48,6 +49,12 @@ namespace launcher
     void
     set_progress_callback (progress_callback_type callback);
 
+    // If set, manifests are looked up here by release tag and asset before
+    // going to the network, and stored after parsing.
+    //
+    void
+    set_manifest_cache (manifest_cache* cache);
+
     // Fetch latest release.
     //
     // If include_prerelease is true, returns the most recent release
@@ -133,8 +140,16 @@ namespace launcher
     download_and_parse_manifest (const std::string& url,
                                  manifest_format kind);
 
+    // Same but go through the manifest cache, if any.
+    //
+    asio::awaitable<manifest>
+    load_manifest (const release_type& release,
+                   const asset_type& asset,
+                   manifest_format kind);
+
     asio::io_context& ioc_;
     std::unique_ptr<api_type> api_;
+    manifest_cache* cache_ = nullptr;
   };
 
   // Find all assets matching a pattern.
@@ -66,14 +66,51 @@ namespace launcher
   {
   }
 
+  void http_coordinator::
+  set_http_cache (http_cache* c) noexcept
+  {
+    cache_ = c;
+  }
+
   asio::awaitable<string> http_coordinator::
   get (const string& u)
   {
-    response_type r (co_await client_->get (u));
+    optional<http_cache::entry> c;
+
+    request_type rq (http_method::get, u);
+
+    if (cache_ != nullptr && (c = cache_->load (u)))
+    {
+      if (!c->etag.empty ())
+        rq.set_header ("If-None-Match", c->etag);
+
+      if (!c->last_modified.empty ())
+        rq.set_header ("If-Modified-Since", c->last_modified);
+    }
+
+    rq.normalize ();
+
+    response_type r (co_await client_->request (rq));
 
     if (r.is_error ())
       throw runtime_error (fmt_err (r));
 
+    // Serve 304 Not Modified from the cache and remember anything else we
+    // can make the next request conditional on.
+    //
+    if (c && r.status == http_status::not_modified)
+      co_return move (c->body);
+
+    if (cache_ != nullptr && r.is_success ())
+    {
+      http_cache::entry e;
+      e.etag = r.get_header ("ETag").value_or ("");
+      e.last_modified = r.get_header ("Last-Modified").value_or ("");
+      e.body = r.body.value_or ("");
+
+      cache_->save (u, e);
+    }
+
     // While 204 No Content is valid HTTP, for our usage here we treat a
     // missing body as an empty string for the call site.
     //
@@ -83,6 +120,18 @@ namespace launcher
     co_return *r.body;
   }
 
+  asio::awaitable<void> http_coordinator::
+  get (const string& u, sink_callback sink)
+  {
+    request_type rq (http_method::get, u);
+    rq.normalize ();
+
+    response_type r (co_await client_->request (rq, move (sink)));
+
+    if (r.is_error ())
+      throw runtime_error (fmt_err (r));
+  }
+
   asio::awaitable<http_coordinator::response_type> http_coordinator::
   get_response (const string& u)
   {
@@ -28,6 +28,10 @@ namespace launcher
       std::function<void (std::uint64_t bytes_transferred,
                           std::uint64_t total_bytes)>;
 
+    // Body sink for streamed requests.
+    //
+    using sink_callback = client_type::sink_callback;
+
     // Constructors.
     //
     explicit
@@ -39,6 +43,12 @@ namespace launcher
     http_coordinator (const http_coordinator&) = delete;
     http_coordinator& operator= (const http_coordinator&) = delete;
 
+    // Set the cache to make get() requests conditional on. If null
+    // (default), every request is a full one.
+    //
+    void
+    set_http_cache (http_cache* c) noexcept;
+
     // GET request returning body as string.
     //
     // Throws on HTTP error or network failure.
@@ -46,6 +56,14 @@ namespace launcher
     asio::awaitable<std::string>
     get (const std::string& url);
 
+    // GET request passing the body to the sink as it arrives rather than
+    // returning it. Note that it is not conditional (see set_http_cache()).
+    //
+    // Throws on HTTP error or network failure.
+    //
+    asio::awaitable<void>
+    get (const std::string& url, sink_callback sink);
+
     // GET request returning full response.
     //
     asio::awaitable<response_type>
@@ -94,5 +112,6 @@ namespace launcher
   private:
     asio::io_context& ioc_;
     std::unique_ptr<client_type> client_;
+    http_cache* cache_ = nullptr;
   };
 }
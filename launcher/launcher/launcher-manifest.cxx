@@ -5,8 +5,11 @@
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/json.hpp>
@@ -91,28 +94,33 @@ namespace launcher
     // (like "codo/") to the actual zone directory and determine where loose
     // files like .iwd or .ff should live if their path isn't explicit.
     //
-    fs::path p (f.path);
-    string ext (p.extension ().string ());
-    transform (ext.begin (), ext.end (), ext.begin (),
-               [] (unsigned char c) { return tolower (c); });
+    // Note that this is called for every entry of the manifest, so check the
+    // prefixes (which is what most paths have) before going any further.
+    //
+    const string& s (f.path);
 
     // Handle "codo/" remapping. This is a legacy artifact.
     //
-    if (f.path.find ("codo/") == 0 || f.path.find ("codo\\") == 0)
+    if (s.starts_with ("codo/") || s.starts_with ("codo\\"))
     {
-      string s (f.path);
-      s.replace (0, 5, f.path[4] == '/' ? "zone/" : "zone\\");
-      return d / s;
+      string r (s);
+      r.replace (0, 5, s[4] == '/' ? "zone/" : "zone\\");
+      return d / r;
     }
 
     // If the path has a known prefix, trust it.
     //
-    if (f.path.find ("zone/") == 0 || f.path.find ("zone\\") == 0 ||
-        f.path.find ("iw4x/") == 0 || f.path.find ("iw4x\\") == 0)
+    if (s.starts_with ("zone/") || s.starts_with ("zone\\") ||
+        s.starts_with ("iw4x/") || s.starts_with ("iw4x\\"))
     {
-      return d / f.path;
+      return d / s;
     }
 
+    fs::path p (s);
+    string ext (p.extension ().string ());
+    transform (ext.begin (), ext.end (), ext.begin (),
+               [] (unsigned char c) { return tolower (c); });
+
     // Heuristics for loose files.
     //
     if (ext == ".iwd") return d / "iw4x" / p.filename ();
@@ -124,20 +132,22 @@ namespace launcher
   fs::path manifest_coordinator::
   resolve_path (const archive_type& a, const fs::path& d)
   {
-    fs::path p (a.name);
-    string ext (p.extension ().string ());
-
-    transform (ext.begin (), ext.end (), ext.begin (),
-               [] (unsigned char c) { return tolower (c); });
+    const string& s (a.name);
 
     // Trust known prefixes.
     //
-    if (a.name.find ("zone/") == 0 || a.name.find ("zone\\") == 0 ||
-        a.name.find ("iw4x/") == 0 || a.name.find ("iw4x\\") == 0)
+    if (s.starts_with ("zone/") || s.starts_with ("zone\\") ||
+        s.starts_with ("iw4x/") || s.starts_with ("iw4x\\"))
     {
-      return d / a.name;
+      return d / s;
     }
 
+    fs::path p (s);
+    string ext (p.extension ().string ());
+
+    transform (ext.begin (), ext.end (), ext.begin (),
+               [] (unsigned char c) { return tolower (c); });
+
     // Heuristics.
     //
     if (ext == ".iwd") return d / "iw4x" / p.filename ();
@@ -153,11 +163,17 @@ namespace launcher
   // Extraction.
   //
 
-  asio::awaitable<void> manifest_coordinator::
-  extract_archive (const archive_type& a,
-                   const fs::path& ap,
-                   const fs::path& d)
+  // Extract a to d, placing the listed files at the corresponding entries of
+  // es, if any, and where resolve_path() says otherwise.
+  //
+  static void
+  extract (const manifest_archive& a,
+           const fs::path& ap,
+           const fs::path& d,
+           span<const manifest_index::entry> es)
   {
+    using mc = manifest_coordinator;
+
     if (!fs::exists (ap))
       throw runtime_error ("archive file does not exist: " + ap.string ());
 
@@ -174,8 +190,10 @@ namespace launcher
       //
       if (!a.files.empty ())
       {
-        for (const auto& f : a.files)
+        for (size_t j (0); j != a.files.size (); ++j)
         {
+          const auto& f (a.files[j]);
+
           int idx (mz_zip_reader_locate_file (&z,
                                               f.path.c_str (),
                                               nullptr,
@@ -183,7 +201,7 @@ namespace launcher
           if (idx < 0)
             continue;
 
-          fs::path out (resolve_path (f, d));
+          fs::path out (es.empty () ? mc::resolve_path (f, d) : es[j].path);
 
           if (out.has_parent_path ())
           {
@@ -217,10 +235,10 @@ namespace launcher
           if (mz_zip_reader_is_file_a_directory (&z, i))
             continue;
 
-          file_type f;
+          manifest_file f;
           f.path = st.m_filename;
 
-          fs::path out (resolve_path (f, d));
+          fs::path out (mc::resolve_path (f, d));
 
           if (out.has_parent_path ())
           {
@@ -252,10 +270,51 @@ namespace launcher
       mz_zip_reader_end (&z);
       throw;
     }
+  }
+
+  asio::awaitable<void> manifest_coordinator::
+  extract_archive (const archive_type& a,
+                   const fs::path& ap,
+                   const fs::path& d)
+  {
+    extract (a, ap, d, {});
+    co_return;
+  }
 
+  asio::awaitable<void> manifest_coordinator::
+  extract_archive (const manifest_index& ix,
+                   size_t i,
+                   const fs::path& ap,
+                   const fs::path& d)
+  {
+    extract (ix.source ().archives[i], ap, d, ix.contents (i));
     co_return;
   }
 
+  unique_ptr<zip_stream_extractor> manifest_coordinator::
+  stream_archive (const manifest_index& ix, size_t i)
+  {
+    // Only the entries the archive metadata lists are extracted, each to
+    // where the index has resolved it. Anything else in the archive is
+    // skipped, which also means an entry name never makes it into a path.
+    //
+    const archive_type& a (ix.source ().archives[i]);
+    span<const manifest_index::entry> es (ix.contents (i));
+
+    unordered_map<string_view, size_t> ps;
+    ps.reserve (a.files.size ());
+
+    for (size_t j (0); j != a.files.size (); ++j)
+      ps.emplace (a.files[j].path, j);
+
+    return make_unique<zip_stream_extractor> (
+      [ps = move (ps), es] (const string& n)
+    {
+      auto j (ps.find (n));
+      return j != ps.end () ? es[j->second].path : fs::path ();
+    });
+  }
+
   // Metrics.
   //
 
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-unzip.hxx>
+#include <launcher/manifest/manifest-decompress.hxx>
+#include <launcher/manifest/manifest-diff.hxx>
+#include <launcher/manifest/manifest-index.hxx>
 
 #include <boost/asio.hpp>
 
@@ -80,6 +84,29 @@ namespace launcher
                      const fs::path& archive_path,
                      const fs::path& install_dir);
 
+    // Same but for the archive at position i in the index, extracting its
+    // files to where the index has resolved them.
+    //
+    static asio::awaitable<void>
+    extract_archive (const manifest_index& ix,
+                     std::size_t i,
+                     const fs::path& archive_path,
+                     const fs::path& install_dir);
+
+    // Create a streaming extractor for the archive at position i in the
+    // index.
+    //
+    // The archive must list its files: the extractor places exactly those
+    // entries where extract_archive() would, so the two are interchangeable.
+    // Feed it the archive bytes as they are downloaded and, if it reports a
+    // fallback (or the transfer fails), download the archive and use
+    // extract_archive() instead.
+    //
+    // Note that the extractor refers to the index which must outlive it.
+    //
+    static std::unique_ptr<zip_stream_extractor>
+    stream_archive (const manifest_index& ix, std::size_t i);
+
     // Get file count.
     //
     // Returns the total number of files in the manifest (including files
@@ -40,6 +40,7 @@ namespace launcher
   set_current_version (const version_type& v)
   {
     current_version_ = v;
+    installer_->set_current_version (v);
   }
 
   void update_coordinator::
@@ -51,6 +52,7 @@ namespace launcher
       throw invalid_argument ("failed to parse version: " + s);
 
     current_version_ = *v;
+    installer_->set_current_version (*v);
   }
 
   void update_coordinator::
@@ -1,11 +1,15 @@
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <functional>
 
 #include <boost/asio.hpp>
 #include <boost/asio/co_spawn.hpp>
@@ -198,20 +202,79 @@ namespace launcher
     return d;
   }
 
+  // Install the update that check_for_updates() found and try to restart
+  // into it.
+  //
+  // Returns true if the launcher is restarting (caller should exit), false
+  // otherwise. If `pc` is provided, it is started to display the download
+  // progress.
+  //
+  asio::awaitable<bool>
+  install_self_update (update_coordinator& uc, progress_coordinator* pc)
+  {
+    // An update is available. Now we can start the UI if requested.
+    //
+    launcher::log::info (categories::launcher{}, "launcher update available, proceeding with installation");
+    if (pc != nullptr)
+    {
+      uc.set_progress_coordinator (pc);
+      pc->start ();
+    }
+
+    // Proceed to install the update.
+    //
+    const auto& info (uc.last_update_info ());
+
+    cout << "launcher update available: " << info.version
+         << " (current: " << uc.current_version () << ")" << endl;
+
+    if (!info.body.empty ())
+      cout << "Release notes:\n" << info.body << "\n" << endl;
+
+    auto r (co_await uc.install_update (info));
+
+    if (!r.success)
+    {
+      launcher::log::error (categories::launcher{}, "update failed to install: {}", r.error_message);
+      cerr << "error: update failed: " << r.error_message << endl;
+      co_return false;
+    }
+
+    // Try to restart into the new version.
+    //
+    if (uc.restart ())
+    {
+      launcher::log::info (categories::launcher{}, "restarting into new launcher version");
+      co_return true;
+    }
+
+    launcher::log::warning (categories::launcher{}, "update successful but auto-restart failed");
+    cerr << "warning: failed to restart launcher automatically" << endl;
+    cout << "please restart the launcher manually." << endl;
+
+    co_return false;
+  }
+
   // Aggregates all the configuration options, environment paths, and flags
   // derived from CLI arguments and platform detection, so we can pass them
   // around as a single unit.
   //
   struct runtime_context
   {
-    fs::path       install_location;
-    string         upstream_owner;
-    string         upstream_repo;
-    bool           prerelease;
-    size_t         concurrency_limit;
-    fs::path       proton_binary;
-    vector<string> proton_arguments;
-    bool           skip_launch;
+    fs::path        install_location;
+    string          upstream_owner;
+    string          upstream_repo;
+    bool            prerelease;
+    size_t          concurrency_limit;
+    fs::path        proton_binary;
+    vector<string>  proton_arguments;
+    bool            skip_launch;
+    bool            self_update;
+    chrono::seconds metadata_ttl;
+    uint64_t        stall_rate;
+    chrono::seconds stall_time;
+    download_schedule schedule;
+    bool            critical_path;
   };
 
   // Aggregates remote state required for synchronization.
@@ -222,8 +285,74 @@ namespace launcher
     github_release raw;
     github_release helper;
     string dlc_manifest_json;
+
+    // Whether there is a launcher update (up_to_date if we didn't check).
+    //
+    update_status launcher {update_status::up_to_date};
+
+    // Failure to fetch the release state, if any, in which case the above
+    // is all there is (see fetch_remote_state()).
+    //
+    exception_ptr error;
   };
 
+  // Serialize the remote state for the release metadata cache, along with
+  // the time it was fetched.
+  //
+  // Note that the launcher update status is not included: it only makes
+  // sense at the time of the check.
+  //
+  static string
+  serialize_remote_state (const remote_state& s,
+                          chrono::system_clock::time_point t)
+  {
+    using traits = github_api_traits;
+
+    json::object o;
+    o["fetched"] = chrono::duration_cast<chrono::seconds> (
+      t.time_since_epoch ()).count ();
+    o["client"] = traits::to_json (s.client);
+    o["raw"] = traits::to_json (s.raw);
+    o["helper"] = traits::to_json (s.helper);
+    o["dlc_manifest"] = s.dlc_manifest_json;
+
+    return json::serialize (o);
+  }
+
+  // Parse what serialize_remote_state() produced, returning nullopt if it is
+  // unusable (for example, written by a different version).
+  //
+  static optional<pair<remote_state, chrono::system_clock::time_point>>
+  parse_remote_state (const string& v)
+  {
+    using traits = github_api_traits;
+
+    try
+    {
+      json::value jv (json::parse (v));
+      const json::object& o (jv.as_object ());
+
+      remote_state s;
+      s.client = traits::parse_release (o.at ("client"));
+      s.raw = traits::parse_release (o.at ("raw"));
+      s.helper = traits::parse_release (o.at ("helper"));
+      s.dlc_manifest_json = json::value_to<string> (o.at ("dlc_manifest"));
+
+      if (s.client.empty () || s.raw.empty ())
+        return nullopt;
+
+      chrono::system_clock::time_point t (
+        chrono::seconds (json::value_to<int64_t> (o.at ("fetched"))));
+
+      return make_pair (move (s), t);
+    }
+    catch (const exception& e)
+    {
+      launcher::log::warning (categories::launcher{}, "ignoring unusable cached release metadata: {}", e.what ());
+      return nullopt;
+    }
+  }
+
   // Main controller for the bootstrap process.
   //
   class launcher_controller
@@ -236,7 +365,10 @@ namespace launcher
         http_ (ioc_),
         downloads_ (ioc_, ctx_.concurrency_limit),
         progress_ (ioc_),
-        cache_ (ioc_, ctx_.install_location)
+        cache_ (ioc_, ctx_.install_location),
+        manifests_ (resolve_cache_root () / "manifests"),
+        responses_ (resolve_cache_root () / "http"),
+        refreshed_ (ioc_, asio::steady_timer::time_point::max ())
     {
       launcher::log::trace_l2 (categories::launcher{}, "initializing launcher_controller");
 
@@ -251,6 +383,53 @@ namespace launcher
       cache_.set_github_coordinator (&github_);
       cache_.set_download_coordinator (&downloads_);
       cache_.set_progress_coordinator (&progress_);
+
+      // Restart a stalled download, at least once it holds up the batch.
+      //
+      // Note that we don't rank mirrors or hedge stalled transfers (see
+      // set_mirror_ranking() and set_hedging()): every asset currently comes
+      // from a single URL so there is nothing to rank or race.
+      //
+      downloads_.manager ().set_schedule (ctx_.schedule);
+
+      // Journal partial downloads so that the next run can resume them
+      // without reading back what made it to the disk.
+      //
+      downloads_.manager ().set_journal (&journal_);
+
+      if (ctx_.stall_time.count () != 0)
+        downloads_.manager ().set_stall_detection (ctx_.stall_rate,
+                                                   ctx_.stall_time);
+
+      github_.set_manifest_cache (&manifests_);
+
+      // Release metadata and update.json rarely change between launches so
+      // make those requests conditional.
+      //
+      github_.api ().set_http_cache (&responses_);
+      http_.set_http_cache (&responses_);
+
+      // The launcher update check goes to the same API host as the rest of
+      // the remote state so we do it along with it (see
+      // resolve_remote_state()).
+      //
+      if (ctx_.self_update)
+      {
+        updates_ = make_update_coordinator (ioc_);
+        updates_->set_include_prerelease (ctx_.prerelease);
+        updates_->discovery ().api ().set_http_cache (&responses_);
+
+        // Send the update check over the same (pooled) connections to the
+        // API host as the rest.
+        //
+        updates_->discovery ().api ().set_http_client (&github_.api ().client ());
+
+        updates_->discovery ().set_progress_callback (
+          [this] (const string& message, uint64_t seconds_remaining)
+        {
+          this->handle_rate_limit_progress (message, seconds_remaining);
+        });
+      }
     }
 
     asio::awaitable<int>
@@ -261,20 +440,76 @@ namespace launcher
       launcher::log::trace_l1 (categories::launcher{}, "resolving remote state...");
       remote_state remote (co_await resolve_remote_state ());
 
+      // If there is a newer launcher, switch to it before touching anything
+      // else since it may well reconcile differently.
+      //
+      if (remote.launcher == update_status::update_available &&
+          co_await update_launcher ())
+      {
+        launcher::log::info (categories::launcher{}, "self update completed, terminating current process");
+        co_return 0;
+      }
+
+      if (remote.launcher == update_status::check_failed)
+        cerr << "warning: update check failed" << endl;
+
+      if (remote.error)
+        rethrow_exception (remote.error);
+
       launcher::log::trace_l1 (categories::launcher{}, "reconciling artifacts against remote state...");
       co_await reconcile_artifacts (remote);
 
       if (ctx_.skip_launch)
       {
         launcher::log::info (categories::launcher{}, "updates completed, skipping game launch as requested and exiting");
+        co_await await_refresh ();
         co_return 0;
       }
 
       launcher::log::trace_l1 (categories::launcher{}, "executing payload...");
-      co_return co_await execute_payload ();
+      int r (co_await execute_payload ());
+
+      co_await await_refresh ();
+      co_return r;
     }
 
   private:
+    // Resolve upstream metadata.
+    //
+    // If the release metadata cache is enabled (--metadata-ttl) and what we
+    // fetched on a previous run is still within the window, use it as is and
+    // go straight to the audit, refreshing the cache in the background for
+    // the next run. Otherwise, fetch and, if enabled, cache it.
+    //
+    // Note that while we go by the cache, the launcher update check happens
+    // in the background refresh, by which time it is too late to switch.
+    // So a launcher update (like a new client release) is only acted upon
+    // by the next run (see refresh_remote_state()).
+    //
+    asio::awaitable<remote_state>
+    resolve_remote_state ()
+    {
+      if (ctx_.metadata_ttl.count () == 0)
+        co_return co_await fetch_remote_state ();
+
+      if (auto c = load_remote_state ())
+      {
+        launcher::log::info (categories::launcher{}, "using cached release metadata, refreshing in background");
+
+        refreshing_ = true;
+        asio::co_spawn (ioc_, refresh_remote_state (), asio::detached);
+
+        co_return move (*c);
+      }
+
+      remote_state r (co_await fetch_remote_state ());
+
+      if (!r.error)
+        store_remote_state (r);
+
+      co_return r;
+    }
+
     // Fetch upstream metadata.
     //
     // We use make_parallel_group to launch requests concurrently. This allows
@@ -284,8 +519,16 @@ namespace launcher
     // Note that we force pre-release semantics for the steam helper (passed
     // as 'true') because it is strictly a beta component.
     //
+    // Failing to fetch any part of the release state is fatal but the
+    // launcher update check doesn't depend on it and a newer launcher may
+    // well be what fixes it. So instead of throwing we return the error
+    // along with the update status for the caller to act on both.
+    //
+    // Note also that this is called in the background (see
+    // refresh_remote_state()) and so only logs.
+    //
     asio::awaitable<remote_state>
-    resolve_remote_state ()
+    fetch_remote_state ()
     {
       launcher::log::trace_l2 (categories::launcher{}, "launching parallel requests for remote state (owner: {}, repo: {}, pre: {})",
                                ctx_.upstream_owner, ctx_.upstream_repo, ctx_.prerelease);
@@ -305,9 +548,9 @@ namespace launcher
       // a fixed order, even though only the results are ultimately used.
       //
 #ifdef __linux__
-      auto [ord, ex_c, c, ex_r, r, ex_h, h, ex_d, d] =
+      auto [ord, ex_c, c, ex_r, r, ex_h, h, ex_d, d, ex_u, u] =
 #else
-      auto [ord, ex_c, c, ex_r, r, ex_d, d] =
+      auto [ord, ex_c, c, ex_r, r, ex_d, d, ex_u, u] =
 #endif
         co_await make_parallel_group (
           asio::co_spawn (
@@ -336,44 +579,270 @@ namespace launcher
             {
               co_return co_await http_.get ("https://cdn.iw4x.io/update.json");
             }(),
+            asio::deferred),
+          asio::co_spawn (
+            ioc_,
+            [this] () -> asio::awaitable<update_status>
+            {
+              if (!updates_)
+                co_return update_status::up_to_date;
+
+              co_return co_await updates_->check_for_updates ();
+            }(),
             asio::deferred)
         ).async_wait (wait_for_all (), asio::use_awaitable);
 
+      exception_ptr ex;
+
       if (ex_c)
       {
         launcher::log::error (categories::launcher{}, "failed to resolve client release state");
-        rethrow_exception (ex_c);
+        ex = ex_c;
       }
-
-      if (ex_r)
+      else if (ex_r)
       {
         launcher::log::error (categories::launcher{}, "failed to resolve rawfiles release state");
-        rethrow_exception (ex_r);
+        ex = ex_r;
       }
-
 #ifdef __linux__
-      if (ex_h)
+      else if (ex_h)
       {
         launcher::log::error (categories::launcher{}, "failed to resolve launcher-steam release state");
-        rethrow_exception (ex_h);
+        ex = ex_h;
       }
 #endif
-
-      if (ex_d)
+      else if (ex_d)
       {
         launcher::log::error (categories::launcher{}, "failed to resolve dlc manifest");
-        rethrow_exception (ex_d);
+        ex = ex_d;
+      }
+
+      // Unlike the above, failing to check for a launcher update is not
+      // fatal: we just carry on with the one we have.
+      //
+      if (ex_u)
+      {
+        try
+        {
+          rethrow_exception (ex_u);
+        }
+        catch (const exception& e)
+        {
+          launcher::log::warning (categories::launcher{}, "update check failed with exception: {}", e.what ());
+        }
+
+        u = update_status::check_failed;
+      }
+
+      if (ex)
+      {
+        remote_state s;
+        s.launcher = u;
+        s.error = ex;
+        co_return s;
       }
 
       launcher::log::info (categories::launcher{}, "resolved all remote states");
 
 #ifdef __linux__
-      co_return remote_state {move (c), move (r), move (h), move (d)};
+      co_return remote_state {move (c), move (r), move (h), move (d), u};
 #else
-      co_return remote_state {move (c), move (r), {}, move (d)};
+      co_return remote_state {move (c), move (r), {}, move (d), u};
 #endif
     }
 
+    // Return the cached remote state if it is still within the freshness
+    // window.
+    //
+    optional<remote_state>
+    load_remote_state ()
+    {
+      string v (cache_.database ().setting_value (metadata_key ()));
+
+      if (v.empty ())
+        return nullopt;
+
+      auto c (parse_remote_state (v));
+
+      if (!c)
+        return nullopt;
+
+      // Note that a fetch time in the future means the clock was changed in
+      // which case we can't tell how old it is.
+      //
+      auto a (chrono::system_clock::now () - c->second);
+
+      if (a < chrono::seconds (0) || a >= ctx_.metadata_ttl)
+      {
+        launcher::log::debug (categories::launcher{}, "cached release metadata is stale ({}s old)",
+                              chrono::duration_cast<chrono::seconds> (a).count ());
+        return nullopt;
+      }
+
+      return move (c->first);
+    }
+
+    void
+    store_remote_state (const remote_state& r)
+    {
+      cache_.database ().setting (
+        metadata_key (),
+        serialize_remote_state (r, chrono::system_clock::now ()));
+    }
+
+    // Load the download journal from the last run and hook it up to the
+    // database. Entries whose target is gone are of no use (and the
+    // download, if it is still needed, starts from scratch anyway). This is
+    // best-effort: without the journal we resume by hashing the partial
+    // file instead.
+    //
+    void
+    load_journal ()
+    {
+      if (!journal_.empty ())
+        return;
+
+      try
+      {
+        vector<download_journal::entry> es;
+        vector<string> gone;
+
+        for (const journaled_download& j: cache_.database ().journal ())
+        {
+          error_code ec;
+          if (!fs::exists (j.target (), ec))
+          {
+            gone.push_back (j.target ());
+            continue;
+          }
+
+          const vector<char>& st (j.state ());
+
+          es.push_back (download_journal::entry {j.url (),
+                                                 j.target (),
+                                                 j.size (),
+                                                 j.hash (),
+                                                 j.confirmed (),
+                                                 string (st.begin (), st.end ()),
+                                                 j.etag ()});
+        }
+
+        journal_.load (move (es));
+        cache_.database ().journal ({}, gone);
+      }
+      catch (const exception& e)
+      {
+        launcher::log::warning (categories::launcher{}, "ignoring unusable download journal: {}", e.what ());
+      }
+
+      journal_.set_store (
+        [this] (const vector<download_journal::entry>& us,
+                const vector<string>& es)
+      {
+        try
+        {
+          vector<journaled_download> js;
+          js.reserve (us.size ());
+
+          for (const auto& e: us)
+            js.emplace_back (e.target,
+                             e.url,
+                             e.size,
+                             e.hash,
+                             e.confirmed,
+                             vector<char> (e.state.begin (), e.state.end ()),
+                             e.etag);
+
+          cache_.database ().journal (js, es);
+        }
+        catch (const exception& e)
+        {
+          launcher::log::warning (categories::launcher{}, "failed to store download journal: {}", e.what ());
+        }
+      });
+    }
+
+    string
+    metadata_key () const
+    {
+      return setting_keys::release_metadata (ctx_.upstream_owner,
+                                             ctx_.upstream_repo,
+                                             ctx_.prerelease);
+    }
+
+    // Refetch the remote state we took from the cache for the next run.
+    //
+    // This runs while we reconcile and the game is on screen, so all it does
+    // is log and keep the result: it is only written to the cache by
+    // await_refresh(), once the reconciler is done with the database.
+    //
+    asio::awaitable<void>
+    refresh_remote_state ()
+    {
+      try
+      {
+        refresh_result_ = co_await fetch_remote_state ();
+      }
+      catch (const exception& e)
+      {
+        launcher::log::warning (categories::launcher{}, "failed to refresh cached release metadata: {}", e.what ());
+      }
+
+      refreshing_ = false;
+      refreshed_.cancel ();
+    }
+
+    // Wait for the background refresh, if any, to complete and store its
+    // result. This is best-effort: the worst that can happen is that the
+    // next run has to wait for the network.
+    //
+    // If the refresh found a launcher update, we drop the cached state
+    // rather than refresh it. Otherwise the next run would go by the cache
+    // again, never getting to install it (and, with each refresh restarting
+    // the window, neither would any run after it).
+    //
+    // Note that the io_context is stopped once we return from run() so we
+    // have to wait for the refresh before doing so.
+    //
+    asio::awaitable<void>
+    await_refresh ()
+    {
+      if (refreshing_)
+      {
+        launcher::log::trace_l2 (categories::launcher{}, "waiting for release metadata refresh to complete");
+
+        boost::system::error_code ec;
+        co_await refreshed_.async_wait (
+          asio::redirect_error (asio::use_awaitable, ec));
+      }
+
+      if (!refresh_result_)
+        co_return;
+
+      remote_state r (move (*refresh_result_));
+      refresh_result_.reset ();
+
+      try
+      {
+        if (r.launcher == update_status::update_available)
+        {
+          cache_.database ().erase_setting (metadata_key ());
+          launcher::log::info (categories::launcher{}, "launcher update available, dropping cached release metadata");
+        }
+        else if (r.error)
+          rethrow_exception (r.error);
+        else
+        {
+          store_remote_state (r);
+          launcher::log::debug (categories::launcher{}, "refreshed cached release metadata");
+        }
+      }
+      catch (const exception& e)
+      {
+        launcher::log::warning (categories::launcher{}, "failed to refresh cached release metadata: {}", e.what ());
+      }
+    }
+
     asio::awaitable<void>
     reconcile_artifacts (const remote_state& r)
     {
@@ -403,9 +872,19 @@ namespace launcher
       if (!c_out && !r_out && !h_out)
       {
         launcher::log::trace_l2 (categories::launcher{}, "tags match remote, performing deep audit of local files");
-        auto valid ([this] (ct t)
+
+        // Audit the components concurrently since each is a stat of every
+        // file it has.
+        //
+        vector<ct> cs {ct::client, ct::rawfiles};
+    #ifdef __linux__
+        cs.push_back (ct::helper);
+    #endif
+
+        auto as (co_await cache_.audit (std::move (cs)));
+
+        auto valid ([] (const auto& s)
         {
-          auto s (cache_.audit (t));
           return std::all_of (s.begin (), s.end (), [] (const auto& p)
           {
             return p.second == fs_st::valid;
@@ -414,12 +893,7 @@ namespace launcher
 
         // If tags match and physical files are valid, we can short-circuit.
         //
-        if (valid (ct::client) &&
-            valid (ct::rawfiles)
-    #ifdef __linux__
-            && valid (ct::helper)
-    #endif
-        )
+        if (std::all_of (as.begin (), as.end (), valid))
         {
           launcher::log::info (categories::launcher{}, "all components physically valid and up-to-date. skipping reconcile.");
           co_return;
@@ -450,22 +924,38 @@ namespace launcher
       // all known hashes from both sources so we can attach integrity data to
       // the assets we are about to inject.
       //
-      unordered_map<string, manifest::hash_type> hashes;
+      // Note that the indices below are views into the two manifests rather
+      // than copies of their (potentially tens of thousands of) names. This
+      // means we have to make room for all the release assets we inject into
+      // m up front since growing its archives would pull the names from
+      // under them.
+      //
+      m.archives.reserve (m.archives.size () +
+                          r.raw.assets.size () +
+                          r.helper.assets.size ());
+
+      auto leaf ([] (sv p)
+      {
+        auto i (p.find_last_of ("/\\"));
+        return i != sv::npos ? p.substr (i + 1) : p;
+      });
+
+      unordered_map<sv, manifest::hash_type> hashes;
       hashes.reserve (m.files.size () + raw.files.size ());
 
-      auto idx ([&hashes] (const manifest& x)
+      auto idx ([&hashes, &leaf] (const manifest& x)
       {
         for (const auto& a : x.archives)
-          if (!a.name.empty () && !a.hash.value.empty ())
+          if (!a.name.empty () && !a.hash.empty ())
             hashes[a.name] = a.hash;
 
         for (const auto& f : x.files)
         {
-          if (f.path.empty () || f.hash.value.empty ())
+          if (f.path.empty () || f.hash.empty ())
             continue;
 
           hashes[f.path] = f.hash;
-          hashes[fs::path (f.path).filename ().string ()] = f.hash;
+          hashes[leaf (f.path)] = f.hash;
         }
       });
 
@@ -476,16 +966,21 @@ namespace launcher
       // We need quick lookups for raw structure to map assets to their
       // internal metadata.
       //
-      unordered_map<sv, const ma*> raw_archs;
-      for (const auto& a : raw.archives) raw_archs[a.name] = &a;
+      // The raw manifest is not needed past this point so the (bulky) file
+      // and chunk lists are moved rather than copied into the archives we
+      // inject. An entry is dropped from its index once it has been moved
+      // from.
+      //
+      unordered_map<sv, ma*> raw_archs;
+      for (auto& a : raw.archives) raw_archs[a.name] = &a;
 
-      unordered_map<string, const manifest_file*> raw_files;
-      for (const auto& f : raw.files)
+      unordered_map<sv, manifest_file*> raw_files;
+      for (auto& f : raw.files)
       {
         if (f.archive_name) continue;
 
         if (f.asset_name) raw_files[*f.asset_name] = &f;
-        else raw_files[fs::path (f.path).filename ().string ()] = &f;
+        else raw_files[leaf (f.path)] = &f;
       }
 
       unordered_map<sv, const ga*> c_assets;
@@ -506,14 +1001,32 @@ namespace launcher
           x.url = a.browser_download_url;
           x.size = a.size;
 
+          // Note that for a compressed asset the GitHub size is that of the
+          // compressed bytes, while what we verify on disk is the manifest's
+          // (decompressed) size.
+          //
           if (auto it (raw_archs.find (a.name)); it != raw_archs.end ())
           {
             x.hash = it->second->hash;
-            x.files = it->second->files;
+            x.files = std::move (it->second->files);
+            x.chunks = std::move (it->second->chunks);
+            x.compression = it->second->compression;
+
+            if (x.compression == compression_type::gzip)
+              x.size = it->second->size;
+
+            raw_archs.erase (it);
           }
           else if (auto it (raw_files.find (a.name)); it != raw_files.end ())
           {
             x.hash = it->second->hash;
+            x.chunks = std::move (it->second->chunks);
+            x.compression = it->second->compression;
+
+            if (x.compression == compression_type::gzip)
+              x.size = it->second->size;
+
+            raw_files.erase (it);
           }
           else if (auto it (hashes.find (a.name)); it != hashes.end ())
           {
@@ -524,7 +1037,6 @@ namespace launcher
         }
       });
 
-      m.archives.reserve (m.archives.size () + r.raw.assets.size ());
       inject (r.raw.assets);
 
     #ifdef __linux__
@@ -539,62 +1051,115 @@ namespace launcher
       if (!r.dlc_manifest_json.empty ())
       {
         launcher::log::trace_l3 (categories::launcher{}, "parsing and injecting dlc manifest assets");
-        manifest dlc (r.dlc_manifest_json, manifest_format::dlc);
+        // We have to fetch the DLC manifest regardless (there is no tag to
+        // go by), but if its content is unchanged we can skip the parse.
+        //
+        string k (manifest_cache::content_key (r.dlc_manifest_json));
+        optional<manifest> c (manifests_.load (k, manifest_format::dlc));
+
+        if (!c)
+        {
+          c = manifest (r.dlc_manifest_json, manifest_format::dlc);
+          manifests_.save (k, *c);
+        }
+
+        // Past this point we own the parsed manifest outright (it has been
+        // saved) so move the paths over instead of copying them.
+        //
+        manifest& dlc (*c);
         m.archives.reserve (m.archives.size () + dlc.files.size ());
 
         // DLCs are treated as archives for download.
         //
-        for (const auto& f : dlc.files)
+        for (auto& f : dlc.files)
         {
           if (f.path.empty ()) continue;
 
           ma x;
-          x.name = f.path;
           x.url = "https://cdn.iw4x.io/" + f.path;
+          x.name = std::move (f.path);
           x.size = f.size;
           x.hash = f.hash;
+          x.compression = f.compression;
 
           m.archives.push_back (std::move (x));
         }
       }
 
-      // Ask the reconciler what actually needs to be done based on the
-      // assembled manifest.
+      // The assembled manifest we last installed is keyed by the tags we
+      // stamped it with.
       //
-      launcher::log::trace_l2 (categories::launcher{}, "planning reconciliation against local cache...");
-      auto plan (cache_.get_reconciler ().plan (m, ct::client, r.client.tag_name));
-      launcher::log::debug (categories::launcher{}, "reconciler produced a plan with {} items", plan.size ());
+      auto installed ([this] ()
+      {
+        auto v ([this] (ct t) {return cache_.version (t).value_or ("");});
 
-      unordered_map<sv, const manifest_file*> m_files;
-      for (const auto& f : m.files)
-        if (f.asset_name) m_files[*f.asset_name] = &f;
+        return "installed:" + v (ct::client) + ':' + v (ct::rawfiles) + ':' +
+               v (ct::helper);
+      });
 
-      // The reconciler doesn't know about GitHub URLs, so we patch
-      // them back into the plan.
+      auto& rec (cache_.get_reconciler ());
+
+      // If we are moving from one release to another and still have the
+      // manifest we installed, diff the two so that only what changed goes
+      // through planning. Entries that are the same are simply carried over
+      // to the new version and the ones that are gone are dropped from the
+      // db right away.
+      //
+      // Otherwise (fresh install or an audit failure on the same tags) plan
+      // against the whole manifest.
       //
-      for (auto& item : plan)
+      manifest delta;
+      bool diffed (false);
+
+      if ((c_out || r_out || h_out) && cache_.version (ct::client))
       {
-        if (item.action != reconcile_action::download || !item.url.empty ())
-          continue;
+        if (auto p = manifests_.load (installed (), manifest_format::update))
+        {
+          p->link_files ();
 
-        fs::path p (item.path);
-        string fn (p.filename ().string ());
+          manifest_diff d (diff_manifests (*p, m));
 
-        if (m_files.count (fn))
-        {
-          if (auto it (c_assets.find (fn)); it != c_assets.end ())
-          {
-            item.url = it->second->browser_download_url;
-            launcher::log::trace_l3 (categories::launcher{}, "patched URL for {}: {}", fn, item.url);
-          }
+          rec.clean (d, ct::client);
+          rec.carry (d.unchanged, ct::client, r.client.tag_name);
+
+          delta = d.delta ();
+          diffed = true;
         }
       }
 
-      auto sum (cache_.get_reconciler ().summarize (plan));
-      launcher::log::info (categories::launcher{}, "reconcile summary: {} missing, {} stale, {} to download ({} bytes)",
-                           sum.files_missing, sum.files_stale, sum.downloads_required, sum.bytes_to_download);
+      const manifest& pm (diffed ? delta : m);
 
-      auto stamp ([this, &r] ()
+      // Resolve where everything goes once and share it between planning,
+      // downloading, and extraction. Note that everything we act on below
+      // comes from the plan and so is in pm.
+      //
+      manifest_index ix (rec.index (pm));
+
+      // The reconciler doesn't know about GitHub URLs, so we look up those
+      // of standalone files in the release assets as we go.
+      //
+      using pk = reconcile_plan::kind;
+
+      auto url ([&ix, &c_assets] (const reconcile_plan& p,
+                                  const reconcile_plan::entry& e) -> const string&
+      {
+        const string& u (p.url (e));
+
+        if (!u.empty () || e.what != pk::file)
+          return u;
+
+        sv fn (ix.file (e.index).name);
+
+        if (ix.find_asset (fn))
+        {
+          if (auto i (c_assets.find (fn)); i != c_assets.end ())
+            return i->second->browser_download_url;
+        }
+
+        return u;
+      });
+
+      auto stamp ([this, &r, &m, &installed] ()
       {
         launcher::log::trace_l2 (categories::launcher{}, "stamping cache with updated tags");
         cache_.stamp (ct::client, r.client.tag_name);
@@ -602,34 +1167,114 @@ namespace launcher
     #ifdef __linux__
         cache_.stamp (ct::helper, r.helper.tag_name);
     #endif
+
+        // Keep what we just installed around for the next diff.
+        //
+        manifests_.save (installed (), m);
       });
 
-      if (sum.up_to_date ())
+      const auto& root (ctx_.install_location);
+
+      // Match plan items back to their archives.
+      //
+      auto archive ([&ix] (const string& p) -> const ma*
       {
-        launcher::log::info (categories::launcher{}, "plan summary indicates up-to-date. stamping tags and finishing reconcile.");
-        stamp ();
-        co_return;
-      }
+        auto i (ix.find_archive (p));
+        return i ? &ix.source ().archives[*i] : nullptr;
+      });
+
+      // Archives that are extracted while they download, keyed by plan path.
+      //
+      unordered_map<string, unique_ptr<zip_stream_extractor>> streams;
+
+      // Compressed assets are decompressed to their target as they download.
+      // Returns false if the request is not for one.
+      //
+      // Note that a delta plan describes the decompressed file and so is
+      // meaningless against the compressed asset. The same goes for the
+      // download layer's verification, which never sees the target when a
+      // sink is set, so the decompressor checks the manifest hash itself.
+      //
+      unordered_map<string, unique_ptr<stream_decompressor>> decoders;
+
+      auto decode ([&archive, &decoders] (download_request& rq)
+      {
+        const ma* a (archive (rq.target.string ()));
+        if (a == nullptr || !stream_decompressor::supported (a->compression))
+          return false;
+
+        // Drop any previous attempt first since it cleans up the same
+        // temporary file we are about to open.
+        //
+        decoders.erase (rq.target.string ());
+
+        auto x (make_unique<stream_decompressor> (a->compression,
+                                                  rq.target,
+                                                  a->hash.value));
+
+        rq.chunks.clear ();
+        rq.sink = [p = x.get ()] (const char* d, std::size_t n)
+        {
+          return p->write (d, n);
+        };
+
+        decoders[rq.target.string ()] = std::move (x);
+        return true;
+      });
 
       // Execute downloads. We map the active task to its progress entry so we
       // can update the UI and clean up finished tasks in the loop.
       //
       unordered_map<shared_ptr<download_coordinator::task_type>,
                     shared_ptr<progress_entry>> tasks;
-      tasks.reserve (plan.size ());
+
+      // Every task we queued along with what it is for. Unlike the above,
+      // this survives until we are done retrying.
+      //
+      vector<pair<shared_ptr<download_coordinator::task_type>,
+                  reconcile_plan::entry>> issued;
 
       // Count how many downloads we actually need.
       //
       std::size_t download_count (0);
 
-      for (const auto& item : plan)
+      // With the critical path policy, start the files the game can't be
+      // launched without ahead of the rest so that a short transfer doesn't
+      // end up queued behind the bulk of the assets.
+      //
+      auto priority ([this] (const fs::path& f)
       {
-        if (item.action != reconcile_action::download || item.url.empty ())
-          continue;
+        if (ctx_.critical_path)
+        {
+          string n (f.filename ().string ());
 
-        ++download_count;
+          if (n == ctx_.proton_binary.filename ().string () ||
+              n == "steam.exe"                                ||
+              n == "steam_api64.dll")
+            return download_priority::critical;
+        }
+
+        return download_priority::normal;
+      });
+
+      auto queue ([&] (const reconcile_plan& rp,
+                       const reconcile_plan::entry& item,
+                       span<const reconcile_chunk> cs)
+      {
+        if (item.action != reconcile_action::download)
+          return;
+
+        const string& u (url (rp, item));
+
+        if (u.empty ())
+          return;
 
-        fs::path dst (item.path);
+        // Only show the progress UI if there are actual downloads.
+        //
+        if (download_count++ == 0)
+          progress_.start ();
+
+        fs::path dst (rp.path (item));
         if (dst.has_parent_path ())
         {
           std::error_code ec;
@@ -637,35 +1282,130 @@ namespace launcher
         }
 
         download_request req;
-        req.urls.push_back (item.url);
+        req.urls.push_back (u);
         req.target = dst;
         req.name = dst.filename ().string ();
-        req.expected_size = item.expected_size;
+        req.expected_size = rp.size (item);
+        req.priority = priority (dst);
+
+        // The download layer checks the result against the manifest hash so
+        // that a completed task means a good file. Also, the same content
+        // may well be listed under several paths, in which case it only has
+        // to come over the wire once.
+        //
+        req.content = rp.hash (item);
+
+        for (const auto& c : cs)
+          req.chunks.push_back ({c.offset, c.size, c.source});
+
+        // Exploded archives are inflated straight to their final location as
+        // the bytes arrive. Blob archives are left alone since there the
+        // archive itself is the artifact we track.
+        //
+        if (!decode (req) &&
+            (dst.extension () == ".zip" || dst.extension () == ".ZIP"))
+        {
+          auto i (ix.find_archive (dst.string ()));
+          if (i && !ix.source ().archives[*i].files.empty ())
+          {
+            auto x (manifest_coordinator::stream_archive (ix, *i));
+
+            req.sink = [p = x.get ()] (const char* d, std::size_t n)
+            {
+              return p->write (d, n);
+            };
+
+            streams[dst.string ()] = std::move (x);
+          }
+        }
 
-        launcher::log::trace_l3 (categories::launcher{}, "queuing download: {} -> {}", req.urls.front (), dst.string ());
+        launcher::log::trace_l3 (categories::launcher{}, "queuing download: {} -> {}{}", req.urls.front (), dst.string (), req.sink ? " (streamed)" : "");
 
         string n (req.name);
         auto t (downloads_.queue_download (std::move (req)));
         auto e (progress_.add_entry (n));
 
-        e->metrics ().total_bytes.store (item.expected_size,
+        e->metrics ().total_bytes.store (rp.size (item),
                                         std::memory_order_relaxed);
         tasks[t] = e;
+        issued.emplace_back (t, item);
 
-        t->on_progress = [e, this] (const download_progress& p)
+        t->on_progress = [e, this] (const download_progress& dp)
         {
-          progress_.update_progress (e, p.downloaded_bytes, p.total_bytes);
+          progress_.update_progress (e, dp.downloaded_bytes, dp.total_bytes);
         };
-      }
+      });
 
-      // Only show the progress UI if there are actual downloads.
+      // Ask the reconciler what actually needs to be done based on the
+      // assembled manifest.
       //
-      if (download_count > 0)
+      // Planning hashes whatever is already on disk which, on a cold or
+      // badly damaged install, takes a while. So we don't wait for the whole
+      // plan: the reconciler emits entries as it decides them and we queue
+      // each download right away. The download manager is held open until
+      // the plan is complete so that it doesn't finish early on an empty
+      // queue.
+      //
+      launcher::log::trace_l2 (categories::launcher{}, "planning reconciliation against local cache...");
+
+      reconcile_plan plan (ix, rec.root (), ct::client, r.client.tag_name);
+      reconciler::plan_channel ch (ioc_, pm.archives.size () + pm.files.size ());
+
+      load_journal ();
+
+      // Nothing else may use the database while the reconciler plans
+      // against it on its own thread, so keep the journal to ourselves
+      // until it is done.
+      //
+      journal_.hold ();
+
+      downloads_.hold ();
+      asio::co_spawn (ioc_, downloads_.execute_all (), asio::detached);
+
+      auto pf (rec.plan (plan, ch));
+
+      for (;;)
       {
-        launcher::log::info (categories::launcher{}, "starting {} downloads", download_count);
-        progress_.start ();
+        boost::system::error_code ec;
+        auto [e, cs] = co_await ch.async_receive (
+          asio::redirect_error (asio::use_awaitable, ec));
+
+        if (ec)
+          break;
+
+        queue (plan, e, cs);
+      }
+
+      downloads_.release ();
+
+      try
+      {
+        pf.get ();
+      }
+      catch (...)
+      {
+        journal_.release ();
+        throw;
+      }
+
+      journal_.release ();
 
-        asio::co_spawn (ioc_, downloads_.execute_all (), asio::detached);
+      launcher::log::debug (categories::launcher{}, "reconciler produced a plan with {} items", plan.size ());
+
+      auto sum (rec.summarize (plan));
+      launcher::log::info (categories::launcher{}, "reconcile summary: {} missing, {} stale, {} to download ({} bytes)",
+                           sum.files_missing, sum.files_stale, sum.downloads_required, sum.bytes_to_download);
+
+      if (sum.up_to_date ())
+      {
+        launcher::log::info (categories::launcher{}, "plan summary indicates up-to-date. stamping tags and finishing reconcile.");
+        stamp ();
+        co_return;
+      }
+
+      if (download_count > 0)
+      {
+        launcher::log::info (categories::launcher{}, "started {} downloads", download_count);
 
         // Wait for the queue to drain.
         //
@@ -690,67 +1430,120 @@ namespace launcher
         launcher::log::debug (categories::launcher{}, "primary download pass finished ({} completed, {} failed)",
                               downloads_.completed_count (), downloads_.failed_count ());
 
-        // Second pass: unconditionally re-check the filesystem.
+        // Record what we managed to stream. Anything that fell back or
+        // failed mid-way is retried below as a plain archive download.
         //
-        // In practice this almost never finds anything, the first pass is
-        // already strict. Still, Downloads can theoretically fail in
-        // subtle ways (dropped connection, truncated write) so we don't
-        // trust the reported state. Instead, we re-run the reconciler
-        // against the actual disk to catch stragglers.
+        // Note that the transfer of such an archive may well have completed
+        // (the extractor simply stopped consuming), so we have to remember
+        // which ones are broken.
         //
-        // That is, the real source of truth is the filesystem.
+        unordered_set<string> broken;
+
+        for (auto i (streams.begin ()); i != streams.end (); )
+        {
+          const auto& x (*i->second);
+
+          if (x.complete ())
+          {
+            launcher::log::trace_l3 (categories::launcher{}, "tracking {} files streamed from {}", x.extracted ().size (), i->first);
+            cache_.track (x.extracted (), plan.component (), plan.version ());
+            ++i;
+          }
+          else
+          {
+            launcher::log::warning (categories::launcher{}, "streamed extraction of {} did not complete ({}), falling back to archive download",
+                                    i->first, x.fallback () ? x.reason () : "transfer failed");
+            broken.insert (i->first);
+            i = streams.erase (i);
+          }
+        }
+
+        // A decompressed asset only replaces its target once the stream
+        // checks out (gzip CRC and size, then the manifest hash of the
+        // decompressed bytes), so one that didn't complete is retried.
         //
-        launcher::log::trace_l2 (categories::launcher{}, "starting secondary verification pass");
-        downloads_.clear ();
-        tasks.clear ();
+        for (const auto& [p, x]: decoders)
+        {
+          if (!x->complete ())
+          {
+            launcher::log::warning (categories::launcher{}, "decompression of {} did not complete, retrying", p);
+            broken.insert (p);
+          }
+        }
 
-        auto ps (
-          cache_.get_reconciler ().plan (m, ct::client, r.client.tag_name));
+        // Second pass: retry whatever didn't make it.
+        //
+        // Rather than re-plan the whole manifest against the disk (another
+        // round of db lookups, stats, and potentially hashing for every file
+        // just to find the odd straggler), we go by what each task reports.
+        // By now every plain download has been checked against its expected
+        // size and hash by the download layer. Streamed ones bypass that
+        // check: a decompressed asset is checked against the manifest hash
+        // by its decompressor while the entries of a streamed archive only
+        // have their zip CRC checked by the extractor. Either way, whatever
+        // didn't check out is marked broken above, so a task that completed
+        // and isn't broken is taken as good and the rest is exactly what
+        // needs another go. That is, this costs in proportion to the
+        // failures rather than to the manifest.
+        //
+        launcher::log::trace_l2 (categories::launcher{}, "starting secondary verification pass");
 
-        size_t n (0);
+        vector<reconcile_plan::entry> retry;
 
-        for (auto& p: ps)
+        for (const auto& [t, e]: issued)
         {
-          if (p.action != reconcile_action::download)
+          string p (plan.path (e).string ());
+
+          if (t->completed () && broken.count (p) == 0)
             continue;
 
-          // The reconciler plan might lack the URL so we have to patch it
-          // back in from the asset list.
-          //
-          if (p.url.empty ())
-          {
-            fs::path d (p.path);
-            string fn (d.filename ().string ());
+          const auto& rs (t->response);
 
-            if (auto i (c_assets.find (fn)); i != c_assets.end ())
-              p.url = i->second->browser_download_url;
-          }
+          launcher::log::warning (categories::launcher{}, "file {} failed verification ({}), requeuing download",
+                                  t->request.name, rs.error ? rs.error->message : "incomplete");
 
-          if (p.url.empty ())
-            continue;
+          retry.push_back (e);
+        }
+
+        downloads_.clear ();
+        tasks.clear ();
+        issued.clear ();
+
+        size_t n (0);
+
+        for (const auto& p: retry)
+        {
+          const string& u (url (plan, p));
 
           n++;
 
-          fs::path d (p.path);
+          fs::path d (plan.path (p));
           if (d.has_parent_path ())
           {
             error_code ec;
             create_directories (d.parent_path (), ec);
           }
 
+          // Always a full download this time since whatever the delta was
+          // based on may be what's broken. For the same reason we don't
+          // resume on top of a delta base.
+          //
           download_request rq;
-          rq.urls.push_back (p.url);
+          rq.urls.push_back (u);
           rq.target = d;
           rq.name = d.filename ().string ();
-          rq.expected_size = p.expected_size;
+          rq.expected_size = plan.size (p);
+          rq.resume = p.chunks == 0;
+          rq.priority = priority (d);
+          rq.content = plan.hash (p);
 
-          launcher::log::warning (categories::launcher{}, "file {} failed verification, requeuing download", rq.name);
+          decode (rq);
 
           string nm (rq.name);
           auto t (downloads_.queue_download (move (rq)));
           auto e (progress_.add_entry (nm + " (verify)"));
 
-          e->metrics ().total_bytes.store (p.expected_size, memory_order_relaxed);
+          e->metrics ().total_bytes.store (plan.size (p), memory_order_relaxed);
           tasks[t] = e;
 
           t->on_progress = [e, this] (const download_progress& dp)
@@ -800,55 +1593,54 @@ namespace launcher
 
       // Post-process downloads (extraction).
       //
-      const auto& root (ctx_.install_location);
       launcher::log::trace_l2 (categories::launcher{}, "post-processing downloaded files (tracking and extracting)");
 
       // Track direct downloads first.
       //
       for (const auto& item : plan)
       {
-        if (item.action == reconcile_action::download && fs::exists (item.path))
+        if (item.action != reconcile_action::download) continue;
+
+        fs::path p (plan.path (item));
+
+        if (fs::exists (p))
         {
-          launcher::log::trace_l3 (categories::launcher{}, "tracking raw download: {}", item.path);
-          cache_.track (item.path, item.component, item.version, item.expected_hash);
+          launcher::log::trace_l3 (categories::launcher{}, "tracking raw download: {}", p.string ());
+          cache_.track (p, plan.component (), plan.version (), plan.hash (item));
         }
       }
 
-      unordered_map<string, const ma*> amap;
-      for (const auto& a : m.archives)
-        amap[manifest_coordinator::resolve_path (a, root).string ()] = &a;
-
-      // Handle archives. If a downloaded item is a zip and appears in our
-      // manifest archive list, we extract it and track the contents.
+      // Handle archives. If a downloaded item is a zip archive, we extract it
+      // and track the contents. Unless, that is, it was already extracted
+      // while streaming (and not fetched again by the verification pass).
       //
       for (const auto& item : plan)
       {
-        if (item.action != reconcile_action::download) continue;
+        if (item.action != reconcile_action::download ||
+            item.what != pk::archive)
+          continue;
 
-        fs::path p (item.path);
+        fs::path p (plan.path (item));
         if (p.extension () != ".zip" && p.extension () != ".ZIP") continue;
 
-        auto it (amap.find (p.string ()));
-        if (it == amap.end ()) continue;
+        if (streams.count (p.string ()) != 0 && !fs::exists (p)) continue;
 
-        const auto* arch (it->second);
+        std::size_t i (item.index);
+        const auto* arch (&pm.archives[i]);
 
         try
         {
           launcher::log::info (categories::launcher{}, "extracting downloaded archive: {}", p.string ());
-          co_await manifest_coordinator::extract_archive (*arch, p, root);
+          co_await manifest_coordinator::extract_archive (ix, i, p, root);
 
           vector<fs::path> extracted;
           extracted.reserve (arch->files.size ());
 
-          for (const auto& f : arch->files)
-          {
-            fs::path ep (manifest_coordinator::resolve_path (f, root));
-            extracted.push_back (std::move (ep));
-          }
+          for (const auto& e : ix.contents (i))
+            extracted.push_back (e.path);
 
           launcher::log::trace_l3 (categories::launcher{}, "tracking {} extracted files from archive", extracted.size ());
-          cache_.track (extracted, item.component, item.version);
+          cache_.track (extracted, plan.component (), plan.version ());
 
           std::error_code ec;
           fs::remove (p, ec);
@@ -988,6 +1780,35 @@ namespace launcher
 #endif
 
   private:
+    // Install the launcher update found by resolve_remote_state().
+    //
+    // Returns true if we are restarting into the new version. Failing to
+    // install is not fatal, same as failing to check.
+    //
+    asio::awaitable<bool>
+    update_launcher ()
+    {
+      bool r (false);
+
+      try
+      {
+        r = co_await install_self_update (*updates_, &progress_);
+      }
+      catch (const exception& e)
+      {
+        launcher::log::warning (categories::launcher{}, "update failed with exception: {}", e.what ());
+        cerr << "warning: update failed: " << e.what () << endl;
+      }
+
+      // The progress UI is started again once there is something to
+      // download.
+      //
+      if (!r)
+        co_await progress_.stop ();
+
+      co_return r;
+    }
+
     // Report the rate limit backoff status to the user.
     //
     void
@@ -1034,7 +1855,14 @@ namespace launcher
     download_coordinator downloads_;
     progress_coordinator progress_;
     cache_coordinator cache_;
+    manifest_cache manifests_;
+    http_cache responses_;
+    download_journal journal_;
+    asio::steady_timer refreshed_; // Cancelled once the refresh is done.
+    unique_ptr<update_coordinator> updates_;
     bool rate_limit_started_progress_ {false};
+    bool refreshing_ {false};
+    optional<remote_state> refresh_result_; // Kept until await_refresh().
   };
 
   // Resolve MW2 installation root via Steam.
@@ -1234,47 +2062,7 @@ namespace launcher
         co_return false;
       }
 
-      // An update is available. Now we can start the UI if requested.
-      //
-      launcher::log::info (categories::launcher{}, "launcher update available, proceeding with installation");
-      if (pc != nullptr)
-      {
-        uc->set_progress_coordinator (pc);
-        pc->start ();
-      }
-
-      // Proceed to install the update.
-      //
-      const auto& info (uc->last_update_info ());
-
-      cout << "launcher update available: " << info.version
-           << " (current: " << uc->current_version () << ")" << endl;
-
-      if (!info.body.empty ())
-        cout << "Release notes:\n" << info.body << "\n" << endl;
-
-      auto r (co_await uc->install_update (info));
-
-      if (!r.success)
-      {
-        launcher::log::error (categories::launcher{}, "update failed to install: {}", r.error_message);
-        cerr << "error: update failed: " << r.error_message << endl;
-        co_return false;
-      }
-
-      // Try to restart into the new version.
-      //
-      if (uc->restart ())
-      {
-        launcher::log::info (categories::launcher{}, "restarting into new launcher version");
-        co_return true;
-      }
-
-      launcher::log::warning (categories::launcher{}, "update successful but auto-restart failed");
-      cerr << "warning: failed to restart launcher automatically" << endl;
-      cout << "please restart the launcher manually." << endl;
-
-      co_return false;
+      co_return co_await install_self_update (*uc, pc);
     }
     catch (const exception& e)
     {
@@ -1439,6 +2227,25 @@ main (int argc, char* argv[])
     ctx.upstream_repo = "iw4x-client";
     ctx.prerelease = opt.prerelease ();
     ctx.concurrency_limit = opt.jobs ();
+    ctx.metadata_ttl = chrono::seconds (opt.metadata_ttl ());
+    ctx.stall_rate = opt.stall_rate ();
+    ctx.stall_time = chrono::seconds (opt.stall_time ());
+
+    // The critical path policy is largest first with the launch-critical
+    // files bumped to the front (see the download queueing).
+    //
+    {
+      const string& s (opt.schedule ());
+
+      ctx.critical_path = s == "critical";
+
+      if (s == "largest" || s == "critical")
+        ctx.schedule = download_schedule::largest_first;
+      else if (s == "smallest")
+        ctx.schedule = download_schedule::smallest_first;
+      else
+        throw cli::invalid_value ("--schedule", s);
+    }
 
     launcher::log::debug (categories::launcher{}, "runtime context configured (repo: {}/{}, pre: {}, jobs: {})",
                           ctx.upstream_owner, ctx.upstream_repo, ctx.prerelease, ctx.concurrency_limit);
@@ -1451,7 +2258,12 @@ main (int argc, char* argv[])
     if (opt.game_args_specified ())
       ctx.proton_arguments = opt.game_args ();
 
-    if (!opt.no_self_update () || opt.self_update_only ())
+    // Unless that's all we are asked to do, the launcher update check is
+    // done by the controller along with the rest of the remote state.
+    //
+    ctx.self_update = !opt.no_self_update ();
+
+    if (opt.self_update_only ())
     {
       bool r (false);
 
@@ -1481,14 +2293,11 @@ main (int argc, char* argv[])
       ioc.run ();
       ioc.restart ();
 
-      // If we applied an update that requires a restart (e.g. replaced the
-      // executable) or if the user only asked to update, we are done.
+      // The user only asked to update, so whether or not we are restarting
+      // into a new version, we are done.
       //
-      if (r || opt.self_update_only ())
-      {
-        launcher::log::info (categories::launcher{}, "self update completed or requested exit, terminating current process");
-        return 0;
-      }
+      launcher::log::info (categories::launcher{}, "self update {}, terminating current process", r ? "completed" : "not applied");
+      return 0;
     }
 
     // Control Loop.
@@ -0,0 +1,475 @@
+#include <launcher/manifest/manifest-cache.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <launcher/blake3.h>
+#include <launcher/launcher-log.hxx>
+
+using namespace std;
+
+namespace launcher
+{
+  static const char image_magic[8] = {'I', 'W', '4', 'X', 'M', 'F', 'S', 'T'};
+  static const uint32_t image_version (1);
+
+  static const size_t header_size  (80);
+  static const size_t string_size  (8);
+  static const size_t archive_size (64);
+  static const size_t file_size    (64);
+  static const size_t chunk_size   (48);
+
+  static const uint32_t no_string (0xffffffff);
+
+  static const uint8_t flag_hash (0x01); // Hash present.
+
+  static const char* const image_ext (".manifest");
+
+  // Little-endian helpers.
+  //
+  static inline void
+  put (string& b, uint64_t v, size_t n)
+  {
+    for (size_t i (0); i != n; ++i)
+      b.push_back (static_cast<char> (v >> (i * 8)));
+  }
+
+  static inline uint64_t
+  get (const char* d, size_t n)
+  {
+    uint64_t r (0);
+    for (size_t i (0); i != n; ++i)
+      r |= static_cast<uint64_t> (static_cast<unsigned char> (d[i])) << (i * 8);
+    return r;
+  }
+
+  // Append the hash as 32 raw bytes. Return false if it's empty (in which
+  // case we append zeros), throw if it's not something we can round-trip.
+  //
+  static bool
+  put_hash (string& b, const manifest::hash_type& h)
+  {
+    if (h.algorithm != hash_algorithm::blake3)
+      throw invalid_argument ("unrepresentable hash algorithm");
+
+    b.append (reinterpret_cast<const char*> (h.value.data ()), h.value.size ());
+    return !h.empty ();
+  }
+
+  static manifest::hash_type
+  get_hash (const char* d, bool present)
+  {
+    if (!present)
+      return manifest::hash_type ();
+
+    return manifest::hash_type (
+      blake3_digest (reinterpret_cast<const uint8_t*> (d)));
+  }
+
+  static string
+  digest (const void* d, size_t n)
+  {
+    blake3_digest o;
+
+    blake3_hasher h;
+    blake3_hasher_init (&h);
+    blake3_hasher_update (&h, d, n);
+    blake3_hasher_finalize (&h, o.data (), o.size ());
+
+    return o.hex ();
+  }
+
+  manifest_cache::
+  manifest_cache (fs::path d, size_t c)
+    : dir_ (move (d)), capacity_ (c)
+  {
+  }
+
+  const fs::path& manifest_cache::
+  directory () const noexcept
+  {
+    return dir_;
+  }
+
+  string manifest_cache::
+  content_key (const string& c)
+  {
+    return "blake3:" + digest (c.data (), c.size ());
+  }
+
+  string manifest_cache::
+  release_key (const string& t, uint64_t id)
+  {
+    return "release:" + to_string (id) + ":" + t;
+  }
+
+  fs::path manifest_cache::
+  path (const string& k) const
+  {
+    // Keys contain characters (like '/' in tags) that are no good in file
+    // names, so name the image after the key's hash instead.
+    //
+    return dir_ / (digest (k.data (), k.size ()).substr (0, 32) + image_ext);
+  }
+
+  optional<manifest> manifest_cache::
+  load (const string& k, manifest_format kind) const
+  {
+    fs::path p (path (k));
+
+    error_code ec;
+    if (!fs::exists (p, ec))
+    {
+      launcher::log::trace_l3 (categories::manifest{}, "manifest cache miss for {}", k);
+      return nullopt;
+    }
+
+    string b;
+    {
+      ifstream ifs (p, ios::binary);
+      if (ifs)
+        b.assign (istreambuf_iterator<char> (ifs), istreambuf_iterator<char> ());
+    }
+
+    optional<manifest> r (decode (b.data (), b.size (), kind));
+
+    if (!r)
+    {
+      launcher::log::warning (categories::manifest{}, "discarding unusable manifest cache entry {}", p.string ());
+      fs::remove (p, ec);
+      return nullopt;
+    }
+
+    launcher::log::debug (categories::manifest{}, "manifest cache hit for {} ({} archives, {} files)", k, r->archives.size (), r->files.size ());
+    return r;
+  }
+
+  void manifest_cache::
+  save (const string& k, const manifest& m)
+  {
+    fs::path p (path (k));
+    fs::path t (p.string () + ".tmp");
+
+    try
+    {
+      string b (encode (m));
+
+      error_code ec;
+      fs::create_directories (dir_, ec);
+
+      {
+        ofstream ofs (t, ios::binary | ios::trunc);
+        ofs.write (b.data (), static_cast<streamsize> (b.size ()));
+
+        if (!ofs)
+          throw runtime_error ("failed to write " + t.string ());
+      }
+
+      fs::rename (t, p, ec);
+      if (ec)
+      {
+        fs::remove (p, ec);
+        fs::rename (t, p);
+      }
+
+      launcher::log::trace_l2 (categories::manifest{}, "cached manifest {} ({} bytes)", k, b.size ());
+    }
+    catch (const exception& e)
+    {
+      launcher::log::warning (categories::manifest{}, "failed to cache manifest {}: {}", k, e.what ());
+
+      error_code ec;
+      fs::remove (t, ec);
+      return;
+    }
+
+    evict ();
+  }
+
+  void manifest_cache::
+  evict () const
+  {
+    error_code ec;
+    vector<pair<fs::file_time_type, fs::path>> es;
+
+    for (fs::directory_iterator i (dir_, ec), e; !ec && i != e; i.increment (ec))
+    {
+      if (i->path ().extension () != image_ext)
+        continue;
+
+      fs::file_time_type t (fs::last_write_time (i->path (), ec));
+      if (!ec)
+        es.emplace_back (t, i->path ());
+    }
+
+    if (es.size () <= capacity_)
+      return;
+
+    sort (es.begin (), es.end (), [] (const auto& x, const auto& y)
+    {
+      return x.first > y.first;
+    });
+
+    for (size_t i (capacity_); i != es.size (); ++i)
+    {
+      launcher::log::trace_l3 (categories::manifest{}, "evicting manifest cache entry {}", es[i].second.string ());
+      fs::remove (es[i].second, ec);
+    }
+  }
+
+  string manifest_cache::
+  encode (const manifest& m)
+  {
+    // Intern the strings.
+    //
+    vector<const string*> ss;
+    unordered_map<string, uint32_t> si;
+
+    auto intern ([&ss, &si] (const string& s) -> uint32_t
+    {
+      auto r (si.emplace (s, static_cast<uint32_t> (ss.size ())));
+      if (r.second)
+        ss.push_back (&r.first->first);
+      return r.first->second;
+    });
+
+    auto opt ([&intern] (const optional<string>& s)
+    {
+      return s ? intern (*s) : no_string;
+    });
+
+    // Build the record tables. Chunks from all entries share one table.
+    //
+    string at, ft, ct;
+    uint32_t nc (0);
+
+    auto chunks ([&ct, &nc] (const vector<manifest_chunk>& cs)
+    {
+      for (const auto& c : cs)
+      {
+        if (!put_hash (ct, c.hash))
+          throw invalid_argument ("chunk without hash");
+
+        put (ct, c.offset, 8);
+        put (ct, c.size, 8);
+      }
+
+      nc += static_cast<uint32_t> (cs.size ());
+    });
+
+    for (const auto& a : m.archives)
+    {
+      uint32_t c0 (nc);
+
+      bool h (put_hash (at, a.hash));
+      put (at, a.size, 8);
+      put (at, intern (a.name), 4);
+      put (at, intern (a.url), 4);
+      put (at, static_cast<uint8_t> (a.compression), 1);
+      put (at, h ? flag_hash : 0, 1);
+      put (at, 0, 2);
+      chunks (a.chunks);
+      put (at, c0, 4);
+      put (at, a.chunks.size (), 4);
+      put (at, 0, 4);
+    }
+
+    for (const auto& f : m.files)
+    {
+      uint32_t c0 (nc);
+
+      bool h (put_hash (ft, f.hash));
+      put (ft, f.size, 8);
+      put (ft, intern (f.path), 4);
+      put (ft, opt (f.asset_name), 4);
+      put (ft, opt (f.archive_name), 4);
+      put (ft, static_cast<uint8_t> (f.compression), 1);
+      put (ft, h ? flag_hash : 0, 1);
+      put (ft, 0, 2);
+      chunks (f.chunks);
+      put (ft, c0, 4);
+      put (ft, f.chunks.size (), 4);
+    }
+
+    string st, sd;
+    for (const string* s : ss)
+    {
+      put (st, sd.size (), 4);
+      put (st, s->size (), 4);
+      sd += *s;
+    }
+
+    uint64_t so (header_size);
+    uint64_t ao (so + st.size ());
+    uint64_t fo (ao + at.size ());
+    uint64_t co (fo + ft.size ());
+    uint64_t d (co + ct.size ());
+    uint64_t n (d + sd.size ());
+
+    if (sd.size () > 0xffffffff)
+      throw invalid_argument ("manifest string table too large");
+
+    string b;
+    b.reserve (n);
+    b.append (image_magic, sizeof (image_magic));
+    put (b, image_version, 4);
+    put (b, static_cast<uint32_t> (m.kind), 4);
+    put (b, ss.size (), 4);
+    put (b, m.archives.size (), 4);
+    put (b, m.files.size (), 4);
+    put (b, nc, 4);
+    put (b, so, 8);
+    put (b, ao, 8);
+    put (b, fo, 8);
+    put (b, co, 8);
+    put (b, d, 8);
+    put (b, n, 8);
+
+    b += st;
+    b += at;
+    b += ft;
+    b += ct;
+    b += sd;
+
+    return b;
+  }
+
+  optional<manifest> manifest_cache::
+  decode (const char* d, size_t n, manifest_format kind)
+  {
+    if (n < header_size || memcmp (d, image_magic, sizeof (image_magic)) != 0)
+      return nullopt;
+
+    if (get (d + 8, 4) != image_version ||
+        get (d + 12, 4) != static_cast<uint32_t> (kind) ||
+        get (d + 72, 8) != n)
+      return nullopt;
+
+    uint64_t ns (get (d + 16, 4));
+    uint64_t na (get (d + 20, 4));
+    uint64_t nf (get (d + 24, 4));
+    uint64_t nc (get (d + 28, 4));
+    uint64_t so (get (d + 32, 8));
+    uint64_t ao (get (d + 40, 8));
+    uint64_t fo (get (d + 48, 8));
+    uint64_t co (get (d + 56, 8));
+    uint64_t sd (get (d + 64, 8));
+
+    // Every table must lie within the image. The counts are 32-bit so the
+    // products below can't overflow.
+    //
+    auto fits ([n] (uint64_t o, uint64_t c, uint64_t s)
+    {
+      return o <= n && c * s <= n - o;
+    });
+
+    if (!fits (so, ns, string_size)  ||
+        !fits (ao, na, archive_size) ||
+        !fits (fo, nf, file_size)    ||
+        !fits (co, nc, chunk_size)   ||
+        sd > n)
+      return nullopt;
+
+    // Strings are resolved lazily, straight out of the image.
+    //
+    auto str ([&] (uint32_t i, string& r)
+    {
+      if (i >= ns)
+        return false;
+
+      const char* e (d + so + i * string_size);
+      uint64_t o (get (e, 4));
+      uint64_t s (get (e + 4, 4));
+
+      if (o > n - sd || s > n - sd - o)
+        return false;
+
+      r.assign (d + sd + o, s);
+      return true;
+    });
+
+    auto ostr ([&str] (uint32_t i, optional<string>& r)
+    {
+      if (i == no_string)
+        return true;
+
+      r = string ();
+      return str (i, *r);
+    });
+
+    auto chunks ([&] (const char* e, vector<manifest_chunk>& r)
+    {
+      uint64_t b (get (e, 4));
+      uint64_t c (get (e + 4, 4));
+
+      if (b > nc || c > nc - b)
+        return false;
+
+      r.reserve (c);
+      for (uint64_t i (b); i != b + c; ++i)
+      {
+        const char* x (d + co + i * chunk_size);
+        r.emplace_back (get_hash (x, true), get (x + 32, 8), get (x + 40, 8));
+      }
+
+      return true;
+    });
+
+    auto compression ([] (uint64_t v, compression_type& r)
+    {
+      if (v > static_cast<uint64_t> (compression_type::gzip))
+        return false;
+
+      r = static_cast<compression_type> (v);
+      return true;
+    });
+
+    manifest m;
+    m.kind = kind;
+    m.format = kind;
+    m.archives.resize (na);
+    m.files.resize (nf);
+
+    for (uint64_t i (0); i != na; ++i)
+    {
+      const char* e (d + ao + i * archive_size);
+      auto& a (m.archives[i]);
+
+      uint8_t f (static_cast<uint8_t> (get (e + 49, 1)));
+
+      a.hash = get_hash (e, f & flag_hash);
+      a.size = get (e + 32, 8);
+
+      if (!str (static_cast<uint32_t> (get (e + 40, 4)), a.name) ||
+          !str (static_cast<uint32_t> (get (e + 44, 4)), a.url) ||
+          !compression (get (e + 48, 1), a.compression) ||
+          !chunks (e + 52, a.chunks))
+        return nullopt;
+    }
+
+    for (uint64_t i (0); i != nf; ++i)
+    {
+      const char* e (d + fo + i * file_size);
+      auto& x (m.files[i]);
+
+      uint8_t f (static_cast<uint8_t> (get (e + 53, 1)));
+
+      x.hash = get_hash (e, f & flag_hash);
+      x.size = get (e + 32, 8);
+
+      if (!str (static_cast<uint32_t> (get (e + 40, 4)), x.path) ||
+          !ostr (static_cast<uint32_t> (get (e + 44, 4)), x.asset_name) ||
+          !ostr (static_cast<uint32_t> (get (e + 48, 4)), x.archive_name) ||
+          !compression (get (e + 52, 1), x.compression) ||
+          !chunks (e + 56, x.chunks))
+        return nullopt;
+    }
+
+    return m;
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <launcher/manifest/manifest.hxx>
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // On-disk cache of parsed manifests.
+  //
+  // A release tag never changes its assets (a re-published manifest gets a
+  // new asset id), so once we have parsed the manifest for a given tag there
+  // is no reason to download and parse it again. Same for content we had to
+  // fetch anyway but have already seen (see content_key()).
+  //
+  // Manifests are stored in a compact binary image rather than as JSON:
+  // strings are interned into a single table, hashes are stored as their
+  // 32 raw bytes, and the archive, file, and chunk tables are fixed-size
+  // records that refer to each other (and to strings) by index. Everything
+  // is addressed by offset from the start of the image so it can be read in
+  // place, whether from a buffer or a mapping.
+  //
+  // All integers are little-endian:
+  //
+  // header   "IW4XMFST", u32 version, u32 kind,
+  //          u32 string/archive/file/chunk counts,
+  //          u64 string/archive/file/chunk table offsets,
+  //          u64 string data offset, u64 image size
+  // strings  {u32 offset, u32 size} into string data
+  // archives {hash[32], u64 size, u32 name, u32 url, u8 compression,
+  //           u8 flags, u16 -, u32 first chunk, u32 chunk count, u32 -}
+  // files    {hash[32], u64 size, u32 path, u32 asset name, u32 archive,
+  //           u8 compression, u8 flags, u16 -, u32 first chunk,
+  //           u32 chunk count}
+  // chunks   {hash[32], u64 offset, u64 size}
+  //
+  // Only what the manifest itself carries is stored: archive file lists are
+  // rebuilt with link_files() and URLs resolved against the release as
+  // usual.
+  //
+  class manifest_cache
+  {
+  public:
+    // Keep at most capacity images, evicting the least recently written.
+    //
+    explicit
+    manifest_cache (fs::path directory, std::size_t capacity = 16);
+
+    // Return the cached manifest or nullopt if there is none (or it is
+    // unusable, in which case it is removed).
+    //
+    std::optional<manifest>
+    load (const std::string& key, manifest_format kind) const;
+
+    // Store the manifest. This is best-effort: failures are logged and
+    // otherwise ignored since we can always fetch it again.
+    //
+    void
+    save (const std::string& key, const manifest&);
+
+    // Key for manifest content that we only know by its bytes.
+    //
+    static std::string
+    content_key (const std::string& content);
+
+    // Key for a release asset.
+    //
+    static std::string
+    release_key (const std::string& tag, std::uint64_t asset_id);
+
+    // Image codec.
+    //
+    // Encoding throws std::invalid_argument if the manifest cannot be
+    // represented exactly (say, a chunk without a hash).
+    // Decoding returns nullopt on any inconsistency.
+    //
+    static std::string
+    encode (const manifest&);
+
+    static std::optional<manifest>
+    decode (const char* data, std::size_t size, manifest_format kind);
+
+    const fs::path&
+    directory () const noexcept;
+
+  private:
+    fs::path
+    path (const std::string& key) const;
+
+    void
+    evict () const;
+
+    fs::path dir_;
+    std::size_t capacity_;
+  };
+}
@@ -0,0 +1,210 @@
+#include <launcher/manifest/manifest-cache.hxx>
+
+#include <string>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+
+using namespace std;
+using namespace launcher;
+
+namespace fs = std::filesystem;
+
+// Distinct, non-empty hash.
+//
+static manifest::hash_type
+digest (uint8_t v)
+{
+  blake3_digest::bytes_type b {};
+  b.fill (v);
+  return manifest::hash_type (blake3_digest (b));
+}
+
+static manifest
+update ()
+{
+  manifest m (manifest_format::update, manifest_format::update);
+
+  manifest_archive a (digest (1), 1000, "release.zip", "https://example.org/r");
+  a.chunks.emplace_back (digest (2), 0, 600);
+  a.chunks.emplace_back (digest (3), 600, 400);
+  m.archives.push_back (a);
+
+  // No hash at all (the flag, not a zero digest, tells them apart).
+  //
+  m.archives.emplace_back (manifest::hash_type (),
+                           5,
+                           "blob.bin",
+                           "",
+                           compression_type::gzip);
+
+  manifest_file f (digest (4), 600, "iw4x.dll", string ("iw4x.dll"));
+  f.compression = compression_type::gzip;
+  f.chunks.emplace_back (digest (5), 0, 600);
+  m.files.push_back (f);
+
+  m.files.emplace_back (digest (6),
+                        10,
+                        "zone/english/x.ff",
+                        nullopt,
+                        string ("release.zip"));
+
+  // Strings shared between entries are interned once, empty ones included.
+  //
+  m.files.emplace_back (digest (7), 0, "release.zip", string (""));
+
+  return m;
+}
+
+static manifest
+dlc ()
+{
+  manifest m (manifest_format::dlc, manifest_format::dlc);
+
+  m.archives.emplace_back (digest (8), 42, "dlc.zip", "https://example.org/d");
+  m.files.emplace_back (digest (9),
+                        7,
+                        "mods/dlc/x.iwd",
+                        nullopt,
+                        string ("dlc.zip"));
+
+  return m;
+}
+
+static optional<manifest>
+decode (const string& b, manifest_format k)
+{
+  return manifest_cache::decode (b.data (), b.size (), k);
+}
+
+// Round trip. Whatever we encode comes back the same, for either kind of
+// manifest (and for an empty one), but only as the kind it was encoded as.
+//
+static void
+test_round_trip ()
+{
+  for (const manifest& m: {update (), dlc (), manifest ()})
+  {
+    string b (manifest_cache::encode (m));
+
+    auto r (decode (b, m.kind));
+    assert (r && *r == m);
+
+    manifest_format o (m.kind == manifest_format::update
+                       ? manifest_format::dlc
+                       : manifest_format::update);
+    assert (!decode (b, o));
+  }
+}
+
+// Corruption. A truncated image (at any length) or one whose tables refer
+// outside of it is rejected rather than read out of bounds.
+//
+static void
+test_corrupt ()
+{
+  string b (manifest_cache::encode (update ()));
+
+  for (size_t n (0); n != b.size (); ++n)
+    assert (!decode (b.substr (0, n), manifest_format::update));
+
+  // Trailing bytes are no better.
+  //
+  assert (!decode (b + '\0', manifest_format::update));
+
+  auto patch ([&b] (size_t o, uint32_t v)
+  {
+    string r (b);
+    for (size_t i (0); i != 4; ++i)
+      r[o + i] = static_cast<char> (v >> (i * 8));
+    return r;
+  });
+
+  auto get ([&b] (size_t o)
+  {
+    uint64_t r (0);
+    for (size_t i (0); i != 8; ++i)
+      r |= uint64_t (static_cast<unsigned char> (b[o + i])) << (i * 8);
+    return r;
+  });
+
+  size_t ao (get (40));
+  size_t fo (get (48));
+
+  auto bad ([] (const string& b)
+  {
+    return !decode (b, manifest_format::update);
+  });
+
+  assert (bad (patch (0, 0x4d345749))); // Magic.
+  assert (bad (patch (8, 2)));          // Version.
+  assert (bad (patch (20, 1000)));      // Archive count.
+  assert (bad (patch (ao + 40, 1000))); // Archive name.
+  assert (bad (patch (ao + 48, 7)));    // Archive compression.
+  assert (bad (patch (ao + 52, 2)));    // Archive chunks.
+  assert (bad (patch (fo + 44, 1000))); // File asset name.
+}
+
+// Encoding. A chunk without a hash cannot be told apart from a corrupt one
+// so we refuse to store it.
+//
+static void
+test_encode ()
+{
+  manifest m (update ());
+  m.files[0].chunks.emplace_back (manifest::hash_type (), 600, 1);
+
+  bool thrown (false);
+  try
+  {
+    manifest_cache::encode (m);
+  }
+  catch (const invalid_argument&)
+  {
+    thrown = true;
+  }
+
+  assert (thrown);
+}
+
+// Store. What we save we load, and an unusable entry is a miss that also
+// gets rid of it.
+//
+static void
+test_store ()
+{
+  fs::path d (fs::temp_directory_path () / "iw4x-manifest-cache-test");
+  fs::remove_all (d);
+
+  manifest_cache c (d);
+
+  string k (manifest_cache::release_key ("v1.0.0", 42));
+  assert (!c.load (k, manifest_format::update));
+
+  c.save (k, update ());
+
+  auto r (c.load (k, manifest_format::update));
+  assert (r && *r == update ());
+
+  for (const auto& e: fs::directory_iterator (d))
+  {
+    ofstream os (e.path (), ios::binary | ios::trunc);
+    os << "IW4XMFST";
+  }
+
+  assert (!c.load (k, manifest_format::update));
+  assert (fs::is_empty (d));
+
+  fs::remove_all (d);
+}
+
+int
+main ()
+{
+  test_round_trip ();
+  test_corrupt ();
+  test_encode ();
+  test_store ();
+}
@@ -0,0 +1,132 @@
+#include <launcher/manifest/manifest-chunk.hxx>
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <launcher/blake3.h>
+
+using namespace std;
+
+namespace launcher
+{
+  static constexpr array<uint64_t, 256>
+  make_gear ()
+  {
+    array<uint64_t, 256> r {};
+    uint64_t s (0);
+
+    for (auto& v : r)
+    {
+      uint64_t z (s += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      v = z ^ (z >> 31);
+    }
+
+    return r;
+  }
+
+  static constexpr array<uint64_t, 256> gear (make_gear ());
+
+  size_t
+  chunk_boundary (const unsigned char* d, size_t n, const chunk_params& p)
+  {
+    if (n <= p.min_size)
+      return n;
+
+    if (n > p.max_size)
+      n = p.max_size;
+
+    // Normalized chunking: below the average size we require more zero bits
+    // (so a cut is less likely), above it fewer. This pulls the chunk size
+    // distribution towards the average.
+    //
+    // Note that since the hash is shifted left on every byte, its top bits
+    // are the ones that mix the most history, so that's where we look.
+    //
+    int b (countr_zero (p.avg_size));
+    uint64_t ms (~0ULL << (64 - (b + 2)));
+    uint64_t ml (~0ULL << (64 - (b - 2)));
+
+    size_t m (p.avg_size < n ? p.avg_size : n);
+    size_t i (p.min_size);
+    uint64_t h (0);
+
+    for (; i < m; ++i)
+    {
+      h = (h << 1) + gear[d[i]];
+      if ((h & ms) == 0)
+        return i + 1;
+    }
+
+    for (; i < n; ++i)
+    {
+      h = (h << 1) + gear[d[i]];
+      if ((h & ml) == 0)
+        return i + 1;
+    }
+
+    return n;
+  }
+
+  vector<manifest_chunk>
+  compute_file_chunks (const fs::path& f, const chunk_params& p)
+  {
+    ifstream ifs (f, ios::binary);
+    if (!ifs)
+      throw runtime_error ("failed to open file for chunking: " + f.string ());
+
+    vector<manifest_chunk> r;
+
+    // Keep at least max_size bytes in the window (unless we are at the end)
+    // so that a boundary is never cut short by the buffer.
+    //
+    vector<unsigned char> buf (p.max_size * 4);
+    size_t len (0), pos (0);
+    uint64_t off (0);
+    bool eof (false);
+
+    for (;;)
+    {
+      if (!eof && len - pos < p.max_size)
+      {
+        memmove (buf.data (), buf.data () + pos, len - pos);
+        len -= pos;
+        pos = 0;
+
+        ifs.read (reinterpret_cast<char*> (buf.data () + len),
+                  static_cast<streamsize> (buf.size () - len));
+
+        len += static_cast<size_t> (ifs.gcount ());
+
+        if (ifs.bad ())
+          throw runtime_error ("error reading file for chunking: " +
+                               f.string ());
+
+        eof = ifs.eof ();
+      }
+
+      if (pos == len)
+        break;
+
+      size_t n (chunk_boundary (buf.data () + pos, len - pos, p));
+
+      blake3_hasher h;
+      blake3_hasher_init (&h);
+      blake3_hasher_update (&h, buf.data () + pos, n);
+
+      blake3_digest d;
+      blake3_hasher_finalize (&h, d.data (), d.size ());
+
+      r.emplace_back (manifest::hash_type (d), off, n);
+
+      pos += n;
+      off += n;
+    }
+
+    return r;
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <launcher/manifest/manifest.hxx>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Content-defined chunking (FastCDC with normalized chunking).
+  //
+  // Chunk boundaries are picked by a rolling gear hash over the content
+  // rather than at fixed offsets, so an insertion or deletion only disturbs
+  // the chunks around it and the rest still line up between two versions of
+  // a file.
+  //
+  // The publisher must chunk with the same parameters and gear table for
+  // the manifest chunks to match what we compute locally. The table is
+  // derived from splitmix64 seeded with 0, so any implementation can
+  // reproduce it.
+  //
+  struct chunk_params
+  {
+    std::size_t min_size = 16 * 1024;
+    std::size_t avg_size = 64 * 1024;  // Must be a power of two.
+    std::size_t max_size = 256 * 1024;
+  };
+
+  // Return the length of the chunk that starts at data. If size is not more
+  // than min_size, the whole remainder is one chunk.
+  //
+  std::size_t
+  chunk_boundary (const unsigned char* data,
+                  std::size_t size,
+                  const chunk_params& = chunk_params ());
+
+  // Split a file into chunks and hash each of them.
+  //
+  // Throws if the file cannot be read.
+  //
+  std::vector<manifest_chunk>
+  compute_file_chunks (const fs::path& file,
+                       const chunk_params& = chunk_params ());
+}
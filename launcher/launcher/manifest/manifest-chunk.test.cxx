@@ -0,0 +1,194 @@
+#include <launcher/manifest/manifest-chunk.hxx>
+
+#include <set>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+
+#include <launcher/blake3.h>
+
+using namespace std;
+using namespace launcher;
+
+namespace fs = std::filesystem;
+
+// Deterministic pseudo-random content so that the boundaries (and thus the
+// test) are stable across runs and platforms.
+//
+static vector<unsigned char>
+content (size_t n, uint64_t s)
+{
+  vector<unsigned char> r (n);
+
+  for (auto& c : r)
+  {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    c = static_cast<unsigned char> (s);
+  }
+
+  return r;
+}
+
+static vector<string>
+split (const vector<unsigned char>& d, const chunk_params& p = chunk_params ())
+{
+  vector<string> r;
+
+  for (size_t i (0); i != d.size (); )
+  {
+    size_t n (chunk_boundary (d.data () + i, d.size () - i, p));
+
+    assert (n != 0);
+    r.emplace_back (reinterpret_cast<const char*> (d.data () + i), n);
+    i += n;
+  }
+
+  return r;
+}
+
+// Short input is a single chunk.
+//
+static void
+test_short ()
+{
+  chunk_params p;
+
+  auto d (content (p.min_size, 1));
+  assert (chunk_boundary (d.data (), d.size ()) == d.size ());
+}
+
+// Every chunk but the last respects the bounds and the chunks tile the
+// input. Normalized chunking should also keep us in the neighbourhood of
+// the average.
+//
+static void
+test_bounds ()
+{
+  chunk_params p;
+
+  auto d (content (8 * 1024 * 1024, 42));
+  auto cs (split (d));
+
+  size_t t (0);
+
+  for (size_t i (0); i != cs.size (); ++i)
+  {
+    assert (cs[i].size () <= p.max_size);
+
+    if (i + 1 != cs.size ())
+      assert (cs[i].size () > p.min_size);
+
+    t += cs[i].size ();
+  }
+
+  assert (t == d.size ());
+
+  size_t a (t / cs.size ());
+  assert (a > p.avg_size / 2 && a < p.avg_size * 2);
+
+  // Same content, same boundaries.
+  //
+  assert (split (d) == cs);
+}
+
+// Inserting a few bytes near the front only disturbs the chunks around the
+// edit. The rest re-synchronize and are shared.
+//
+static void
+test_resync ()
+{
+  auto d (content (8 * 1024 * 1024, 42));
+  auto cs (split (d));
+
+  auto e (d);
+  e.insert (e.begin () + 100000, {'i', 'w', '4', 'x'});
+
+  auto es (split (e));
+  set<string> s (cs.begin (), cs.end ());
+
+  size_t m (0);
+  for (const auto& c : es)
+    if (s.count (c) != 0)
+      ++m;
+
+  assert (m + 3 >= cs.size ());
+}
+
+// Chunking a file. The reader works through a window several chunks wide
+// so make the file a few windows long and check that the boundaries match
+// the in-memory ones (that is, refills never cut a chunk short) and that
+// each chunk carries the hash of its bytes.
+//
+static void
+test_file ()
+{
+  chunk_params p;
+
+  auto d (content (p.max_size * 4 * 3 + 12345, 7));
+  auto cs (split (d));
+
+  fs::path f (fs::temp_directory_path () / "iw4x-chunk-test.bin");
+  {
+    ofstream os (f, ios::binary);
+    os.write (reinterpret_cast<const char*> (d.data ()),
+              static_cast<streamsize> (d.size ()));
+  }
+
+  auto ls (compute_file_chunks (f));
+  assert (ls.size () == cs.size ());
+
+  uint64_t o (0);
+  for (size_t i (0); i != ls.size (); ++i)
+  {
+    assert (ls[i].offset == o);
+    assert (ls[i].size == cs[i].size ());
+
+    blake3_hasher h;
+    blake3_hasher_init (&h);
+    blake3_hasher_update (&h, cs[i].data (), cs[i].size ());
+
+    blake3_digest v;
+    blake3_hasher_finalize (&h, v.data (), v.size ());
+
+    assert (ls[i].hash == manifest::hash_type (v));
+
+    o += ls[i].size;
+  }
+
+  // An empty file has no chunks.
+  //
+  {
+    ofstream os (f, ios::binary | ios::trunc);
+  }
+  assert (compute_file_chunks (f).empty ());
+
+  fs::remove (f);
+
+  // A missing file is an error.
+  //
+  bool thrown (false);
+  try
+  {
+    compute_file_chunks (f);
+  }
+  catch (const runtime_error&)
+  {
+    thrown = true;
+  }
+  assert (thrown);
+}
+
+int
+main ()
+{
+  test_short ();
+  test_bounds ();
+  test_resync ();
+  test_file ();
+}
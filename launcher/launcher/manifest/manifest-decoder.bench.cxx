@@ -0,0 +1,182 @@
+#include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-decoder.hxx>
+
+#include <boost/json/parse.hpp>
+
+#include <new>
+#include <tuple>
+#include <chrono>
+#include <string>
+#include <cassert>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+using namespace launcher;
+
+// Manifest decoding benchmark.
+//
+// Parse a large synthetic manifest with the decoder, incrementally, and
+// via a json::value, reporting the time and peak heap usage of each. This
+// is not part of the test run; build and run it explicitly.
+//
+
+// Track the live and peak heap usage so that the benchmark below can report
+// how much memory each parse path needs.
+//
+static size_t live (0);
+static size_t peak (0);
+
+void*
+operator new (size_t n)
+{
+  void* p (malloc (n + sizeof (max_align_t)));
+
+  if (p == nullptr)
+    throw bad_alloc ();
+
+  *static_cast<size_t*> (p) = n;
+
+  if ((live += n) > peak)
+    peak = live;
+
+  return static_cast<char*> (p) + sizeof (max_align_t);
+}
+
+void
+operator delete (void* p) noexcept
+{
+  if (p == nullptr)
+    return;
+
+  p = static_cast<char*> (p) - sizeof (max_align_t);
+  live -= *static_cast<size_t*> (p);
+  free (p);
+}
+
+void
+operator delete (void* p, size_t) noexcept
+{
+  operator delete (p);
+}
+
+static string
+digest (size_t i)
+{
+  static const char x[] = "0123456789abcdef";
+
+  string r (64, '0');
+  for (size_t j (0); j != 64; ++j)
+    r[j] = x[(i * 31 + j * 7) % 16];
+
+  return r;
+}
+
+// Synthetic update manifest with n files spread over a few archives, every
+// tenth one stand-alone with a chunk list.
+//
+static string
+synthetic (size_t n)
+{
+  string r ("{\"archives\":[");
+
+  for (size_t i (0); i != 8; ++i)
+  {
+    if (i != 0)
+      r += ',';
+
+    r += "{\"name\":\"archive-" + to_string (i) + ".zip\","
+         "\"blake3\":\"" + digest (i) + "\","
+         "\"size\":" + to_string (1048576 * (i + 1)) + ","
+         "\"url\":\"https://example.org/archive-" + to_string (i) + ".zip\"}";
+  }
+
+  r += "],\"files\":[";
+
+  for (size_t i (0); i != n; ++i)
+  {
+    if (i != 0)
+      r += ',';
+
+    r += "{\"path\":\"zone/english/file-" + to_string (i) + ".ff\","
+         "\"blake3\":\"" + digest (i) + "\","
+         "\"size\":" + to_string (4096 + i);
+
+    if (i % 10 == 0)
+      r += ",\"asset_name\":\"file-" + to_string (i) + ".ff\","
+           "\"chunks\":[{\"blake3\":\"" + digest (i + 1) + "\","
+           "\"offset\":0,\"size\":" + to_string (4096 + i) + "}]";
+    else
+      r += ",\"archive\":\"archive-" + to_string (i % 8) + ".zip\"";
+
+    r += '}';
+  }
+
+  r += "]}";
+  return r;
+}
+
+static bool
+same (const manifest& x, const manifest& y)
+{
+  return x.archives == y.archives && x.files == y.files;
+}
+
+// Decode the document incrementally, n bytes at a time.
+//
+static manifest
+streamed (const string& s, manifest_format k, size_t n)
+{
+  manifest m;
+  m.kind = k;
+
+  manifest_decoder<manifest>::stream d (m);
+
+  for (size_t i (0); i < s.size (); i += n)
+    d.write (s.data () + i, min (n, s.size () - i));
+
+  d.finish ();
+  return m;
+}
+
+int
+main (int argc, char* argv[])
+{
+  using clock = chrono::steady_clock;
+
+  const size_t n (argc > 1 ? stoul (argv[1]) : 100000);
+  string s (synthetic (n));
+
+  auto run ([] (auto f)
+  {
+    size_t base (live);
+    peak = live;
+
+    auto start (clock::now ());
+    manifest m (f ());
+    auto t (chrono::duration_cast<chrono::milliseconds> (clock::now () - start));
+
+    return make_tuple (move (m), t.count (), peak - base);
+  });
+
+  auto [d, dt, dp] = run ([&s] {return manifest (s);});
+  auto [v, vt, vp] = run ([&s] {return manifest (boost::json::parse (s));});
+  auto [i, it, ip] = run ([&s]
+  {
+    return streamed (s, manifest_format::update, 8192);
+  });
+
+  assert (d.files.size () == n && d.archives.size () == 8);
+  assert (same (d, v));
+  assert (same (d, i));
+
+  // Note that the streamed peak doesn't include the document itself since
+  // it would normally never be in memory as a whole.
+  //
+  cerr << "manifest of " << n << " files, " << s.size () << " bytes" << endl
+       << "  decoder:    " << dt << " ms, peak " << dp / 1024 << " KiB" << endl
+       << "  streamed:   " << it << " ms, peak " << ip / 1024 << " KiB" << endl
+       << "  json value: " << vt << " ms, peak " << vp / 1024 << " KiB" << endl;
+}
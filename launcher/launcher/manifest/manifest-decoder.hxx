@@ -0,0 +1,193 @@
+#pragma once
+
+#include <launcher/manifest/manifest-types.hxx>
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string_view>
+
+#include <boost/json/basic_parser.hpp>
+
+namespace launcher
+{
+  namespace json = boost::json;
+
+  // Single-pass manifest decoder.
+  //
+  // Building a json::value DOM for a manifest with 100k entries only to walk
+  // it once and copy every string out of it again is the bulk of the parse
+  // time and roughly doubles the peak memory. Instead, this is a
+  // json::basic_parser handler that decodes the events straight into the
+  // manifest's archive and file entries.
+  //
+  // The result is the same as constructing the manifest from a json::value:
+  // unknown keys and values of unexpected types are ignored, entries without
+  // a name (path) are dropped, a malformed chunk list is dropped as a whole,
+  // and an unknown compression or a malformed hash is an error.
+  //
+  template <typename M>
+  class manifest_decoder
+  {
+  public:
+    using manifest_type = M;
+
+    // Decode the document into m, appending to its archives and files.
+    //
+    // Throw std::invalid_argument if the document is not valid JSON or not
+    // something we can represent.
+    //
+    static void
+    decode (std::string_view, manifest_type& m);
+
+    // Incremental decoding.
+    //
+    // Decode the document as it arrives (for example, off the network) so
+    // that it never has to be in memory as a whole. Note that unlike
+    // decode(), we cannot size the entry vectors up front.
+    //
+    // The result and errors are the same as with decode() except that the
+    // error may be thrown by any write() or by finish().
+    //
+    class stream
+    {
+    public:
+      explicit
+      stream (manifest_type& m);
+
+      stream (const stream&) = delete;
+      stream& operator= (const stream&) = delete;
+
+      void
+      write (const char* data, std::size_t size);
+
+      // Signal the end of the document.
+      //
+      void
+      finish ();
+
+    private:
+      json::basic_parser<manifest_decoder> p_;
+    };
+
+    // json::basic_parser handler interface.
+    //
+    static constexpr std::size_t max_object_size = std::size_t (-1);
+    static constexpr std::size_t max_array_size  = std::size_t (-1);
+    static constexpr std::size_t max_key_size    = std::size_t (-1);
+    static constexpr std::size_t max_string_size = std::size_t (-1);
+
+    explicit
+    manifest_decoder (manifest_type& m);
+
+    bool on_document_begin (json::error_code&);
+    bool on_document_end (json::error_code&);
+    bool on_object_begin (json::error_code&);
+    bool on_object_end (std::size_t, json::error_code&);
+    bool on_array_begin (json::error_code&);
+    bool on_array_end (std::size_t, json::error_code&);
+    bool on_key_part (json::string_view, std::size_t, json::error_code&);
+    bool on_key (json::string_view, std::size_t, json::error_code&);
+    bool on_string_part (json::string_view, std::size_t, json::error_code&);
+    bool on_string (json::string_view, std::size_t, json::error_code&);
+    bool on_number_part (json::string_view, json::error_code&);
+    bool on_int64 (std::int64_t, json::string_view, json::error_code&);
+    bool on_uint64 (std::uint64_t, json::string_view, json::error_code&);
+    bool on_double (double, json::string_view, json::error_code&);
+    bool on_bool (bool, json::error_code&);
+    bool on_null (json::error_code&);
+    bool on_comment_part (json::string_view, json::error_code&);
+    bool on_comment (json::string_view, json::error_code&);
+
+  private:
+    using string_type = typename manifest_type::string_type;
+    using hash_type = typename manifest_type::hash_type;
+    using file_type = typename manifest_type::file_type;
+    using archive_type = typename manifest_type::archive_type;
+    using chunk_type = typename file_type::chunk_type;
+
+    // Where we are in the document.
+    //
+    enum class state
+    {
+      document, // Before the root object.
+      root,     // In the root object.
+      section,  // In the archives or files array.
+      entry,    // In an archive or file object.
+      chunks,   // In an entry's chunk list.
+      chunk,    // In a chunk object.
+      done
+    };
+
+    // Keys we care about, wherever they appear.
+    //
+    enum class field
+    {
+      other,
+      archives,
+      files,
+      blake3,
+      size,
+      name,
+      url,
+      path,
+      asset_name,
+      archive,
+      compression,
+      chunks,
+      offset
+    };
+
+    field
+    resolve (std::string_view) const noexcept;
+
+    // Scalar values, by state and key.
+    //
+    void
+    value (std::string_view);
+
+    void
+    value (std::uint64_t, bool negative);
+
+    // A value we don't consume (an object or array is then skipped as a
+    // whole).
+    //
+    void
+    other ();
+
+    void
+    finish_entry ();
+
+    void
+    finish_chunk ();
+
+    manifest_type& m_;
+
+    state state_ = state::document;
+    std::size_t skip_ = 0; // Depth of the value being skipped, if any.
+
+    field key_ = field::other;   // Key of the current value.
+    field section_ = field::other;
+
+    std::string kbuf_; // Partial key.
+    std::string sbuf_; // Partial string.
+
+    file_type file_;
+    archive_type archive_;
+
+    // Chunk list of the current entry and the chunk being decoded.
+    //
+    std::vector<chunk_type> chunks_;
+    bool chunks_bad_ = false;
+    std::uint64_t next_ = 0;
+
+    std::string chunk_hash_;
+    std::uint64_t chunk_offset_ = 0;
+    std::uint64_t chunk_size_ = 0;
+    unsigned chunk_has_ = 0;
+    bool chunk_bad_ = false;
+  };
+}
+
+#include <launcher/manifest/manifest-decoder.txx>
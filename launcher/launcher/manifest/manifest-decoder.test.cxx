@@ -0,0 +1,191 @@
+#include <launcher/manifest/manifest.hxx>
+#include <launcher/manifest/manifest-decoder.hxx>
+
+#include <boost/json/parse.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+using namespace std;
+using namespace launcher;
+
+static string
+digest (size_t i)
+{
+  static const char x[] = "0123456789abcdef";
+
+  string r (64, '0');
+  for (size_t j (0); j != 64; ++j)
+    r[j] = x[(i * 31 + j * 7) % 16];
+
+  return r;
+}
+
+// Synthetic update manifest with n files spread over a few archives, every
+// tenth one stand-alone with a chunk list.
+//
+static string
+synthetic (size_t n)
+{
+  string r ("{\"archives\":[");
+
+  for (size_t i (0); i != 8; ++i)
+  {
+    if (i != 0)
+      r += ',';
+
+    r += "{\"name\":\"archive-" + to_string (i) + ".zip\","
+         "\"blake3\":\"" + digest (i) + "\","
+         "\"size\":" + to_string (1048576 * (i + 1)) + ","
+         "\"url\":\"https://example.org/archive-" + to_string (i) + ".zip\"}";
+  }
+
+  r += "],\"files\":[";
+
+  for (size_t i (0); i != n; ++i)
+  {
+    if (i != 0)
+      r += ',';
+
+    r += "{\"path\":\"zone/english/file-" + to_string (i) + ".ff\","
+         "\"blake3\":\"" + digest (i) + "\","
+         "\"size\":" + to_string (4096 + i);
+
+    if (i % 10 == 0)
+      r += ",\"asset_name\":\"file-" + to_string (i) + ".ff\","
+           "\"chunks\":[{\"blake3\":\"" + digest (i + 1) + "\","
+           "\"offset\":0,\"size\":" + to_string (4096 + i) + "}]";
+    else
+      r += ",\"archive\":\"archive-" + to_string (i % 8) + ".zip\"";
+
+    r += '}';
+  }
+
+  r += "]}";
+  return r;
+}
+
+static bool
+same (const manifest& x, const manifest& y)
+{
+  return x.archives == y.archives && x.files == y.files;
+}
+
+// Decode the document incrementally, n bytes at a time.
+//
+static manifest
+streamed (const string& s, manifest_format k, size_t n)
+{
+  manifest m;
+  m.kind = k;
+
+  manifest_decoder<manifest>::stream d (m);
+
+  for (size_t i (0); i < s.size (); i += n)
+    d.write (s.data () + i, min (n, s.size () - i));
+
+  d.finish ();
+  return m;
+}
+
+// Decode every way and make sure we get the same thing, including failing
+// the same way.
+//
+static void
+check (const string& s, manifest_format k = manifest_format::update)
+{
+  optional<manifest> d, v, i, o;
+
+  try {d = manifest (s, k);} catch (const runtime_error&) {}
+  try {v = manifest (boost::json::parse (s), k);} catch (const exception&) {}
+  try {i = streamed (s, k, 3);} catch (const exception&) {}
+  try {o = streamed (s, k, s.size ());} catch (const exception&) {}
+
+  assert (d.has_value () == v.has_value ());
+  assert (!d || same (*d, *v));
+
+  assert (d.has_value () == i.has_value ());
+  assert (!d || same (*d, *i));
+
+  assert (d.has_value () == o.has_value ());
+  assert (!d || same (*d, *o));
+}
+
+// Entries, unknown keys, and values of unexpected types.
+//
+static void
+test_entries ()
+{
+  string h (digest (1));
+
+  check ("{\"archives\":[{\"name\":\"a.zip\",\"blake3\":\"" + h + "\","
+         "\"size\":10,\"url\":\"u\",\"x\":{\"y\":[1,{}]}},"
+         "{\"url\":\"nameless\"},17,[\"a\"],"
+         "{\"name\":\"b.zip\",\"size\":\"ten\",\"compression\":\"gzip\"}],"
+         "\"files\":[{\"path\":\"p\",\"archive\":\"a.zip\",\"size\":-1},"
+         "{\"path\":\"q\",\"asset_name\":\"q\",\"blake3\":null}],"
+         "\"extra\":[{\"path\":\"r\"}]}");
+
+  // A larger document, fed to the incremental decoder in pieces that cut
+  // through keys, strings, and numbers alike.
+  //
+  string s (synthetic (1000));
+
+  check (s);
+  assert (streamed (s, manifest_format::update, 7).files.size () == 1000);
+}
+
+// DLC manifests have neither archives nor chunks.
+//
+static void
+test_dlc ()
+{
+  string h (digest (1));
+
+  check ("{\"archives\":[{\"name\":\"a.zip\"}],"
+         "\"files\":[{\"path\":\"p\",\"archive\":\"a.zip\",\"chunks\":"
+         "[{\"blake3\":\"" + h + "\",\"offset\":0,\"size\":1}]}]}",
+         manifest_format::dlc);
+}
+
+// Chunk lists are all or nothing.
+//
+static void
+test_chunks ()
+{
+  string h (digest (1));
+  string c ("{\"blake3\":\"" + h + "\",\"offset\":0,\"size\":4}");
+
+  check ("{\"files\":[{\"path\":\"p\",\"chunks\":[" + c + "]}]}");
+  check ("{\"files\":[{\"path\":\"p\",\"chunks\":[" + c + "," + c + "]}]}");
+  check ("{\"files\":[{\"path\":\"p\",\"chunks\":[" + c + ",1]}]}");
+  check ("{\"files\":[{\"path\":\"p\",\"chunks\":[{\"offset\":0,\"size\":4}]}]}");
+  check ("{\"files\":[{\"path\":\"p\",\"chunks\":"
+         "[{\"blake3\":\"" + h + "\",\"offset\":-1,\"size\":4}]}]}");
+}
+
+// Errors. Whatever the JSON parser rejects, so do we.
+//
+static void
+test_errors ()
+{
+  check ("[]");
+  check ("\"manifest\"");
+  check ("{\"files\":[");
+  check ("{} {}");
+  check ("{}  \n");
+  check ("{\"files\":[{\"path\":\"p\",\"blake3\":\"xyz\"}]}");
+  check ("{\"files\":[{\"path\":\"p\",\"compression\":\"zstd\"}]}");
+}
+
+int
+main ()
+{
+  test_entries ();
+  test_dlc ();
+  test_chunks ();
+  test_errors ();
+}
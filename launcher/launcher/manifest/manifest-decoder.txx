@@ -0,0 +1,618 @@
+#include <stdexcept>
+#include <utility>
+
+#include <boost/json/basic_parser_impl.hpp>
+
+namespace launcher
+{
+  template <typename M>
+  void manifest_decoder<M>::
+  decode (std::string_view s, manifest_type& m)
+  {
+    // We don't know the number of entries until we've seen them all, but
+    // growing the vectors by doubling means copying every entry a few times
+    // over and, at the end, holding up to twice the memory we need. Counting
+    // the keys every entry has is cheap in comparison and is a tight upper
+    // bound in practice.
+    //
+    auto count ([s] (std::string_view k)
+    {
+      std::size_t r (0);
+
+      for (std::size_t p (s.find (k));
+           p != std::string_view::npos;
+           p = s.find (k, p + k.size ()))
+        ++r;
+
+      return r;
+    });
+
+    m.files.reserve (m.files.size () + count ("\"path\""));
+
+    if (m.kind == manifest_format::update)
+      m.archives.reserve (m.archives.size () + count ("\"name\""));
+
+    json::basic_parser<manifest_decoder> p (json::parse_options (), m);
+
+    json::error_code ec;
+    std::size_t n (p.write_some (false, s.data (), s.size (), ec));
+
+    // Same as json::parse(), trailing whitespace is fine but nothing else.
+    //
+    if (!ec && n != s.size ())
+      ec = json::error::extra_data;
+
+    if (ec)
+      throw std::invalid_argument (ec.message ());
+  }
+
+  template <typename M>
+  manifest_decoder<M>::stream::
+  stream (manifest_type& m)
+    : p_ (json::parse_options (), m)
+  {
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::stream::
+  write (const char* d, std::size_t n)
+  {
+    json::error_code ec;
+    std::size_t r (p_.done () ? 0 : p_.write_some (true, d, n, ec));
+
+    // Same as decode(), trailing whitespace is fine but nothing else. Note
+    // that the parser stops once it has the whole document.
+    //
+    if (!ec && r != n)
+    {
+      for (const char* e (d + n), *i (d + r); i != e; ++i)
+      {
+        if (*i != ' ' && *i != '\t' && *i != '\n' && *i != '\r')
+        {
+          ec = json::error::extra_data;
+          break;
+        }
+      }
+    }
+
+    if (ec)
+      throw std::invalid_argument (ec.message ());
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::stream::
+  finish ()
+  {
+    if (p_.done ())
+      return;
+
+    json::error_code ec;
+    p_.write_some (false, nullptr, 0, ec);
+
+    if (ec)
+      throw std::invalid_argument (ec.message ());
+  }
+
+  template <typename M>
+  manifest_decoder<M>::
+  manifest_decoder (manifest_type& m)
+    : m_ (m)
+  {
+  }
+
+  template <typename M>
+  typename manifest_decoder<M>::field manifest_decoder<M>::
+  resolve (std::string_view k) const noexcept
+  {
+    if (k == "archives")    return field::archives;
+    if (k == "files")       return field::files;
+    if (k == "blake3")      return field::blake3;
+    if (k == "size")        return field::size;
+    if (k == "name")        return field::name;
+    if (k == "url")         return field::url;
+    if (k == "path")        return field::path;
+    if (k == "asset_name")  return field::asset_name;
+    if (k == "archive")     return field::archive;
+    if (k == "compression") return field::compression;
+    if (k == "chunks")      return field::chunks;
+    if (k == "offset")      return field::offset;
+
+    return field::other;
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::
+  value (std::string_view v)
+  {
+    switch (state_)
+    {
+    case state::entry:
+      {
+        bool a (section_ == field::archives);
+
+        switch (key_)
+        {
+        case field::blake3:
+          (a ? archive_.hash : file_.hash) = hash_type (string_type (v));
+          break;
+        case field::name:
+          if (a) archive_.name = string_type (v);
+          break;
+        case field::url:
+          if (a) archive_.url = string_type (v);
+          break;
+        case field::path:
+          if (!a) file_.path = string_type (v);
+          break;
+        case field::asset_name:
+          if (!a) file_.asset_name = string_type (v);
+          break;
+        case field::archive:
+          if (!a && m_.kind == manifest_format::update)
+            file_.archive_name = string_type (v);
+          break;
+        case field::compression:
+          {
+            std::string s (v);
+
+            // Unlike a missing chunk list, we can't just ignore this: the
+            // bytes we would download are not the bytes the hash describes.
+            //
+            auto c (parse_compression_type (s));
+
+            if (!c)
+              throw std::invalid_argument ("unsupported compression '" + s +
+                                           "'");
+
+            (a ? archive_.compression : file_.compression) = *c;
+            break;
+          }
+        default:
+          break;
+        }
+
+        return;
+      }
+    case state::chunk:
+      {
+        if (key_ != field::blake3)
+          break;
+
+        chunk_hash_.assign (v.data (), v.size ());
+        chunk_has_ |= 0x01;
+        return;
+      }
+    default:
+      break;
+    }
+
+    other ();
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::
+  value (std::uint64_t v, bool negative)
+  {
+    switch (state_)
+    {
+    case state::entry:
+      {
+        // Note that a negative size wraps around, same as the json::value
+        // based parser.
+        //
+        if (key_ == field::size)
+          (section_ == field::archives ? archive_.size : file_.size) = v;
+
+        return;
+      }
+    case state::chunk:
+      {
+        if (key_ != field::offset && key_ != field::size)
+          break;
+
+        if (negative)
+          chunk_bad_ = true;
+        else if (key_ == field::offset)
+        {
+          chunk_offset_ = v;
+          chunk_has_ |= 0x02;
+        }
+        else
+        {
+          chunk_size_ = v;
+          chunk_has_ |= 0x04;
+        }
+
+        return;
+      }
+    default:
+      break;
+    }
+
+    other ();
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::
+  other ()
+  {
+    switch (state_)
+    {
+    case state::document:
+      throw std::invalid_argument ("manifest JSON must be an object");
+
+    // Anything but an object in a chunk list spoils the whole list, same as
+    // a chunk field of the wrong type spoils the chunk.
+    //
+    case state::chunks:
+      chunks_bad_ = true;
+      break;
+    case state::chunk:
+      if (key_ == field::blake3 || key_ == field::offset || key_ == field::size)
+        chunk_bad_ = true;
+      break;
+    default:
+      break;
+    }
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::
+  finish_entry ()
+  {
+    if (section_ == field::archives)
+    {
+      archive_.chunks = std::move (chunks_);
+
+      if (!archive_.empty ())
+        m_.archives.push_back (std::move (archive_));
+    }
+    else
+    {
+      file_.chunks = std::move (chunks_);
+
+      if (!file_.empty ())
+        m_.files.push_back (std::move (file_));
+    }
+
+    chunks_.clear ();
+  }
+
+  template <typename M>
+  void manifest_decoder<M>::
+  finish_chunk ()
+  {
+    if (chunks_bad_)
+      return;
+
+    // The chunk list is all-or-nothing: a list with a hole in it is useless
+    // for patching (see basic_manifest::parse_chunks()).
+    //
+    if (chunk_bad_             ||
+        chunk_has_ != 0x07     ||
+        chunk_offset_ != next_ ||
+        chunk_size_ == 0)
+    {
+      chunks_bad_ = true;
+      return;
+    }
+
+    next_ += chunk_size_;
+
+    chunks_.emplace_back (hash_type (string_type (chunk_hash_)),
+                          chunk_offset_,
+                          chunk_size_);
+  }
+
+  // Handler interface.
+  //
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_document_begin (json::error_code&)
+  {
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_document_end (json::error_code&)
+  {
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_object_begin (json::error_code&)
+  {
+    if (skip_ != 0)
+    {
+      ++skip_;
+      return true;
+    }
+
+    switch (state_)
+    {
+    case state::document:
+      {
+        state_ = state::root;
+        break;
+      }
+    case state::section:
+      {
+        file_ = file_type ();
+        archive_ = archive_type ();
+        chunks_.clear ();
+        chunks_bad_ = false;
+        next_ = 0;
+
+        state_ = state::entry;
+        break;
+      }
+    case state::chunks:
+      {
+        chunk_hash_.clear ();
+        chunk_offset_ = 0;
+        chunk_size_ = 0;
+        chunk_has_ = 0;
+        chunk_bad_ = false;
+
+        state_ = state::chunk;
+        break;
+      }
+    default:
+      {
+        other ();
+        skip_ = 1;
+        break;
+      }
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_object_end (std::size_t, json::error_code&)
+  {
+    if (skip_ != 0)
+    {
+      --skip_;
+      return true;
+    }
+
+    switch (state_)
+    {
+    case state::root:
+      {
+        state_ = state::done;
+        break;
+      }
+    case state::entry:
+      {
+        finish_entry ();
+        state_ = state::section;
+        break;
+      }
+    case state::chunk:
+      {
+        finish_chunk ();
+        state_ = state::chunks;
+        break;
+      }
+    default:
+      break;
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_array_begin (json::error_code&)
+  {
+    if (skip_ != 0)
+    {
+      ++skip_;
+      return true;
+    }
+
+    switch (state_)
+    {
+    case state::root:
+      {
+        if (key_ == field::files ||
+            (key_ == field::archives && m_.kind == manifest_format::update))
+        {
+          section_ = key_;
+          state_ = state::section;
+        }
+        else
+          skip_ = 1;
+
+        break;
+      }
+    case state::entry:
+      {
+        if (key_ == field::chunks && m_.kind == manifest_format::update)
+        {
+          chunks_.clear ();
+          chunks_bad_ = false;
+          next_ = 0;
+
+          state_ = state::chunks;
+        }
+        else
+          skip_ = 1;
+
+        break;
+      }
+    default:
+      {
+        other ();
+        skip_ = 1;
+        break;
+      }
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_array_end (std::size_t, json::error_code&)
+  {
+    if (skip_ != 0)
+    {
+      --skip_;
+      return true;
+    }
+
+    switch (state_)
+    {
+    case state::section:
+      {
+        state_ = state::root;
+        break;
+      }
+    case state::chunks:
+      {
+        if (chunks_bad_)
+          chunks_.clear ();
+
+        state_ = state::entry;
+        break;
+      }
+    default:
+      break;
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_key_part (json::string_view s, std::size_t, json::error_code&)
+  {
+    if (skip_ == 0)
+      kbuf_.append (s.data (), s.size ());
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_key (json::string_view s, std::size_t, json::error_code&)
+  {
+    if (skip_ == 0)
+    {
+      kbuf_.append (s.data (), s.size ());
+      key_ = resolve (kbuf_);
+      kbuf_.clear ();
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_string_part (json::string_view s, std::size_t, json::error_code&)
+  {
+    if (skip_ == 0)
+      sbuf_.append (s.data (), s.size ());
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_string (json::string_view s, std::size_t, json::error_code&)
+  {
+    if (skip_ == 0)
+    {
+      // Most strings arrive in one piece so avoid the copy if we can.
+      //
+      if (sbuf_.empty ())
+        value (std::string_view (s.data (), s.size ()));
+      else
+      {
+        sbuf_.append (s.data (), s.size ());
+        value (sbuf_);
+        sbuf_.clear ();
+      }
+    }
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_number_part (json::string_view, json::error_code&)
+  {
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_int64 (std::int64_t v, json::string_view, json::error_code&)
+  {
+    if (skip_ == 0)
+      value (static_cast<std::uint64_t> (v), v < 0);
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_uint64 (std::uint64_t v, json::string_view, json::error_code&)
+  {
+    if (skip_ == 0)
+      value (v, false);
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_double (double, json::string_view, json::error_code&)
+  {
+    if (skip_ == 0)
+      other ();
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_bool (bool, json::error_code&)
+  {
+    if (skip_ == 0)
+      other ();
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_null (json::error_code&)
+  {
+    if (skip_ == 0)
+      other ();
+
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_comment_part (json::string_view, json::error_code&)
+  {
+    return true;
+  }
+
+  template <typename M>
+  bool manifest_decoder<M>::
+  on_comment (json::string_view, json::error_code&)
+  {
+    return true;
+  }
+}
@@ -0,0 +1,140 @@
+#include <launcher/manifest/manifest-decompress.hxx>
+
+#include <stdexcept>
+#include <utility>
+
+#include <launcher/launcher-log.hxx>
+
+using namespace std;
+
+namespace launcher
+{
+  stream_decompressor::
+  stream_decompressor (compression_type c,
+                       fs::path t,
+                       const blake3_digest& h)
+    : target_ (move (t)),
+      temp_ (target_.string () + ".part"),
+      hash_ (h)
+  {
+    if (!supported (c))
+      throw invalid_argument ("unsupported streaming compression: " +
+                              compression_name (c));
+
+    blake3_hasher_init (&hasher_);
+
+    os_.open (temp_, ios::binary | ios::out | ios::trunc);
+    if (!os_)
+      throw runtime_error ("failed to open file for writing: " +
+                           temp_.string ());
+
+    dec_ = make_unique<content_decoder> (
+      content_decoder::coding::gzip,
+      [this] (const char* d, size_t n)
+      {
+        if (!hash_.empty ())
+          blake3_hasher_update (&hasher_, d, n);
+
+        os_.write (d, static_cast<streamsize> (n));
+
+        if (!os_)
+          throw runtime_error ("failed to write file: " + temp_.string ());
+
+        return true;
+      });
+  }
+
+  stream_decompressor::
+  ~stream_decompressor ()
+  {
+    // Don't leave a partial file behind if the transfer didn't make it.
+    //
+    if (!done_)
+    {
+      os_.close ();
+
+      error_code ec;
+      fs::remove (temp_, ec);
+    }
+  }
+
+  bool stream_decompressor::
+  supported (compression_type c) noexcept
+  {
+    return c == compression_type::gzip;
+  }
+
+  bool stream_decompressor::
+  write (const char* d, size_t n)
+  {
+    if (done_)
+      throw runtime_error ("unexpected data after end of gzip stream for " +
+                           target_.string ());
+
+    // The decoder doesn't know what it is decoding, so say which asset it
+    // choked on.
+    //
+    try
+    {
+      dec_->write (d, n);
+    }
+    catch (const runtime_error& e)
+    {
+      throw runtime_error (string (e.what ()) + " for " + target_.string ());
+    }
+
+    if (dec_->complete ())
+      finish ();
+
+    return true;
+  }
+
+  bool stream_decompressor::
+  complete () const noexcept
+  {
+    return done_;
+  }
+
+  const fs::path& stream_decompressor::
+  target () const noexcept
+  {
+    return target_;
+  }
+
+  void stream_decompressor::
+  finish ()
+  {
+    if (!hash_.empty ())
+    {
+      blake3_digest h;
+      blake3_hasher_finalize (&hasher_, h.data (), h.size ());
+
+      if (h != hash_)
+        throw runtime_error ("hash mismatch for decompressed " +
+                             target_.string ());
+    }
+
+    os_.close ();
+    if (!os_)
+      throw runtime_error ("failed to write file: " + temp_.string ());
+
+    error_code ec;
+    fs::rename (temp_, target_, ec);
+
+    if (ec)
+    {
+      // Windows refuses to rename over an existing file in some setups.
+      //
+      fs::remove (target_, ec);
+      fs::rename (temp_, target_, ec);
+
+      if (ec)
+        throw runtime_error ("failed to move " + temp_.string () + " to " +
+                             target_.string () + ": " + ec.message ());
+    }
+
+    launcher::log::trace_l3 (categories::manifest{}, "decompressed {} bytes to {}", dec_->size (), target_.string ());
+
+    done_ = true;
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <fstream>
+#include <filesystem>
+
+#include <launcher/blake3.h>
+
+#include <launcher/http/http-decoder.hxx>
+#include <launcher/manifest/manifest-types.hxx>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Streaming decompressor for single-file assets.
+  //
+  // Consumes a compressed asset as it comes off the wire and writes the
+  // decompressed bytes next to the target, renaming it into place once the
+  // stream ends and its trailer checks out. That is, the target is either
+  // left untouched or replaced with a complete file, never a partial one.
+  //
+  // The gzip CRC only guards against transfer damage, so if the expected
+  // hash of the decompressed content is known, the bytes are hashed on the
+  // way to disk and the target is only replaced if they match.
+  //
+  // Only gzip (RFC 1952, single member) is supported. The decoding itself
+  // is content_decoder's, the same as for a gzip content coding.
+  //
+  class stream_decompressor
+  {
+  public:
+    stream_decompressor (compression_type,
+                         fs::path target,
+                         const blake3_digest& hash = blake3_digest ());
+
+    ~stream_decompressor ();
+
+    stream_decompressor (const stream_decompressor&) = delete;
+    stream_decompressor& operator= (const stream_decompressor&) = delete;
+
+    // Return true if we can decompress this type on the fly.
+    //
+    static bool
+    supported (compression_type) noexcept;
+
+    // Consume the next chunk of the asset. Throws on corrupt data, including
+    // anything past the end of the stream.
+    //
+    bool
+    write (const char* data, std::size_t size);
+
+    // Return true if the stream ended and the target was replaced.
+    //
+    bool
+    complete () const noexcept;
+
+    const fs::path&
+    target () const noexcept;
+
+  private:
+    void
+    finish ();
+
+  private:
+    fs::path target_;
+    fs::path temp_;
+    std::ofstream os_;
+    bool done_ = false;
+    std::unique_ptr<content_decoder> dec_;
+    blake3_digest hash_;
+    blake3_hasher hasher_;
+  };
+}
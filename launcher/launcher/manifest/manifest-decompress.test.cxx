@@ -0,0 +1,298 @@
+#include <launcher/manifest/manifest-decompress.hxx>
+
+#include <string>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <filesystem>
+
+#include <miniz.h>
+
+using namespace std;
+using namespace launcher;
+
+namespace fs = std::filesystem;
+
+// Stream construction.
+//
+// We assemble the gzip members by hand so that we can set the optional
+// header fields (which gzip tools rarely emit) and corrupt the trailer.
+//
+static void
+put16 (string& b, uint16_t v)
+{
+  b += static_cast<char> (v & 0xff);
+  b += static_cast<char> (v >> 8);
+}
+
+static void
+put32 (string& b, uint32_t v)
+{
+  put16 (b, static_cast<uint16_t> (v & 0xffff));
+  put16 (b, static_cast<uint16_t> (v >> 16));
+}
+
+// Raw deflate, that is, a zlib stream without its 2-byte header and
+// 4-byte Adler-32 trailer.
+//
+static string
+deflate (const string& s)
+{
+  mz_ulong n (mz_compressBound (static_cast<mz_ulong> (s.size ())));
+  string r (n, '\0');
+
+  int e (mz_compress (reinterpret_cast<unsigned char*> (&r[0]),
+                      &n,
+                      reinterpret_cast<const unsigned char*> (s.data ()),
+                      static_cast<mz_ulong> (s.size ())));
+  assert (e == MZ_OK);
+
+  return r.substr (2, n - 6);
+}
+
+struct member
+{
+  string data;
+  string extra = "";       // FEXTRA payload, if not empty.
+  string name = "";        // FNAME, if not empty.
+  string comment = "";     // FCOMMENT, if not empty.
+  bool hcrc = false;       // FHCRC (we don't check its value).
+  uint32_t crc_adjust = 0; // Corrupt the recorded CRC.
+};
+
+static string
+gzip (const member& m)
+{
+  uint8_t f ((m.hcrc            ? 0x02 : 0) |
+             (!m.extra.empty ()   ? 0x04 : 0) |
+             (!m.name.empty ()    ? 0x08 : 0) |
+             (!m.comment.empty () ? 0x10 : 0));
+
+  string r ("\x1f\x8b\x08", 3);
+  r += static_cast<char> (f);
+  put32 (r, 0);  // MTIME
+  r += '\0';     // XFL
+  r += '\xff';   // OS
+
+  if (!m.extra.empty ())
+  {
+    put16 (r, static_cast<uint16_t> (m.extra.size ()));
+    r += m.extra;
+  }
+
+  if (!m.name.empty ())
+    r += m.name + '\0';
+
+  if (!m.comment.empty ())
+    r += m.comment + '\0';
+
+  if (m.hcrc)
+    put16 (r, 0);
+
+  r += deflate (m.data);
+
+  put32 (r, static_cast<uint32_t> (
+         mz_crc32 (0,
+                   reinterpret_cast<const unsigned char*> (m.data.data ()),
+                   m.data.size ())) + m.crc_adjust);
+  put32 (r, static_cast<uint32_t> (m.data.size ()));
+
+  return r;
+}
+
+static blake3_digest
+digest (const string& s)
+{
+  blake3_hasher h;
+  blake3_hasher_init (&h);
+  blake3_hasher_update (&h, s.data (), s.size ());
+
+  blake3_digest r;
+  blake3_hasher_finalize (&h, r.data (), r.size ());
+  return r;
+}
+
+static string
+content (const fs::path& p)
+{
+  ifstream is (p, ios::binary);
+  return string (istreambuf_iterator<char> (is), {});
+}
+
+static fs::path
+scratch (const char* n)
+{
+  fs::path d (fs::temp_directory_path () / n);
+  fs::remove_all (d);
+  fs::create_directories (d);
+  return d;
+}
+
+// Feed the stream to the decompressor in pieces of (at most) n bytes.
+//
+static void
+feed (stream_decompressor& x, const string& s, size_t n)
+{
+  for (size_t o (0); o < s.size (); o += n)
+    x.write (s.data () + o, min (n, s.size () - o));
+}
+
+static bool
+fails (stream_decompressor& x, const string& s, size_t n)
+{
+  try
+  {
+    feed (x, s, n);
+    return false;
+  }
+  catch (const runtime_error&)
+  {
+    return true;
+  }
+}
+
+static string
+big ()
+{
+  string r;
+  for (size_t i (0); i != 200000; ++i)
+    r += static_cast<char> ('a' + i * 7 % 23);
+  return r;
+}
+
+// Split writes. The header, data, and trailer may be cut anywhere, so
+// decompress the same stream with a range of chunk sizes, down to a byte at
+// a time. The target only appears once the stream is complete.
+//
+static void
+test_split ()
+{
+  fs::path d (scratch ("iw4x-decompress-test-split"));
+  fs::path t (d / "asset.bin");
+
+  string c (big ());
+  string g (gzip ({c}));
+
+  for (size_t n: {size_t (1), size_t (3), size_t (4096), g.size ()})
+  {
+    fs::remove (t);
+
+    stream_decompressor x (compression_type::gzip, t, digest (c));
+
+    feed (x, g.substr (0, g.size () - 1), n);
+    assert (!x.complete ());
+    assert (!fs::exists (t));
+
+    x.write (g.data () + g.size () - 1, 1);
+    assert (x.complete ());
+    assert (content (t) == c);
+    assert (!fs::exists (d / "asset.bin.part"));
+  }
+
+  fs::remove_all (d);
+}
+
+// Optional header fields. We skip FEXTRA (including one that is cut
+// between its length and payload), FNAME, FCOMMENT, and FHCRC.
+//
+static void
+test_flags ()
+{
+  fs::path d (scratch ("iw4x-decompress-test-flags"));
+  fs::path t (d / "asset.bin");
+
+  member m {"hello, world"};
+  m.extra = string (300, 'x');
+  m.name = "asset.bin";
+  m.comment = "not a comment";
+  m.hcrc = true;
+
+  for (size_t n: {size_t (1), size_t (11), size_t (12), size_t (1024)})
+  {
+    stream_decompressor x (compression_type::gzip, t);
+
+    feed (x, gzip (m), n);
+    assert (x.complete ());
+    assert (content (t) == m.data);
+  }
+
+  fs::remove_all (d);
+}
+
+// Corruption. A bad CRC, a hash mismatch, or trailing garbage are errors
+// and, unless the stream already ended, leave the existing target (and
+// nothing else) behind.
+//
+static void
+test_corrupt ()
+{
+  fs::path d (scratch ("iw4x-decompress-test-corrupt"));
+  fs::path t (d / "asset.bin");
+
+  auto check ([&d, &t] (const string& g,
+                        const blake3_digest& h,
+                        size_t n = 7)
+  {
+    {
+      ofstream os (t, ios::binary | ios::trunc);
+      os << "old";
+    }
+
+    {
+      stream_decompressor x (compression_type::gzip, t, h);
+
+      assert (fails (x, g, n));
+      assert (!x.complete ());
+    }
+
+    assert (content (t) == "old");
+    assert (!fs::exists (d / "asset.bin.part"));
+  });
+
+  string c (big ());
+
+  {
+    member m {c};
+    m.crc_adjust = 1;
+    check (gzip (m), blake3_digest ());
+  }
+
+  check (gzip ({c}), digest (c + "x"));
+
+  // Not gzip at all.
+  //
+  check (string ("PK\x03\x04 and then some more bytes"), blake3_digest ());
+
+  // Trailing garbage. If it comes with the end of the stream, the stream
+  // is rejected as a whole.
+  //
+  {
+    string g (gzip ({c}) + "garbage");
+    check (g, blake3_digest (), g.size ());
+  }
+
+  // If it only comes after, the target is already in place (the stream
+  // itself checked out) but we still complain.
+  //
+  {
+    string g (gzip ({c}));
+    stream_decompressor x (compression_type::gzip, t);
+
+    assert (x.write (g.data (), g.size ()));
+    assert (x.complete ());
+    assert (content (t) == c);
+    assert (fails (x, "garbage", 7));
+  }
+
+  fs::remove_all (d);
+}
+
+int
+main ()
+{
+  test_split ();
+  test_flags ();
+  test_corrupt ();
+}
@@ -0,0 +1,129 @@
+#include <launcher/manifest/manifest-diff.hxx>
+
+#include <unordered_map>
+
+#include <launcher/launcher-log.hxx>
+
+using namespace std;
+
+namespace launcher
+{
+  // Note that we don't look at archive file lists: they are derived from the
+  // manifest files (which we diff on their own) and the archive hash already
+  // covers its content.
+  //
+  static bool
+  same (const manifest_archive& x, const manifest_archive& y)
+  {
+    return !x.hash.empty () &&
+           x.hash == y.hash &&
+           x.size == y.size &&
+           x.compression == y.compression;
+  }
+
+  static bool
+  same (const manifest_file& x, const manifest_file& y)
+  {
+    return !x.hash.empty ()               &&
+           x.hash == y.hash               &&
+           x.size == y.size               &&
+           x.compression == y.compression &&
+           x.asset_name == y.asset_name   &&
+           x.archive_name == y.archive_name;
+  }
+
+  // Split target entries (archives or files) into the diff sets, keyed on
+  // the name returned by k.
+  //
+  template <typename T, typename K>
+  static void
+  diff (const vector<T>& is,
+        const vector<T>& ts,
+        K k,
+        vector<T>& added,
+        vector<T>& changed,
+        vector<T>& removed,
+        vector<T>& unchanged)
+  {
+    unordered_map<string, const T*> m;
+    m.reserve (is.size ());
+
+    for (const T& e: is)
+      m.emplace (k (e), &e);
+
+    for (const T& e: ts)
+    {
+      auto i (m.find (k (e)));
+
+      if (i == m.end ())
+        added.push_back (e);
+      else
+      {
+        (same (*i->second, e) ? unchanged : changed).push_back (e);
+
+        // Mark as seen so whatever is left over is what was removed.
+        //
+        i->second = nullptr;
+      }
+    }
+
+    // Go over the installed entries rather than the map to keep removals in
+    // manifest order.
+    //
+    for (const T& e: is)
+    {
+      auto i (m.find (k (e)));
+
+      if (i != m.end () && i->second != nullptr)
+        removed.push_back (e);
+    }
+  }
+
+  manifest manifest_diff::
+  delta () const
+  {
+    manifest r (added.format, added.kind);
+
+    for (const manifest* m: {&added, &changed})
+    {
+      r.archives.insert (r.archives.end (),
+                         m->archives.begin (), m->archives.end ());
+
+      r.files.insert (r.files.end (), m->files.begin (), m->files.end ());
+    }
+
+    return r;
+  }
+
+  manifest_diff
+  diff_manifests (const manifest& installed, const manifest& target)
+  {
+    manifest_diff r;
+
+    for (manifest* m: {&r.added, &r.changed, &r.removed, &r.unchanged})
+    {
+      m->format = target.format;
+      m->kind = target.kind;
+    }
+
+    diff (installed.archives,
+          target.archives,
+          [] (const manifest_archive& a) -> const string& {return a.name;},
+          r.added.archives,
+          r.changed.archives,
+          r.removed.archives,
+          r.unchanged.archives);
+
+    diff (installed.files,
+          target.files,
+          [] (const manifest_file& f) -> const string& {return f.path;},
+          r.added.files,
+          r.changed.files,
+          r.removed.files,
+          r.unchanged.files);
+
+    launcher::log::debug (categories::manifest{}, "manifest diff: {} added, {} changed, {} removed, {} unchanged", r.added.archives.size () + r.added.files.size (), r.changed.archives.size () + r.changed.files.size (), r.removed.archives.size () + r.removed.files.size (), r.unchanged.archives.size () + r.unchanged.files.size ());
+
+    return r;
+  }
+}
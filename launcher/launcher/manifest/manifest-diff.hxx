@@ -0,0 +1,43 @@
+#pragma once
+
+#include <launcher/manifest/manifest.hxx>
+
+namespace launcher
+{
+  // Difference between the manifest we installed and the one we are about to
+  // install.
+  //
+  // Entries are matched by identity (archive name, file path) and compared
+  // by content (hash, size, compression, and for files where they come
+  // from). Anything without a hash cannot be proven unchanged and so always
+  // counts as changed.
+  //
+  // Each set is a manifest in its own right so that it can be fed straight
+  // to the reconciler. Added, changed, and unchanged entries are taken from
+  // the target; removed ones from the installed manifest.
+  //
+  // Note that archive URLs are not compared: release download URLs embed
+  // the tag and so change with every release even if the bytes don't.
+  //
+  struct manifest_diff
+  {
+    manifest added;
+    manifest changed;
+    manifest removed;
+    manifest unchanged;
+
+    // Added and changed entries, that is, what needs planning.
+    //
+    manifest
+    delta () const;
+
+    bool
+    empty () const noexcept
+    {
+      return added.empty () && changed.empty () && removed.empty ();
+    }
+  };
+
+  manifest_diff
+  diff_manifests (const manifest& installed, const manifest& target);
+}
@@ -0,0 +1,146 @@
+#include <launcher/manifest/manifest-diff.hxx>
+
+#include <cassert>
+#include <optional>
+#include <string>
+
+using namespace std;
+using namespace launcher;
+
+static manifest::hash_type
+digest (char c)
+{
+  return manifest::hash_type (string (64, c));
+}
+
+static manifest_file
+file (const string& p, char h, optional<string> a = nullopt)
+{
+  return manifest_file (digest (h), 1, p, nullopt, move (a));
+}
+
+static manifest_archive
+archive (const string& n, char h, const string& url)
+{
+  return manifest_archive (digest (h), 1, n, url);
+}
+
+// A release and its successor, touching every kind of change.
+//
+static manifest
+installed ()
+{
+  manifest m;
+  m.archives.push_back (archive ("a.zip", '1', "https://host/r1/a.zip"));
+  m.archives.push_back (archive ("b.zip", '2', "https://host/r1/b.zip"));
+  m.archives.push_back (archive ("c.zip", '3', "https://host/r1/c.zip"));
+  m.files.push_back (file ("zone/x.ff", '4'));
+  m.files.push_back (file ("zone/y.ff", '5'));
+  m.files.push_back (file ("main/z", '6', string ("a.zip")));
+  return m;
+}
+
+static manifest
+target ()
+{
+  manifest m;
+  m.archives.push_back (archive ("a.zip", '1', "https://host/r2/a.zip"));
+  m.archives.push_back (archive ("b.zip", '7', "https://host/r2/b.zip"));
+  m.archives.push_back (archive ("d.zip", '8', "https://host/r2/d.zip"));
+  m.files.push_back (file ("zone/x.ff", '4'));
+  m.files.push_back (file ("zone/y.ff", '9'));
+  m.files.push_back (file ("main/z", '6', string ("b.zip")));
+  m.files.push_back (file ("zone/w.ff", 'a'));
+  return m;
+}
+
+// Identical manifests have nothing to plan.
+//
+static void
+test_identical ()
+{
+  manifest t (target ());
+  manifest_diff d (diff_manifests (t, t));
+
+  assert (d.empty ());
+  assert (d.delta ().empty ());
+  assert (d.unchanged.archives == t.archives);
+  assert (d.unchanged.files == t.files);
+}
+
+// Archives are matched by name and files by path. A new URL alone is not a
+// change, a different hash or a move to another archive is.
+//
+static void
+test_changes ()
+{
+  manifest_diff d (diff_manifests (installed (), target ()));
+
+  assert (!d.empty ());
+
+  assert (d.added.archives.size () == 1);
+  assert (d.added.archives[0].name == "d.zip");
+  assert (d.added.files.size () == 1);
+  assert (d.added.files[0].path == "zone/w.ff");
+
+  assert (d.changed.archives.size () == 1);
+  assert (d.changed.archives[0].name == "b.zip");
+  assert (d.changed.archives[0].url == "https://host/r2/b.zip");
+  assert (d.changed.files.size () == 2);
+  assert (d.changed.files[0].path == "zone/y.ff");
+  assert (d.changed.files[1].path == "main/z");
+
+  assert (d.removed.archives.size () == 1);
+  assert (d.removed.archives[0].name == "c.zip");
+  assert (d.removed.files.empty ());
+
+  assert (d.unchanged.archives.size () == 1);
+  assert (d.unchanged.archives[0].url == "https://host/r2/a.zip");
+  assert (d.unchanged.files.size () == 1);
+  assert (d.unchanged.files[0].path == "zone/x.ff");
+
+  manifest m (d.delta ());
+  assert (m.archives.size () == 2);
+  assert (m.files.size () == 3);
+}
+
+// Without a hash we cannot tell, so it is always a change.
+//
+static void
+test_hashless ()
+{
+  manifest x;
+  x.files.push_back (manifest_file (manifest::hash_type (), 1, "zone/x.ff"));
+
+  manifest_diff d (diff_manifests (x, x));
+
+  assert (d.changed.files.size () == 1);
+  assert (d.unchanged.empty ());
+}
+
+// Everything is removed going to an empty manifest and added coming from
+// one.
+//
+static void
+test_empty ()
+{
+  manifest i (installed ());
+  manifest e;
+
+  manifest_diff r (diff_manifests (i, e));
+  assert (r.removed.archives == i.archives && r.removed.files == i.files);
+  assert (r.delta ().empty ());
+
+  manifest_diff a (diff_manifests (e, i));
+  assert (a.added.archives == i.archives && a.added.files == i.files);
+  assert (a.removed.empty ());
+}
+
+int
+main ()
+{
+  test_identical ();
+  test_changes ();
+  test_hashless ();
+  test_empty ();
+}
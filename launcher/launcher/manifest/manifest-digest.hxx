@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <functional>
+#include <string_view>
+
+namespace launcher
+{
+  // BLAKE3 digest.
+  //
+  // Manifests and the db carry hashes as 64 hex characters but all we ever
+  // do with them is compare, so we keep the 32 raw bytes instead and only
+  // go to (and from) hex at the edges. A default-constructed (all zeros)
+  // digest means "no hash".
+  //
+  class blake3_digest
+  {
+  public:
+    static constexpr std::size_t size_bytes = 32;
+
+    using bytes_type = std::array<std::uint8_t, size_bytes>;
+
+    constexpr
+    blake3_digest () noexcept : bytes_ {} {}
+
+    constexpr explicit
+    blake3_digest (const bytes_type& b) noexcept : bytes_ (b) {}
+
+    // Copy size_bytes bytes.
+    //
+    explicit
+    blake3_digest (const std::uint8_t* d) noexcept
+    {
+      std::memcpy (bytes_.data (), d, size_bytes);
+    }
+
+    // Parse 64 hex characters in either case. Return nullopt if that's not
+    // what we've got.
+    //
+    static constexpr std::optional<blake3_digest>
+    from_hex (std::string_view s) noexcept
+    {
+      if (s.size () != size_bytes * 2)
+        return std::nullopt;
+
+      bytes_type b {};
+
+      for (std::size_t i (0); i != size_bytes; ++i)
+      {
+        int h (unhex (s[i * 2]));
+        int l (unhex (s[i * 2 + 1]));
+
+        if (h < 0 || l < 0)
+          return std::nullopt;
+
+        b[i] = static_cast<std::uint8_t> (h << 4 | l);
+      }
+
+      return blake3_digest (b);
+    }
+
+    // Write 64 lower-case hex characters (no terminator).
+    //
+    constexpr void
+    hex (char* r) const noexcept
+    {
+      constexpr char x[] = "0123456789abcdef";
+
+      for (std::size_t i (0); i != size_bytes; ++i)
+      {
+        r[i * 2]     = x[bytes_[i] >> 4];
+        r[i * 2 + 1] = x[bytes_[i] & 0x0f];
+      }
+    }
+
+    // Return the hex representation or the empty string if there is no
+    // hash.
+    //
+    std::string
+    hex () const
+    {
+      std::string r;
+
+      if (!empty ())
+      {
+        r.resize (size_bytes * 2);
+        hex (r.data ());
+      }
+
+      return r;
+    }
+
+    constexpr bool
+    empty () const noexcept
+    {
+      for (std::uint8_t b: bytes_)
+        if (b != 0)
+          return false;
+
+      return true;
+    }
+
+    // Raw access, for instance, to finalize a hasher into.
+    //
+    std::uint8_t*
+    data () noexcept { return bytes_.data (); }
+
+    const std::uint8_t*
+    data () const noexcept { return bytes_.data (); }
+
+    static constexpr std::size_t
+    size () noexcept { return size_bytes; }
+
+    constexpr const bytes_type&
+    bytes () const noexcept { return bytes_; }
+
+    friend constexpr bool
+    operator== (const blake3_digest& x, const blake3_digest& y) noexcept
+    {
+      return x.bytes_ == y.bytes_;
+    }
+
+    friend constexpr bool
+    operator!= (const blake3_digest& x, const blake3_digest& y) noexcept
+    {
+      return !(x == y);
+    }
+
+    friend constexpr bool
+    operator< (const blake3_digest& x, const blake3_digest& y) noexcept
+    {
+      return x.bytes_ < y.bytes_;
+    }
+
+  private:
+    static constexpr int
+    unhex (char c) noexcept
+    {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    }
+
+    bytes_type bytes_;
+  };
+}
+
+namespace std
+{
+  // The digest is already uniformly distributed so any 8 bytes of it make
+  // a perfectly good hash.
+  //
+  template <>
+  struct hash<launcher::blake3_digest>
+  {
+    size_t
+    operator() (const launcher::blake3_digest& d) const noexcept
+    {
+      size_t r;
+      memcpy (&r, d.data (), sizeof (r));
+      return r;
+    }
+  };
+}
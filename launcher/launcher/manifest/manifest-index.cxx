@@ -0,0 +1,81 @@
+#include <launcher/manifest/manifest-index.hxx>
+
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace launcher
+{
+  const manifest& manifest_index::
+  source () const noexcept
+  {
+    return *m_;
+  }
+
+  const manifest_index::entry& manifest_index::
+  archive (size_t i) const noexcept
+  {
+    return archives_[i];
+  }
+
+  const manifest_index::entry& manifest_index::
+  file (size_t i) const noexcept
+  {
+    return files_[i];
+  }
+
+  span<const manifest_index::entry> manifest_index::
+  contents (size_t i) const noexcept
+  {
+    return span<const entry> (contents_.data () + first_[i],
+                              first_[i + 1] - first_[i]);
+  }
+
+  optional<size_t> manifest_index::
+  find_archive (string_view p) const
+  {
+    auto i (by_path_.find (p));
+    return i != by_path_.end () ? optional<size_t> (i->second) : nullopt;
+  }
+
+  optional<size_t> manifest_index::
+  find_asset (string_view n) const
+  {
+    auto i (by_asset_.find (n));
+    return i != by_asset_.end () ? optional<size_t> (i->second) : nullopt;
+  }
+
+  string_view manifest_index::
+  intern (string_view s)
+  {
+    if (s.empty ())
+      return string_view ();
+
+    if (auto i = strings_.find (s); i != strings_.end ())
+      return *i;
+
+    // Most strings are paths so a block fits a few hundred of them. Anything
+    // that doesn't fit gets a block of its own.
+    //
+    const size_t block (16384);
+
+    if (s.size () > free_)
+    {
+      size_t n (max (block, s.size ()));
+      blocks_.push_back (make_unique<char[]> (n));
+      free_ = n;
+    }
+
+    // Fill the block from the back, which works the same whether or not it
+    // is of the default size.
+    //
+    char* p (blocks_.back ().get () + (free_ - s.size ()));
+    memcpy (p, s.data (), s.size ());
+    free_ -= s.size ();
+
+    string_view r (p, s.size ());
+    strings_.insert (r);
+    return r;
+  }
+}
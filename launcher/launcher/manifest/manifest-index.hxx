@@ -0,0 +1,119 @@
+#pragma once
+
+#include <launcher/manifest/manifest.hxx>
+
+#include <span>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Resolved view of a manifest.
+  //
+  // Everyone downstream of the manifest (reconciler, extractor, controller)
+  // needs the same few things for each entry: where it is installed, its db
+  // key, its file name, and the release asset it comes from. None of these
+  // are free to derive (path resolution has its heuristics and the db key
+  // canonicalization goes to the filesystem) yet each of them used to do it
+  // on its own and some more than once per run.
+  //
+  // So instead we derive them once per manifest, after link_files(), into
+  // arrays parallel to the manifest's archives and files. The strings are
+  // interned which means that the same name (a file name is more often than
+  // not also its asset name) is only stored once.
+  //
+  // Note that the index refers to the manifest and so the manifest must
+  // outlive it and not change in the meantime.
+  //
+  class manifest_index
+  {
+  public:
+    struct entry
+    {
+      fs::path         path;  // Install location.
+      std::string_view key;   // Db key.
+      std::string_view name;  // File name.
+      std::string_view asset; // Release asset name, empty if none.
+    };
+
+    manifest_index () = default;
+
+    // Resolve the entries of m with r which should provide path() for
+    // archives and files, key(), and root(), same as the reconciler.
+    //
+    template <typename R>
+    manifest_index (const manifest& m, const R& r);
+
+    manifest_index (manifest_index&&) = default;
+    manifest_index& operator= (manifest_index&&) = default;
+
+    manifest_index (const manifest_index&) = delete;
+    manifest_index& operator= (const manifest_index&) = delete;
+
+    const manifest&
+    source () const noexcept;
+
+    // Entries parallel to the manifest's archives and files. For an archive
+    // the asset is its name.
+    //
+    const entry&
+    archive (std::size_t i) const noexcept;
+
+    const entry&
+    file (std::size_t i) const noexcept;
+
+    // Entries parallel to the files an (exploded) archive lists.
+    //
+    // Note that while the path is where the extractor puts the file, the key
+    // is that of its path in the archive anchored at the root as is, which
+    // is how plan_archives() tracks it.
+    //
+    std::span<const entry>
+    contents (std::size_t i) const noexcept;
+
+    // Lookups. If there are several candidates, the last one wins.
+    //
+
+    // Archive by its install location.
+    //
+    std::optional<std::size_t>
+    find_archive (std::string_view path) const;
+
+    // File by its asset name.
+    //
+    std::optional<std::size_t>
+    find_asset (std::string_view name) const;
+
+  private:
+    std::string_view
+    intern (std::string_view);
+
+    const manifest* m_ = nullptr;
+
+    std::vector<entry> archives_;
+    std::vector<entry> files_;
+    std::vector<entry> contents_;
+    std::vector<std::size_t> first_; // Archive's first entry in contents_.
+
+    std::unordered_map<std::string_view, std::size_t> by_path_;
+    std::unordered_map<std::string_view, std::size_t> by_asset_;
+
+    // String pool. Blocks are never reallocated so the views into them stay
+    // valid, including across moves.
+    //
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t free_ = 0; // Space left in the last block.
+    std::unordered_set<std::string_view> strings_;
+  };
+}
+
+#include <launcher/manifest/manifest-index.txx>
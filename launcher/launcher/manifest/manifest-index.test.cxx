@@ -0,0 +1,150 @@
+#include <launcher/manifest/manifest-index.hxx>
+
+#include <cassert>
+#include <optional>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace launcher;
+
+// Stand-in for the reconciler: keys are paths, as is, prefixed so that we
+// can tell them apart.
+//
+struct resolver
+{
+  fs::path root_ {"/r"};
+
+  const fs::path&
+  root () const {return root_;}
+
+  fs::path
+  path (const manifest_file& f) const {return root_ / "f" / f.path;}
+
+  fs::path
+  path (const manifest_archive& a) const {return root_ / a.name;}
+
+  string
+  key (const fs::path& p) const {return "k:" + p.string ();}
+};
+
+// An archive with contents, a blob archive, a stand-alone file, and a file
+// that comes from the first archive.
+//
+static manifest
+sample ()
+{
+  manifest m;
+
+  manifest_archive a (manifest::hash_type (), 1, "a.zip", "https://host/a.zip");
+  a.files.push_back (manifest_file (manifest::hash_type (), 1, "zone/x.ff"));
+  a.files.push_back (manifest_file (manifest::hash_type (), 1, "zone/y.ff"));
+
+  m.archives.push_back (move (a));
+  m.archives.push_back (manifest_archive (manifest::hash_type (),
+                                          1,
+                                          "b.iwd",
+                                          "https://host/b.iwd"));
+
+  m.files.push_back (manifest_file (manifest::hash_type (),
+                                    1,
+                                    "main/z.dll",
+                                    string ("z.dll")));
+  m.files.push_back (manifest_file (manifest::hash_type (),
+                                    1,
+                                    "zone/x.ff",
+                                    nullopt,
+                                    string ("a.zip")));
+
+  return m;
+}
+
+// Archives. Also move the index to make sure nothing refers into the
+// original.
+//
+static void
+test_archives ()
+{
+  manifest m (sample ());
+  manifest_index t (m, resolver ());
+  manifest_index ix (move (t));
+
+  assert (&ix.source () == &m);
+
+  assert (ix.archive (0).path == "/r/a.zip");
+  assert (ix.archive (0).key == "k:/r/a.zip");
+  assert (ix.archive (0).name == "a.zip");
+  assert (ix.archive (0).asset == "a.zip");
+
+  assert (ix.archive (1).path == "/r/b.iwd");
+}
+
+// Archive contents are extracted to their resolved path but keyed by their
+// path in the archive.
+//
+static void
+test_contents ()
+{
+  manifest m (sample ());
+  manifest_index ix (m, resolver ());
+
+  auto cs (ix.contents (0));
+
+  assert (cs.size () == 2);
+  assert (cs[0].path == "/r/f/zone/x.ff");
+  assert (cs[0].key == "k:/r/zone/x.ff");
+  assert (cs[1].name == "y.ff");
+  assert (cs[1].asset.empty ());
+
+  assert (ix.contents (1).empty ());
+}
+
+// Files. Those in archives are keyed like archive contents, and equal
+// strings are only stored once.
+//
+static void
+test_files ()
+{
+  manifest m (sample ());
+  manifest_index ix (m, resolver ());
+
+  assert (ix.file (0).path == "/r/f/main/z.dll");
+  assert (ix.file (0).key == "k:/r/f/main/z.dll");
+  assert (ix.file (0).asset == "z.dll");
+  assert (ix.file (1).key == "k:/r/zone/x.ff");
+
+  assert (ix.file (0).name.data () == ix.file (0).asset.data ());
+  assert (ix.file (1).key.data () == ix.contents (0)[0].key.data ());
+}
+
+// Lookups are by resolved archive path and by asset name. An empty
+// manifest has an empty index.
+//
+static void
+test_lookups ()
+{
+  manifest m (sample ());
+  manifest_index ix (m, resolver ());
+
+  assert (ix.find_archive ("/r/b.iwd") == 1);
+  assert (!ix.find_archive ("/r/c.zip"));
+  assert (!ix.find_archive ("b.iwd"));
+
+  assert (ix.find_asset ("z.dll") == 0);
+  assert (!ix.find_asset ("x.ff"));
+
+  manifest e;
+  manifest_index ei (e, resolver ());
+
+  assert (!ei.find_archive ("/r/a.zip"));
+  assert (!ei.find_asset ("z.dll"));
+}
+
+int
+main ()
+{
+  test_archives ();
+  test_contents ();
+  test_files ();
+  test_lookups ();
+}
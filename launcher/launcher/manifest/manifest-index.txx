@@ -0,0 +1,74 @@
+#include <utility>
+
+namespace launcher
+{
+  template <typename R>
+  manifest_index::
+  manifest_index (const manifest& m, const R& r)
+    : m_ (&m)
+  {
+    const fs::path& root (r.root ());
+
+    std::size_t n (0);
+    for (const auto& a: m.archives)
+      n += a.files.size ();
+
+    archives_.reserve (m.archives.size ());
+    files_.reserve (m.files.size ());
+    contents_.reserve (n);
+    first_.reserve (m.archives.size () + 1);
+
+    by_path_.reserve (m.archives.size ());
+
+    auto name ([this] (const fs::path& p)
+    {
+      return intern (p.filename ().string ());
+    });
+
+    for (std::size_t i (0); i != m.archives.size (); ++i)
+    {
+      const manifest_archive& a (m.archives[i]);
+
+      first_.push_back (contents_.size ());
+
+      entry e;
+      e.path = r.path (a);
+      e.key = intern (r.key (e.path));
+      e.name = name (e.path);
+      e.asset = intern (a.name);
+
+      by_path_[intern (e.path.string ())] = i;
+      archives_.push_back (std::move (e));
+
+      for (const auto& f: a.files)
+      {
+        entry c;
+        c.path = r.path (f);
+        c.key = intern (r.key (root / f.path));
+        c.name = name (c.path);
+
+        contents_.push_back (std::move (c));
+      }
+    }
+
+    first_.push_back (contents_.size ());
+
+    for (std::size_t i (0); i != m.files.size (); ++i)
+    {
+      const manifest_file& f (m.files[i]);
+
+      entry e;
+      e.path = r.path (f);
+      e.key = intern (f.archive_name ? r.key (root / f.path) : r.key (e.path));
+      e.name = name (e.path);
+
+      if (f.asset_name)
+      {
+        e.asset = intern (*f.asset_name);
+        by_asset_[e.asset] = i;
+      }
+
+      files_.push_back (std::move (e));
+    }
+  }
+}
@@ -3,8 +3,6 @@
 #include <algorithm>
 #include <cctype>
 #include <fstream>
-#include <iomanip>
-#include <sstream>
 #include <stdexcept>
 
 #include <launcher/blake3.h>
@@ -13,7 +11,7 @@ using namespace std;
 
 namespace launcher
 {
-  string
+  blake3_digest
   compute_file_hash (const fs::path& p, hash_algorithm a)
   {
     if (a != hash_algorithm::blake3)
@@ -39,14 +37,10 @@ namespace launcher
     if (ifs.bad ())
       throw runtime_error ("error reading file for hashing: " + p.string ());
 
-    uint8_t output[BLAKE3_OUT_LEN];
-    blake3_hasher_finalize (&hasher, output, BLAKE3_OUT_LEN);
-
-    ostringstream oss;
-    for (size_t i (0); i < BLAKE3_OUT_LEN; ++i)
-      oss << hex << setw (2) << setfill ('0') << static_cast<int> (output[i]);
+    blake3_digest r;
+    blake3_hasher_finalize (&hasher, r.data (), r.size ());
 
-    return oss.str ();
+    return r;
   }
 
   bool
@@ -66,4 +60,31 @@ namespace launcher
              tolower (static_cast<unsigned char> (b));
     });
   }
+
+  string
+  compression_name (compression_type c)
+  {
+    switch (c)
+    {
+    case compression_type::none:    return "none";
+    case compression_type::zip:     return "zip";
+    case compression_type::tar_gz:  return "tar.gz";
+    case compression_type::tar_bz2: return "tar.bz2";
+    case compression_type::gzip:    return "gzip";
+    }
+
+    return "none";
+  }
+
+  optional<compression_type>
+  parse_compression_type (const string& s)
+  {
+    if (s == "none")    return compression_type::none;
+    if (s == "zip")     return compression_type::zip;
+    if (s == "tar.gz")  return compression_type::tar_gz;
+    if (s == "tar.bz2") return compression_type::tar_bz2;
+    if (s == "gzip")    return compression_type::gzip;
+
+    return nullopt;
+  }
 }
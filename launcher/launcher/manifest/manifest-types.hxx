@@ -3,8 +3,11 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <optional>
 #include <filesystem>
 
+#include <launcher/manifest/manifest-digest.hxx>
+
 namespace launcher
 {
   namespace fs = std::filesystem;
@@ -26,19 +29,32 @@ namespace launcher
 
   // File compression types.
   //
+  // Note that gzip applies to a single file: the asset is the compressed
+  // form of the entry and is decompressed to its target as it downloads.
+  //
   enum class compression_type
   {
     none,
     zip,
     tar_gz,
-    tar_bz2
+    tar_bz2,
+    gzip
   };
 
+  std::string
+  compression_name (compression_type);
+
+  // Parse the manifest representation ("none", "zip", "tar.gz", "tar.bz2",
+  // "gzip"). Return nullopt if unknown.
+  //
+  std::optional<compression_type>
+  parse_compression_type (const std::string&);
+
   // Compute hash of file.
   //
   // Reads the entire file and computes its hash.
   //
-  std::string
+  blake3_digest
   compute_file_hash (const fs::path& file,
                      hash_algorithm algorithm);
 
@@ -0,0 +1,451 @@
+#include <launcher/manifest/manifest-unzip.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <miniz.h>
+
+#include <launcher/launcher-log.hxx>
+
+using namespace std;
+
+namespace launcher
+{
+  // ZIP record signatures and flags (APPNOTE 4.3).
+  //
+  static const uint32_t local_sig      (0x04034b50);
+  static const uint32_t central_sig    (0x02014b50);
+  static const uint32_t eocd_sig       (0x06054b50);
+  static const uint32_t eocd64_sig     (0x06064b50);
+  static const uint32_t descriptor_sig (0x08074b50);
+
+  static const size_t local_size (30);
+
+  static const uint16_t flag_encrypted  (0x0001);
+  static const uint16_t flag_descriptor (0x0008);
+
+  static const uint16_t method_stored  (0);
+  static const uint16_t method_deflate (8);
+
+  static inline uint16_t
+  get16 (const string& b, size_t o)
+  {
+    return static_cast<uint16_t> (
+      static_cast<unsigned char> (b[o]) |
+      static_cast<unsigned char> (b[o + 1]) << 8);
+  }
+
+  static inline uint32_t
+  get32 (const string& b, size_t o)
+  {
+    return static_cast<uint32_t> (get16 (b, o)) |
+           static_cast<uint32_t> (get16 (b, o + 2)) << 16;
+  }
+
+  // Raw deflate state. Kept out of the header so that miniz doesn't leak
+  // into every translation unit that includes us.
+  //
+  struct zip_stream_extractor::inflater
+  {
+    mz_stream s;
+    bool active = false;
+    vector<unsigned char> out;
+
+    inflater ()
+      : out (64 * 1024)
+    {
+      memset (&s, 0, sizeof (s));
+    }
+
+    ~inflater ()
+    {
+      if (active)
+        mz_inflateEnd (&s);
+    }
+
+    void
+    reset ()
+    {
+      if (active)
+        mz_inflateEnd (&s);
+
+      memset (&s, 0, sizeof (s));
+
+      // Negative window bits means raw deflate, that is, no zlib wrapper.
+      //
+      if (mz_inflateInit2 (&s, -MZ_DEFAULT_WINDOW_BITS) != MZ_OK)
+        throw runtime_error ("failed to initialize inflate stream");
+
+      active = true;
+    }
+  };
+
+  zip_stream_extractor::
+  zip_stream_extractor (resolver_type r)
+    : resolver_ (move (r)),
+      inf_ (make_unique<inflater> ())
+  {
+  }
+
+  zip_stream_extractor::
+  ~zip_stream_extractor () = default;
+
+  bool zip_stream_extractor::
+  write (const char* d, size_t n)
+  {
+    while (n != 0)
+    {
+      size_t u (0);
+
+      switch (state_)
+      {
+      case state::header:     u = header (d, n);     break;
+      case state::data:       u = data (d, n);       break;
+      case state::descriptor: u = descriptor (d, n); break;
+
+      // Whatever follows the first central directory record is of no
+      // interest to us.
+      //
+      case state::done:       return true;
+      case state::fallback:   return false;
+      }
+
+      // A state that takes none of the input (say, inflate that is stuck
+      // without saying why) would have us spin here forever. Let the
+      // central directory path deal with such an archive instead.
+      //
+      if (u == 0)
+      {
+        abandon ("no progress in streamed extraction");
+        return false;
+      }
+
+      d += u;
+      n -= u;
+    }
+
+    return state_ != state::fallback;
+  }
+
+  bool zip_stream_extractor::
+  complete () const noexcept
+  {
+    return state_ == state::done;
+  }
+
+  bool zip_stream_extractor::
+  fallback () const noexcept
+  {
+    return state_ == state::fallback;
+  }
+
+  const string& zip_stream_extractor::
+  reason () const noexcept
+  {
+    return reason_;
+  }
+
+  const vector<fs::path>& zip_stream_extractor::
+  extracted () const noexcept
+  {
+    return extracted_;
+  }
+
+  size_t zip_stream_extractor::
+  header (const char* d, size_t n)
+  {
+    // We first read just the signature since the record that terminates the
+    // entries (central directory or, for empty archives, end of central
+    // directory) may well be shorter than a local header. Then the fixed
+    // part, and then the variable part whose sizes the fixed part records.
+    //
+    auto need ([this] () -> size_t
+    {
+      if (buf_.size () < 4)
+        return 4;
+
+      if (buf_.size () < local_size)
+        return local_size;
+
+      return local_size + get16 (buf_, 26) + get16 (buf_, 28);
+    });
+
+    size_t m (min (need () - buf_.size (), n));
+    buf_.append (d, m);
+
+    if (buf_.size () == 4)
+    {
+      uint32_t s (get32 (buf_, 0));
+
+      if (s == local_sig)
+        return m;
+
+      if (s == central_sig || s == eocd_sig || s == eocd64_sig)
+      {
+        launcher::log::trace_l3 (categories::manifest{}, "streamed archive reached central directory after {} entries", extracted_.size ());
+        buf_.clear ();
+        state_ = state::done;
+        return m;
+      }
+
+      throw runtime_error ("unexpected zip record signature");
+    }
+
+    if (buf_.size () >= local_size && buf_.size () == need ())
+      open_entry ();
+
+    return m;
+  }
+
+  void zip_stream_extractor::
+  open_entry ()
+  {
+    size_t nl (get16 (buf_, 26));
+    size_t xl (get16 (buf_, 28));
+
+    e_ = entry ();
+    e_.flags  = get16 (buf_, 6);
+    e_.method = get16 (buf_, 8);
+    e_.crc    = get32 (buf_, 14);
+    e_.csize  = get32 (buf_, 18);
+    e_.usize  = get32 (buf_, 22);
+    e_.name   = buf_.substr (local_size, nl);
+
+    // Look for a zip64 extended information record in the extra field.
+    //
+    bool z64 (false);
+    for (size_t o (local_size + nl), e (o + xl); o + 4 <= e; )
+    {
+      uint16_t id (get16 (buf_, o));
+      uint16_t sz (get16 (buf_, o + 2));
+
+      if (id == 0x0001)
+      {
+        z64 = true;
+        break;
+      }
+
+      o += 4 + sz;
+    }
+
+    buf_.clear ();
+
+    if (e_.flags & flag_encrypted)
+      return abandon ("entry " + e_.name + " is encrypted");
+
+    if (e_.method != method_stored && e_.method != method_deflate)
+      return abandon ("entry " + e_.name + " uses compression method " +
+                      to_string (e_.method));
+
+    if (z64 || e_.csize == 0xffffffff || e_.usize == 0xffffffff)
+      return abandon ("entry " + e_.name + " is zip64");
+
+    // With a data descriptor the sizes are only known after the data. For
+    // deflate that's fine since the stream delimits itself, but stored data
+    // has no end marker at all.
+    //
+    if ((e_.flags & flag_descriptor) && e_.method == method_stored)
+      return abandon ("stored entry " + e_.name +
+                      " defers its size to a data descriptor");
+
+    // Directories carry no data and get created along with their files.
+    //
+    if (!e_.name.empty () && e_.name.back () != '/')
+      e_.path = resolver_ (e_.name);
+
+    if (!e_.path.empty ())
+    {
+      if (e_.path.has_parent_path ())
+      {
+        error_code ec;
+        fs::create_directories (e_.path.parent_path (), ec);
+
+        if (ec)
+          throw runtime_error ("failed to create directory: " +
+                               e_.path.parent_path ().string ());
+      }
+
+      e_.os.open (e_.path, ios::binary | ios::out | ios::trunc);
+      if (!e_.os)
+        throw runtime_error ("failed to open file for writing: " +
+                             e_.path.string ());
+    }
+
+    if (e_.method == method_deflate)
+      inf_->reset ();
+
+    state_ = state::data;
+
+    if (!(e_.flags & flag_descriptor) && e_.csize == 0)
+      close_entry ();
+  }
+
+  size_t zip_stream_extractor::
+  data (const char* d, size_t n)
+  {
+    bool dd (e_.flags & flag_descriptor);
+
+    // Without a descriptor we know exactly where the entry ends and must not
+    // read past it. With one we let inflate tell us.
+    //
+    size_t m (dd ? n : static_cast<size_t> (min<uint64_t> (n, e_.csize - e_.cread)));
+
+    if (e_.method == method_stored)
+    {
+      emit (reinterpret_cast<const unsigned char*> (d), m);
+      e_.cread += m;
+
+      if (e_.cread == e_.csize)
+        close_entry ();
+
+      return m;
+    }
+
+    auto& s (inf_->s);
+    auto& o (inf_->out);
+
+    s.next_in = reinterpret_cast<const unsigned char*> (d);
+    s.avail_in = static_cast<unsigned int> (m);
+
+    int r;
+    for (;;)
+    {
+      s.next_out = o.data ();
+      s.avail_out = static_cast<unsigned int> (o.size ());
+
+      r = mz_inflate (&s, MZ_NO_FLUSH);
+
+      if (r != MZ_OK && r != MZ_STREAM_END && r != MZ_BUF_ERROR)
+        throw runtime_error ("corrupt deflate data in " + e_.name);
+
+      size_t p (o.size () - s.avail_out);
+      emit (o.data (), p);
+
+      // Keep going while there is input left or inflate filled the whole
+      // output buffer (and so may have more pending).
+      //
+      if (r == MZ_STREAM_END || (s.avail_in == 0 && s.avail_out != 0))
+        break;
+
+      if (r == MZ_BUF_ERROR && p == 0)
+        break;
+    }
+
+    size_t u (m - s.avail_in);
+    e_.cread += u;
+
+    if (r == MZ_STREAM_END)
+    {
+      if (dd)
+        state_ = state::descriptor;
+      else if (e_.cread != e_.csize)
+        throw runtime_error ("deflate stream of " + e_.name +
+                             " ended before its recorded size");
+      else
+        close_entry ();
+    }
+    else if (!dd && e_.cread == e_.csize)
+      throw runtime_error ("truncated deflate stream in " + e_.name);
+
+    return u;
+  }
+
+  size_t zip_stream_extractor::
+  descriptor (const char* d, size_t n)
+  {
+    // The descriptor signature is optional so the record is either 12 or 16
+    // bytes long.
+    //
+    auto need ([this] () -> size_t
+    {
+      if (buf_.size () < 4)
+        return 4;
+
+      return get32 (buf_, 0) == descriptor_sig ? 16 : 12;
+    });
+
+    size_t m (min (need () - buf_.size (), n));
+    buf_.append (d, m);
+
+    if (buf_.size () < 4)
+      return m;
+
+    // If the CRC itself happens to equal the signature, we cannot tell
+    // which layout we are looking at.
+    //
+    if (buf_.size () == 4 &&
+        get32 (buf_, 0) == descriptor_sig &&
+        e_.ucrc == descriptor_sig)
+    {
+      abandon ("ambiguous data descriptor after " + e_.name);
+      return m;
+    }
+
+    if (buf_.size () < need ())
+      return m;
+
+    size_t o (buf_.size () == 16 ? 4 : 0);
+    e_.crc   = get32 (buf_, o);
+    e_.csize = get32 (buf_, o + 4);
+    e_.usize = get32 (buf_, o + 8);
+    buf_.clear ();
+
+    if (e_.csize != e_.cread)
+      throw runtime_error ("data descriptor size mismatch for " + e_.name);
+
+    close_entry ();
+    return m;
+  }
+
+  void zip_stream_extractor::
+  close_entry ()
+  {
+    if (e_.os.is_open ())
+    {
+      e_.os.close ();
+
+      if (!e_.os)
+        throw runtime_error ("failed to write file: " + e_.path.string ());
+    }
+
+    if (e_.uwritten != e_.usize)
+      throw runtime_error ("size mismatch for " + e_.name);
+
+    if (e_.ucrc != e_.crc)
+      throw runtime_error ("crc mismatch for " + e_.name);
+
+    if (!e_.path.empty ())
+      extracted_.push_back (e_.path);
+
+    state_ = state::header;
+  }
+
+  void zip_stream_extractor::
+  emit (const unsigned char* p, size_t n)
+  {
+    if (n == 0)
+      return;
+
+    e_.ucrc = static_cast<uint32_t> (mz_crc32 (e_.ucrc, p, n));
+    e_.uwritten += n;
+
+    if (e_.os.is_open ())
+    {
+      e_.os.write (reinterpret_cast<const char*> (p),
+                   static_cast<streamsize> (n));
+
+      if (!e_.os)
+        throw runtime_error ("failed to write file: " + e_.path.string ());
+    }
+  }
+
+  void zip_stream_extractor::
+  abandon (string r)
+  {
+    launcher::log::debug (categories::manifest{}, "abandoning streamed extraction: {}", r);
+
+    reason_ = move (r);
+    state_ = state::fallback;
+  }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <filesystem>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Streaming ZIP extractor.
+  //
+  // Consumes an archive front to back, as it comes off the wire, by walking
+  // the local file headers and inflating each entry straight to its final
+  // location. This way we never spool the whole archive to disk only to read
+  // it back and delete it.
+  //
+  // Note that the local headers are not authoritative, the central directory
+  // at the end is. If an entry defers its sizes to a trailing data descriptor
+  // in a way we cannot delimit (stored data, zip64, a descriptor we can't
+  // tell apart from its CRC), or uses a feature we don't handle, we give up
+  // and ask the caller to fall back to the central directory path.
+  //
+  class zip_stream_extractor
+  {
+  public:
+    // Map an entry name to its output path. Empty path skips the entry.
+    //
+    using resolver_type = std::function<fs::path (const std::string&)>;
+
+    explicit
+    zip_stream_extractor (resolver_type resolver);
+
+    ~zip_stream_extractor ();
+
+    zip_stream_extractor (const zip_stream_extractor&) = delete;
+    zip_stream_extractor& operator= (const zip_stream_extractor&) = delete;
+
+    // Consume the next chunk of the archive.
+    //
+    // Returns false once streaming was abandoned (see fallback()), after
+    // which the remaining bytes are of no interest. Throws on corrupt data.
+    //
+    bool
+    write (const char* data, std::size_t size);
+
+    // Return true if we reached the central directory, that is, every entry
+    // was extracted.
+    //
+    bool
+    complete () const noexcept;
+
+    // Return true if the archive cannot be streamed and must be extracted
+    // from a complete copy instead.
+    //
+    bool
+    fallback () const noexcept;
+
+    // Reason for the fallback.
+    //
+    const std::string&
+    reason () const noexcept;
+
+    // Files written so far.
+    //
+    const std::vector<fs::path>&
+    extracted () const noexcept;
+
+  private:
+    enum class state
+    {
+      header,     // Accumulating a local file header.
+      data,       // Inside entry data.
+      descriptor, // Accumulating a trailing data descriptor.
+      done,       // Reached the central directory.
+      fallback    // Gave up.
+    };
+
+    std::size_t
+    header (const char*, std::size_t);
+
+    std::size_t
+    data (const char*, std::size_t);
+
+    std::size_t
+    descriptor (const char*, std::size_t);
+
+    void
+    open_entry ();
+
+    void
+    close_entry ();
+
+    void
+    emit (const unsigned char*, std::size_t);
+
+    void
+    abandon (std::string);
+
+  private:
+    struct inflater;
+
+    struct entry
+    {
+      std::string   name;
+      std::uint16_t flags    = 0;
+      std::uint16_t method   = 0;
+      std::uint32_t crc      = 0; // Expected.
+      std::uint64_t csize    = 0;
+      std::uint64_t usize    = 0;
+      std::uint64_t cread    = 0; // Compressed bytes consumed.
+      std::uint64_t uwritten = 0; // Uncompressed bytes produced.
+      std::uint32_t ucrc     = 0; // Running CRC of the output.
+      fs::path      path;
+      std::ofstream os;
+    };
+
+    resolver_type resolver_;
+    state state_ = state::header;
+    std::string buf_; // Partial header or descriptor.
+    std::string reason_;
+    std::vector<fs::path> extracted_;
+    entry e_;
+    std::unique_ptr<inflater> inf_;
+  };
+}
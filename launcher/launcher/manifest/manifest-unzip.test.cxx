@@ -0,0 +1,339 @@
+#include <launcher/manifest/manifest-unzip.hxx>
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <filesystem>
+
+#include <miniz.h>
+
+using namespace std;
+using namespace launcher;
+
+namespace fs = std::filesystem;
+
+// Archive construction.
+//
+// We assemble the archives by hand since we want entries that real zip
+// tools only produce in odd situations (data descriptors, zip64 records).
+// Only the local headers matter to the extractor, so the central directory
+// is just its signature.
+//
+static void
+put16 (string& b, uint16_t v)
+{
+  b += static_cast<char> (v & 0xff);
+  b += static_cast<char> (v >> 8);
+}
+
+static void
+put32 (string& b, uint32_t v)
+{
+  put16 (b, static_cast<uint16_t> (v & 0xffff));
+  put16 (b, static_cast<uint16_t> (v >> 16));
+}
+
+static uint32_t
+crc (const string& s)
+{
+  return static_cast<uint32_t> (
+    mz_crc32 (0, reinterpret_cast<const unsigned char*> (s.data ()), s.size ()));
+}
+
+// Raw deflate, that is, a zlib stream without its 2-byte header and
+// 4-byte Adler-32 trailer.
+//
+static string
+deflate (const string& s)
+{
+  mz_ulong n (mz_compressBound (static_cast<mz_ulong> (s.size ())));
+  string r (n, '\0');
+
+  int e (mz_compress (reinterpret_cast<unsigned char*> (&r[0]),
+                      &n,
+                      reinterpret_cast<const unsigned char*> (s.data ()),
+                      static_cast<mz_ulong> (s.size ())));
+  assert (e == MZ_OK);
+
+  return r.substr (2, n - 6);
+}
+
+struct entry
+{
+  string name;
+  string data;
+  bool deflated = true;
+  bool descriptor = false;      // Sizes in a trailing data descriptor.
+  bool descriptor_sig = true;   // Descriptor has its optional signature.
+  bool zip64 = false;           // Add a zip64 extra field.
+  uint32_t crc_adjust = 0;      // Corrupt the recorded CRC.
+};
+
+static string
+archive (const vector<entry>& es)
+{
+  string r;
+
+  for (const entry& e: es)
+  {
+    string c (e.deflated ? deflate (e.data) : e.data);
+    uint32_t k (crc (e.data) + e.crc_adjust);
+
+    string x;
+    if (e.zip64)
+    {
+      put16 (x, 0x0001);
+      put16 (x, 16);
+      x.append (16, '\0');
+    }
+
+    put32 (r, 0x04034b50);
+    put16 (r, 20);
+    put16 (r, e.descriptor ? 0x0008 : 0);
+    put16 (r, e.deflated ? 8 : 0);
+    put16 (r, 0);
+    put16 (r, 0);
+    put32 (r, e.descriptor ? 0 : k);
+    put32 (r, e.descriptor ? 0 : static_cast<uint32_t> (c.size ()));
+    put32 (r, e.descriptor ? 0 : static_cast<uint32_t> (e.data.size ()));
+    put16 (r, static_cast<uint16_t> (e.name.size ()));
+    put16 (r, static_cast<uint16_t> (x.size ()));
+    r += e.name;
+    r += x;
+    r += c;
+
+    if (e.descriptor)
+    {
+      if (e.descriptor_sig)
+        put32 (r, 0x08074b50);
+
+      put32 (r, k);
+      put32 (r, static_cast<uint32_t> (c.size ()));
+      put32 (r, static_cast<uint32_t> (e.data.size ()));
+    }
+  }
+
+  put32 (r, 0x02014b50);
+  r.append (42, '\0');
+
+  return r;
+}
+
+static string
+content (const fs::path& p)
+{
+  ifstream is (p, ios::binary);
+  return string (istreambuf_iterator<char> (is), {});
+}
+
+static fs::path
+scratch (const char* n)
+{
+  fs::path d (fs::temp_directory_path () / n);
+  fs::remove_all (d);
+  fs::create_directories (d);
+  return d;
+}
+
+// Feed the archive to the extractor in pieces of (at most) n bytes.
+//
+static bool
+feed (zip_stream_extractor& x, const string& a, size_t n)
+{
+  for (size_t o (0); o < a.size (); o += n)
+    if (!x.write (a.data () + o, min (n, a.size () - o)))
+      return false;
+
+  return true;
+}
+
+// Split writes. Whatever the network hands us, headers, entry data, and
+// descriptors may be cut anywhere, so extract the same archive with a
+// range of chunk sizes, down to a byte at a time.
+//
+static void
+test_split ()
+{
+  string big;
+  for (size_t i (0); i != 100000; ++i)
+    big += static_cast<char> ('a' + i * 7 % 23);
+
+  string a (archive ({{"dir/big.bin", big},
+                      {"stored.txt", "stored data", false},
+                      {"empty.txt", "", false},
+                      {"dir/", "", false},
+                      {"small.txt", "hello, world"}}));
+
+  fs::path d (scratch ("iw4x-unzip-test-split"));
+
+  for (size_t n: {size_t (1), size_t (3), size_t (29), size_t (4096), a.size ()})
+  {
+    fs::remove_all (d);
+
+    zip_stream_extractor x ([&d] (const string& e) { return d / e; });
+
+    assert (feed (x, a, n));
+    assert (x.complete ());
+    assert (!x.fallback ());
+    assert (x.extracted ().size () == 4);
+
+    assert (content (d / "dir" / "big.bin") == big);
+    assert (content (d / "stored.txt") == "stored data");
+    assert (content (d / "small.txt") == "hello, world");
+    assert (fs::exists (d / "empty.txt") && fs::file_size (d / "empty.txt") == 0);
+  }
+
+  fs::remove_all (d);
+}
+
+// Entries the resolver maps to an empty path are read past but not
+// written.
+//
+static void
+test_skip ()
+{
+  string a (archive ({{"keep.txt", "keep"}, {"skip.txt", "skip"}}));
+
+  fs::path d (scratch ("iw4x-unzip-test-skip"));
+
+  zip_stream_extractor x ([&d] (const string& e)
+  {
+    return e == "keep.txt" ? d / e : fs::path ();
+  });
+
+  assert (feed (x, a, 5));
+  assert (x.complete ());
+  assert (x.extracted ().size () == 1);
+  assert (content (d / "keep.txt") == "keep");
+  assert (!fs::exists (d / "skip.txt"));
+
+  fs::remove_all (d);
+}
+
+// Data descriptors. A deflated entry delimits itself so we can stream it
+// with or without the optional descriptor signature. A stored one does not
+// and we have to fall back.
+//
+static void
+test_descriptor ()
+{
+  fs::path d (scratch ("iw4x-unzip-test-descriptor"));
+
+  for (bool sig: {true, false})
+  {
+    entry e {"a.txt", string (5000, 'x')};
+    e.descriptor = true;
+    e.descriptor_sig = sig;
+
+    string a (archive ({e, {"b.txt", "after"}}));
+
+    zip_stream_extractor x ([&d] (const string& n) { return d / n; });
+
+    assert (feed (x, a, 7));
+    assert (x.complete ());
+    assert (content (d / "a.txt") == e.data);
+    assert (content (d / "b.txt") == "after");
+  }
+
+  {
+    entry e {"stored.txt", "stored", false};
+    e.descriptor = true;
+
+    zip_stream_extractor x ([&d] (const string& n) { return d / n; });
+
+    assert (!feed (x, archive ({e}), 7));
+    assert (x.fallback ());
+    assert (!x.complete ());
+    assert (!x.reason ().empty ());
+  }
+
+  fs::remove_all (d);
+}
+
+// Zip64. The local header sizes are placeholders so we fall back to the
+// central directory.
+//
+static void
+test_zip64 ()
+{
+  fs::path d (scratch ("iw4x-unzip-test-zip64"));
+
+  entry e {"big.bin", "not really big"};
+  e.zip64 = true;
+
+  zip_stream_extractor x ([&d] (const string& n) { return d / n; });
+
+  assert (!feed (x, archive ({{"first.txt", "first"}, e}), 11));
+  assert (x.fallback ());
+  assert (x.extracted ().size () == 1);
+
+  // Once abandoned, we are not interested in the rest.
+  //
+  assert (!x.write ("x", 1));
+
+  fs::remove_all (d);
+}
+
+// Corruption. A CRC mismatch (deflated or stored) is an error, not a
+// fallback.
+//
+static void
+test_crc_mismatch ()
+{
+  fs::path d (scratch ("iw4x-unzip-test-crc"));
+
+  for (bool deflated: {true, false})
+  {
+    entry e {"bad.txt", "some data", deflated};
+    e.crc_adjust = 1;
+
+    zip_stream_extractor x ([&d] (const string& n) { return d / n; });
+
+    bool thrown (false);
+    try
+    {
+      feed (x, archive ({e}), 4);
+    }
+    catch (const runtime_error&)
+    {
+      thrown = true;
+    }
+
+    assert (thrown);
+    assert (x.extracted ().empty ());
+  }
+
+  // Garbage where a record should start.
+  //
+  {
+    zip_stream_extractor x ([&d] (const string& n) { return d / n; });
+
+    bool thrown (false);
+    try
+    {
+      x.write ("PK\x09\x09", 4);
+    }
+    catch (const runtime_error&)
+    {
+      thrown = true;
+    }
+
+    assert (thrown);
+  }
+
+  fs::remove_all (d);
+}
+
+int
+main ()
+{
+  test_split ();
+  test_skip ();
+  test_descriptor ();
+  test_zip64 ();
+  test_crc_mismatch ();
+}
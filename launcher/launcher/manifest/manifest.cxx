@@ -5,6 +5,7 @@ namespace launcher
   // Explicit template instantiations for common types.
   //
   template class basic_hash<std::string>;
+  template class basic_manifest_chunk<std::string>;
   template class basic_manifest_file<std::string>;
   template class basic_manifest_archive<std::string>;
   template class basic_manifest<manifest_format>;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <launcher/manifest/manifest-types.hxx>
+#include <launcher/manifest/manifest-digest.hxx>
 
 #include <string>
 #include <vector>
@@ -23,21 +24,29 @@ namespace launcher
 
   // Hash value with algorithm type.
   //
+  // The value is kept as the raw digest; constructing from a string parses
+  // its hex representation and throws std::invalid_argument if it is not
+  // one (the empty string means no hash).
+  //
   template <typename S = std::string>
   struct basic_hash
   {
     using string_type = S;
+    using value_type = blake3_digest;
 
     hash_algorithm algorithm;
-    string_type value;
+    value_type value;
 
     basic_hash () : algorithm (hash_algorithm::blake3) {}
 
-    basic_hash (hash_algorithm a, string_type v)
-      : algorithm (a), value (std::move (v)) {}
+    basic_hash (hash_algorithm a, const string_type& v)
+      : algorithm (a), value (parse (v)) {}
+
+    explicit basic_hash (const string_type& v)
+      : algorithm (hash_algorithm::blake3), value (parse (v)) {}
 
-    explicit basic_hash (string_type v)
-      : algorithm (hash_algorithm::blake3), value (std::move (v)) {}
+    explicit basic_hash (const value_type& v)
+      : algorithm (hash_algorithm::blake3), value (v) {}
 
     bool
     empty () const noexcept
@@ -45,7 +54,7 @@ namespace launcher
       return value.empty ();
     }
 
-    // String representation.
+    // String (hex) representation.
     //
     string_type
     string () const;
@@ -55,6 +64,29 @@ namespace launcher
     template <typename Buffer>
     bool
     verify (const Buffer&) const;
+
+  private:
+    static value_type
+    parse (const string_type&);
+  };
+
+  // Content-defined chunk of a file (see manifest-chunk.hxx).
+  //
+  template <typename S = std::string, typename H = basic_hash<S>>
+  struct basic_manifest_chunk
+  {
+    using string_type = S;
+    using hash_type = H;
+    using size_type = std::uint64_t;
+
+    hash_type hash;
+    size_type offset;
+    size_type size;
+
+    basic_manifest_chunk () : offset (0), size (0) {}
+
+    basic_manifest_chunk (hash_type h, size_type o, size_type s)
+      : hash (std::move (h)), offset (o), size (s) {}
   };
 
   // File entry in a manifest.
@@ -65,6 +97,7 @@ namespace launcher
     using string_type = S;
     using hash_type = H;
     using size_type = std::uint64_t;
+    using chunk_type = basic_manifest_chunk<S, H>;
 
     hash_type hash;
     size_type size;
@@ -72,7 +105,18 @@ namespace launcher
     std::optional<string_type> asset_name;
     std::optional<string_type> archive_name;
 
-    basic_manifest_file () : size (0) {}
+    // How the asset is compressed in transit (stand-alone files only). The
+    // hash and size always describe the decompressed file.
+    //
+    compression_type compression;
+
+    // Optional chunk list, in file order. If present, a stale local copy can
+    // be patched by fetching only the chunks it lacks.
+    //
+    std::vector<chunk_type> chunks;
+
+    basic_manifest_file ()
+      : size (0), compression (compression_type::none) {}
 
     basic_manifest_file (hash_type h,
                          size_type s,
@@ -83,7 +127,8 @@ namespace launcher
         size (s),
         path (std::move (p)),
         asset_name (std::move (a)),
-        archive_name (std::move (ar)) {}
+        archive_name (std::move (ar)),
+        compression (compression_type::none) {}
 
     bool
     empty () const noexcept
@@ -101,6 +146,7 @@ namespace launcher
     using hash_type = H;
     using size_type = std::uint64_t;
     using file_type = basic_manifest_file<S, H>;
+    using chunk_type = basic_manifest_chunk<S, H>;
 
     hash_type hash;
     size_type size;
@@ -109,6 +155,10 @@ namespace launcher
     compression_type compression;
     std::vector<file_type> files;
 
+    // Optional chunk list for blob archives (see basic_manifest_file).
+    //
+    std::vector<chunk_type> chunks;
+
     basic_manifest_archive ()
       : size (0), compression (compression_type::none) {}
 
@@ -261,6 +311,15 @@ namespace launcher
     void
     parse_update (const json::object&);
 
+    static std::vector<typename file_type::chunk_type>
+    parse_chunks (const json::object&);
+
+    static json::array
+    serialize_chunks (const std::vector<typename file_type::chunk_type>&);
+
+    static compression_type
+    parse_compression (const json::object&);
+
     void
     parse_dlc (const json::object&);
 
@@ -274,6 +333,7 @@ namespace launcher
   // Type aliases for common instantiations.
   //
   using hash = basic_hash<std::string>;
+  using manifest_chunk = basic_manifest_chunk<std::string>;
   using manifest_file = basic_manifest_file<std::string>;
   using manifest_archive = basic_manifest_archive<std::string>;
   using manifest = basic_manifest<manifest_format>;
@@ -294,6 +354,24 @@ namespace launcher
     return !(x == y);
   }
 
+  template <typename S, typename H>
+  inline bool
+  operator== (const basic_manifest_chunk<S, H>& x,
+              const basic_manifest_chunk<S, H>& y) noexcept
+  {
+    return x.hash == y.hash &&
+           x.offset == y.offset &&
+           x.size == y.size;
+  }
+
+  template <typename S, typename H>
+  inline bool
+  operator!= (const basic_manifest_chunk<S, H>& x,
+              const basic_manifest_chunk<S, H>& y) noexcept
+  {
+    return !(x == y);
+  }
+
   template <typename S, typename H>
   inline bool
   operator== (const basic_manifest_file<S, H>& x,
@@ -303,7 +381,9 @@ namespace launcher
            x.size == y.size &&
            x.path == y.path &&
            x.asset_name == y.asset_name &&
-           x.archive_name == y.archive_name;
+           x.archive_name == y.archive_name &&
+           x.compression == y.compression &&
+           x.chunks == y.chunks;
   }
 
   template <typename S, typename H>
@@ -323,7 +403,8 @@ namespace launcher
            x.size == y.size &&
            x.name == y.name &&
            x.url == y.url &&
-           x.compression == y.compression;
+           x.compression == y.compression &&
+           x.chunks == y.chunks;
   }
 
   template <typename S, typename H>
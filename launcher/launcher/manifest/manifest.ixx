@@ -4,9 +4,20 @@ namespace launcher
   inline typename basic_hash<S>::string_type basic_hash<S>::
   string () const
   {
-    // @@: Currently stubbed.
-    //
-    return value;
+    return string_type (value.hex ());
+  }
+
+  template <typename S>
+  inline typename basic_hash<S>::value_type basic_hash<S>::
+  parse (const string_type& s)
+  {
+    if (s.empty ())
+      return value_type ();
+
+    if (auto d = value_type::from_hex (s))
+      return *d;
+
+    throw std::invalid_argument ("invalid BLAKE3 hash '" + std::string (s) + "'");
   }
 
   template <typename F, typename T>
@@ -3,6 +3,8 @@
 #include <boost/json/parse.hpp>
 #include <boost/json/serialize.hpp>
 
+#include <launcher/manifest/manifest-decoder.hxx>
+
 #include <stdexcept>
 #include <algorithm>
 
@@ -25,27 +27,10 @@ namespace launcher
   {
     try
     {
-      // Parse the JSON string.
-      //
-      // We explicitly check that the root element is an object before proceeding,
-      // as a manifest must define properties like 'files' or 'archives'.
+      // Decode straight from the text rather than going through a
+      // json::value (see manifest-decoder.hxx for details).
       //
-      json::value jv (json::parse (json_str));
-
-      if (!jv.is_object ())
-        throw std::invalid_argument ("manifest JSON must be an object");
-
-      const json::object& obj (jv.as_object ());
-
-      switch (kind)
-      {
-        case manifest_format::update:
-          parse_update (obj);
-          break;
-        case manifest_format::dlc:
-          parse_dlc (obj);
-          break;
-      }
+      manifest_decoder<basic_manifest>::decode (json_str, *this);
     }
     catch (const std::exception& e)
     {
@@ -145,6 +130,9 @@ namespace launcher
         if (ao.contains ("url") && ao.at ("url").is_string ())
           archive.url = json::value_to<string_type> (ao.at ("url"));
 
+        archive.compression = parse_compression (ao);
+        archive.chunks = parse_chunks (ao);
+
         if (!archive.empty ())
           archives.push_back (std::move (archive));
       }
@@ -187,12 +175,111 @@ namespace launcher
         if (fo.contains ("archive") && fo.at ("archive").is_string ())
           file.archive_name = json::value_to<string_type> (fo.at ("archive"));
 
+        file.compression = parse_compression (fo);
+        file.chunks = parse_chunks (fo);
+
         if (!file.empty ())
           files.push_back (std::move (file));
       }
     }
   }
 
+  template <typename F, typename T>
+  std::vector<typename basic_manifest<F, T>::file_type::chunk_type>
+  basic_manifest<F, T>::
+  parse_chunks (const json::object& o)
+  {
+    using chunk_type = typename file_type::chunk_type;
+
+    std::vector<chunk_type> r;
+
+    // The chunk list is optional and all-or-nothing: a list with a hole in
+    // it is useless for patching, so we drop the whole thing if any entry is
+    // malformed or the chunks don't tile the file.
+    //
+    if (!o.contains ("chunks") || !o.at ("chunks").is_array ())
+      return r;
+
+    const auto& ja (o.at ("chunks").as_array ());
+    r.reserve (ja.size ());
+
+    auto size ([] (const json::value& v) -> std::optional<std::uint64_t>
+    {
+      if (v.is_uint64 ())
+        return v.as_uint64 ();
+
+      if (v.is_int64 () && v.as_int64 () >= 0)
+        return static_cast<std::uint64_t> (v.as_int64 ());
+
+      return std::nullopt;
+    });
+
+    std::uint64_t next (0);
+
+    for (const auto& jc : ja)
+    {
+      if (!jc.is_object ())
+        return {};
+
+      const auto& co (jc.as_object ());
+
+      if (!co.contains ("blake3") || !co.at ("blake3").is_string () ||
+          !co.contains ("offset") || !co.contains ("size"))
+        return {};
+
+      auto off (size (co.at ("offset")));
+      auto sz (size (co.at ("size")));
+
+      if (!off || !sz || *off != next || *sz == 0)
+        return {};
+
+      next += *sz;
+
+      r.emplace_back (hash_type (json::value_to<string_type> (co.at ("blake3"))),
+                      *off,
+                      *sz);
+    }
+
+    return r;
+  }
+
+  template <typename F, typename T>
+  json::array basic_manifest<F, T>::
+  serialize_chunks (const std::vector<typename file_type::chunk_type>& cs)
+  {
+    json::array r;
+    r.reserve (cs.size ());
+
+    for (const auto& c : cs)
+    {
+      json::object co;
+      co["blake3"] = c.hash.string ();
+      co["offset"] = c.offset;
+      co["size"] = c.size;
+      r.push_back (std::move (co));
+    }
+
+    return r;
+  }
+
+  template <typename F, typename T>
+  compression_type basic_manifest<F, T>::
+  parse_compression (const json::object& o)
+  {
+    if (!o.contains ("compression") || !o.at ("compression").is_string ())
+      return compression_type::none;
+
+    std::string v (json::value_to<std::string> (o.at ("compression")));
+
+    // Unlike a missing chunk list, we can't just ignore this: the bytes we
+    // would download are not the bytes the hash describes.
+    //
+    if (auto c = parse_compression_type (v))
+      return *c;
+
+    throw std::invalid_argument ("unsupported compression '" + v + "'");
+  }
+
   template <typename F, typename T>
   void basic_manifest<F, T>::
   parse_dlc (const json::object& obj)
@@ -231,6 +318,8 @@ namespace launcher
         if (fo.contains ("asset_name") && fo.at ("asset_name").is_string ())
           file.asset_name = json::value_to<string_type> (fo.at ("asset_name"));
 
+        file.compression = parse_compression (fo);
+
         if (!file.empty ())
           files.push_back (std::move (file));
       }
@@ -254,7 +343,7 @@ namespace launcher
         json::object ao;
 
         if (!archive.hash.empty ())
-          ao["blake3"] = archive.hash.value;
+          ao["blake3"] = archive.hash.string ();
 
         ao["size"] = archive.size;
 
@@ -264,6 +353,12 @@ namespace launcher
         if (!archive.url.empty ())
           ao["url"] = archive.url;
 
+        if (archive.compression != compression_type::none)
+          ao["compression"] = compression_name (archive.compression);
+
+        if (!archive.chunks.empty ())
+          ao["chunks"] = serialize_chunks (archive.chunks);
+
         archives_arr.push_back (std::move (ao));
       }
 
@@ -281,7 +376,7 @@ namespace launcher
         json::object fo;
 
         if (!file.hash.empty ())
-          fo["blake3"] = file.hash.value;
+          fo["blake3"] = file.hash.string ();
 
         fo["size"] = file.size;
 
@@ -294,6 +389,12 @@ namespace launcher
         if (file.archive_name)
           fo["archive"] = *file.archive_name;
 
+        if (file.compression != compression_type::none)
+          fo["compression"] = compression_name (file.compression);
+
+        if (!file.chunks.empty ())
+          fo["chunks"] = serialize_chunks (file.chunks);
+
         files_arr.push_back (std::move (fo));
       }
 
@@ -320,7 +421,7 @@ namespace launcher
         json::object fo;
 
         if (!file.hash.empty ())
-          fo["blake3"] = file.hash.value;
+          fo["blake3"] = file.hash.string ();
 
         fo["size"] = file.size;
 
@@ -330,6 +431,9 @@ namespace launcher
         if (file.asset_name)
           fo["asset_name"] = *file.asset_name;
 
+        if (file.compression != compression_type::none)
+          fo["compression"] = compression_name (file.compression);
+
         files_arr.push_back (std::move (fo));
       }
 
@@ -169,9 +169,7 @@ namespace odb
 
     // hash_
     //
-    b[n].type = sqlite::image_traits<
-      ::std::string,
-      sqlite::id_text>::bind_value;
+    b[n].type = sqlite::bind::blob;
     b[n].buffer = i.hash_value.data ();
     b[n].size = &i.hash_size;
     b[n].capacity = i.hash_value.capacity ();
@@ -295,14 +293,14 @@ namespace odb
     // hash_
     //
     {
-      ::std::string const& v =
+      ::launcher::blake3_digest::bytes_type const& v =
         o.hash_;
 
       bool is_null (false);
       std::size_t cap (i.hash_value.capacity ());
       sqlite::value_traits<
-          ::std::string,
-          sqlite::id_text >::set_image (
+          ::launcher::blake3_digest::bytes_type,
+          sqlite::id_blob >::set_image (
         i.hash_value,
         i.hash_size,
         is_null,
@@ -398,12 +396,12 @@ namespace odb
     // hash_
     //
     {
-      ::std::string& v =
+      ::launcher::blake3_digest::bytes_type& v =
         o.hash_;
 
       sqlite::value_traits<
-          ::std::string,
-          sqlite::id_text >::set_value (
+          ::launcher::blake3_digest::bytes_type,
+          sqlite::id_blob >::set_value (
         v,
         i.hash_value,
         i.hash_size,
@@ -2143,56 +2141,957 @@ namespace odb
 
     return st.execute ();
   }
-}
 
-namespace odb
-{
-  static bool
-  create_schema (database& db, unsigned short pass, bool drop)
+  // journaled_download
+  //
+
+  struct access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::extra_statement_cache_type
   {
+    extra_statement_cache_type (
+      sqlite::connection&,
+      image_type&,
+      id_image_type&,
+      sqlite::binding&,
+      sqlite::binding&)
+    {
+    }
+  };
+
+  access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::id_type
+  access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  id (const image_type& i)
+  {
+    sqlite::database* db (0);
     ODB_POTENTIALLY_UNUSED (db);
-    ODB_POTENTIALLY_UNUSED (pass);
-    ODB_POTENTIALLY_UNUSED (drop);
 
-    if (drop)
+    id_type id;
     {
-      switch (pass)
-      {
-        case 1:
-        {
-          return true;
-        }
-        case 2:
-        {
-          db.execute ("DROP TABLE IF EXISTS \"user_settings\"");
-          db.execute ("DROP TABLE IF EXISTS \"component_versions\"");
-          db.execute ("DROP TABLE IF EXISTS \"cached_files\"");
-          return false;
-        }
-      }
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_value (
+        id,
+        i.target_value,
+        i.target_size,
+        i.target_null);
     }
-    else
+
+    return id;
+  }
+
+  bool access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  grow (image_type& i,
+        bool* t)
+  {
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (t);
+
+    bool grew (false);
+
+    // target_
+    //
+    if (t[0UL])
     {
-      switch (pass)
-      {
-        case 1:
-        {
-          db.execute ("CREATE TABLE \"cached_files\" (\n"
-                      "  \"path\" TEXT NOT NULL PRIMARY KEY,\n"
-                      "  \"mtime\" INTEGER NOT NULL,\n"
-                      "  \"version\" TEXT NOT NULL,\n"
-                      "  \"component\" INTEGER NOT NULL,\n"
-                      "  \"size\" INTEGER NOT NULL,\n"
-                      "  \"hash\" TEXT NOT NULL)");
-          db.execute ("CREATE INDEX \"cached_files_version_i\"\n"
-                      "  ON \"cached_files\" (\"version\")");
-          db.execute ("CREATE TABLE \"component_versions\" (\n"
-                      "  \"component\" INTEGER NOT NULL PRIMARY KEY,\n"
-                      "  \"tag\" TEXT NOT NULL,\n"
-                      "  \"installed_at\" INTEGER NOT NULL)");
-          db.execute ("CREATE TABLE \"user_settings\" (\n"
-                      "  \"key\" TEXT NOT NULL PRIMARY KEY,\n"
-                      "  \"val\" TEXT NOT NULL)");
+      i.target_value.capacity (i.target_size);
+      grew = true;
+    }
+
+    // url_
+    //
+    if (t[1UL])
+    {
+      i.url_value.capacity (i.url_size);
+      grew = true;
+    }
+
+    // size_
+    //
+    t[2UL] = false;
+
+    // hash_
+    //
+    if (t[3UL])
+    {
+      i.hash_value.capacity (i.hash_size);
+      grew = true;
+    }
+
+    // confirmed_
+    //
+    t[4UL] = false;
+
+    // state_
+    //
+    if (t[5UL])
+    {
+      i.state_value.capacity (i.state_size);
+      grew = true;
+    }
+
+    // etag_
+    //
+    if (t[6UL])
+    {
+      i.etag_value.capacity (i.etag_size);
+      grew = true;
+    }
+
+    return grew;
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  bind (sqlite::bind* b,
+        image_type& i,
+        sqlite::statement_kind sk)
+  {
+    ODB_POTENTIALLY_UNUSED (sk);
+
+    using namespace sqlite;
+
+    std::size_t n (0);
+
+    // target_
+    //
+    if (sk != statement_update)
+    {
+      b[n].type = sqlite::image_traits<
+        ::std::string,
+        sqlite::id_text>::bind_value;
+      b[n].buffer = i.target_value.data ();
+      b[n].size = &i.target_size;
+      b[n].capacity = i.target_value.capacity ();
+      b[n].is_null = &i.target_null;
+      n++;
+    }
+
+    // url_
+    //
+    b[n].type = sqlite::image_traits<
+      ::std::string,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.url_value.data ();
+    b[n].size = &i.url_size;
+    b[n].capacity = i.url_value.capacity ();
+    b[n].is_null = &i.url_null;
+    n++;
+
+    // size_
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.size_value;
+    b[n].is_null = &i.size_null;
+    n++;
+
+    // hash_
+    //
+    b[n].type = sqlite::bind::blob;
+    b[n].buffer = i.hash_value.data ();
+    b[n].size = &i.hash_size;
+    b[n].capacity = i.hash_value.capacity ();
+    b[n].is_null = &i.hash_null;
+    n++;
+
+    // confirmed_
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.confirmed_value;
+    b[n].is_null = &i.confirmed_null;
+    n++;
+
+    // state_
+    //
+    b[n].type = sqlite::bind::blob;
+    b[n].buffer = i.state_value.data ();
+    b[n].size = &i.state_size;
+    b[n].capacity = i.state_value.capacity ();
+    b[n].is_null = &i.state_null;
+    n++;
+
+    // etag_
+    //
+    b[n].type = sqlite::image_traits<
+      ::std::string,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.etag_value.data ();
+    b[n].size = &i.etag_size;
+    b[n].capacity = i.etag_value.capacity ();
+    b[n].is_null = &i.etag_null;
+    n++;
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  bind (sqlite::bind* b, id_image_type& i)
+  {
+    std::size_t n (0);
+    b[n].type = sqlite::image_traits<
+      ::std::string,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.id_value.data ();
+    b[n].size = &i.id_size;
+    b[n].capacity = i.id_value.capacity ();
+    b[n].is_null = &i.id_null;
+  }
+
+  bool access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  init (image_type& i,
+        const object_type& o,
+        sqlite::statement_kind sk)
+  {
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (o);
+    ODB_POTENTIALLY_UNUSED (sk);
+
+    using namespace sqlite;
+
+    bool grew (false);
+
+    // target_
+    //
+    if (sk == statement_insert)
+    {
+      ::std::string const& v =
+        o.target_;
+
+      bool is_null (false);
+      std::size_t cap (i.target_value.capacity ());
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_image (
+        i.target_value,
+        i.target_size,
+        is_null,
+        v);
+      i.target_null = is_null;
+      grew = grew || (cap != i.target_value.capacity ());
+    }
+
+    // url_
+    //
+    {
+      ::std::string const& v =
+        o.url_;
+
+      bool is_null (false);
+      std::size_t cap (i.url_value.capacity ());
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_image (
+        i.url_value,
+        i.url_size,
+        is_null,
+        v);
+      i.url_null = is_null;
+      grew = grew || (cap != i.url_value.capacity ());
+    }
+
+    // size_
+    //
+    {
+      ::uint64_t const& v =
+        o.size_;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          ::uint64_t,
+          sqlite::id_integer >::set_image (
+        i.size_value,
+        is_null,
+        v);
+      i.size_null = is_null;
+    }
+
+    // hash_
+    //
+    {
+      ::launcher::blake3_digest::bytes_type const& v =
+        o.hash_;
+
+      bool is_null (false);
+      std::size_t cap (i.hash_value.capacity ());
+      sqlite::value_traits<
+          ::launcher::blake3_digest::bytes_type,
+          sqlite::id_blob >::set_image (
+        i.hash_value,
+        i.hash_size,
+        is_null,
+        v);
+      i.hash_null = is_null;
+      grew = grew || (cap != i.hash_value.capacity ());
+    }
+
+    // confirmed_
+    //
+    {
+      ::uint64_t const& v =
+        o.confirmed_;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          ::uint64_t,
+          sqlite::id_integer >::set_image (
+        i.confirmed_value,
+        is_null,
+        v);
+      i.confirmed_null = is_null;
+    }
+
+    // state_
+    //
+    {
+      ::std::vector< char > const& v =
+        o.state_;
+
+      bool is_null (false);
+      std::size_t cap (i.state_value.capacity ());
+      sqlite::value_traits<
+          ::std::vector< char >,
+          sqlite::id_blob >::set_image (
+        i.state_value,
+        i.state_size,
+        is_null,
+        v);
+      i.state_null = is_null;
+      grew = grew || (cap != i.state_value.capacity ());
+    }
+
+    // etag_
+    //
+    {
+      ::std::string const& v =
+        o.etag_;
+
+      bool is_null (false);
+      std::size_t cap (i.etag_value.capacity ());
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_image (
+        i.etag_value,
+        i.etag_size,
+        is_null,
+        v);
+      i.etag_null = is_null;
+      grew = grew || (cap != i.etag_value.capacity ());
+    }
+
+    return grew;
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  init (object_type& o,
+        const image_type& i,
+        database* db)
+  {
+    ODB_POTENTIALLY_UNUSED (o);
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (db);
+
+    // target_
+    //
+    {
+      ::std::string& v =
+        o.target_;
+
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_value (
+        v,
+        i.target_value,
+        i.target_size,
+        i.target_null);
+    }
+
+    // url_
+    //
+    {
+      ::std::string& v =
+        o.url_;
+
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_value (
+        v,
+        i.url_value,
+        i.url_size,
+        i.url_null);
+    }
+
+    // size_
+    //
+    {
+      ::uint64_t& v =
+        o.size_;
+
+      sqlite::value_traits<
+          ::uint64_t,
+          sqlite::id_integer >::set_value (
+        v,
+        i.size_value,
+        i.size_null);
+    }
+
+    // hash_
+    //
+    {
+      ::launcher::blake3_digest::bytes_type& v =
+        o.hash_;
+
+      sqlite::value_traits<
+          ::launcher::blake3_digest::bytes_type,
+          sqlite::id_blob >::set_value (
+        v,
+        i.hash_value,
+        i.hash_size,
+        i.hash_null);
+    }
+
+    // confirmed_
+    //
+    {
+      ::uint64_t& v =
+        o.confirmed_;
+
+      sqlite::value_traits<
+          ::uint64_t,
+          sqlite::id_integer >::set_value (
+        v,
+        i.confirmed_value,
+        i.confirmed_null);
+    }
+
+    // state_
+    //
+    {
+      ::std::vector< char >& v =
+        o.state_;
+
+      sqlite::value_traits<
+          ::std::vector< char >,
+          sqlite::id_blob >::set_value (
+        v,
+        i.state_value,
+        i.state_size,
+        i.state_null);
+    }
+
+    // etag_
+    //
+    {
+      ::std::string& v =
+        o.etag_;
+
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_value (
+        v,
+        i.etag_value,
+        i.etag_size,
+        i.etag_null);
+    }
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  init (id_image_type& i, const id_type& id)
+  {
+    bool grew (false);
+    {
+      bool is_null (false);
+      std::size_t cap (i.id_value.capacity ());
+      sqlite::value_traits<
+          ::std::string,
+          sqlite::id_text >::set_image (
+        i.id_value,
+        i.id_size,
+        is_null,
+        id);
+      i.id_null = is_null;
+      grew = grew || (cap != i.id_value.capacity ());
+    }
+
+    if (grew)
+      i.version++;
+  }
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::persist_statement[] =
+  "INSERT INTO \"download_journal\" "
+  "(\"target\", "
+  "\"url\", "
+  "\"size\", "
+  "\"hash\", "
+  "\"confirmed\", "
+  "\"state\", "
+  "\"etag\") "
+  "VALUES "
+  "(?, ?, ?, ?, ?, ?, ?)";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::find_statement[] =
+  "SELECT "
+  "\"download_journal\".\"target\", "
+  "\"download_journal\".\"url\", "
+  "\"download_journal\".\"size\", "
+  "\"download_journal\".\"hash\", "
+  "\"download_journal\".\"confirmed\", "
+  "\"download_journal\".\"state\", "
+  "\"download_journal\".\"etag\" "
+  "FROM \"download_journal\" "
+  "WHERE \"download_journal\".\"target\"=?";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::update_statement[] =
+  "UPDATE \"download_journal\" "
+  "SET "
+  "\"url\"=?, "
+  "\"size\"=?, "
+  "\"hash\"=?, "
+  "\"confirmed\"=?, "
+  "\"state\"=?, "
+  "\"etag\"=? "
+  "WHERE \"target\"=?";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::erase_statement[] =
+  "DELETE FROM \"download_journal\" "
+  "WHERE \"target\"=?";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::query_statement[] =
+  "SELECT "
+  "\"download_journal\".\"target\", "
+  "\"download_journal\".\"url\", "
+  "\"download_journal\".\"size\", "
+  "\"download_journal\".\"hash\", "
+  "\"download_journal\".\"confirmed\", "
+  "\"download_journal\".\"state\", "
+  "\"download_journal\".\"etag\" "
+  "FROM \"download_journal\"";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::erase_query_statement[] =
+  "DELETE FROM \"download_journal\"";
+
+  const char access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::table_name[] =
+  "\"download_journal\"";
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  persist (database& db, const object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    callback (db,
+              obj,
+              callback_event::pre_persist);
+
+    image_type& im (sts.image ());
+    binding& imb (sts.insert_image_binding ());
+
+    if (init (im, obj, statement_insert))
+      im.version++;
+
+    if (im.version != sts.insert_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_insert);
+      sts.insert_image_version (im.version);
+      imb.version++;
+    }
+
+    insert_statement& st (sts.persist_statement ());
+    if (!st.execute ())
+      throw object_already_persistent ();
+
+    callback (db,
+              obj,
+              callback_event::post_persist);
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  update (database& db, const object_type& obj)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+
+    using namespace sqlite;
+    using sqlite::update_statement;
+
+    callback (db, obj, callback_event::pre_update);
+
+    sqlite::transaction& tr (sqlite::transaction::current ());
+    sqlite::connection& conn (tr.connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    id_image_type& idi (sts.id_image ());
+    init (idi, id (obj));
+
+    image_type& im (sts.image ());
+    if (init (im, obj, statement_update))
+      im.version++;
+
+    bool u (false);
+    binding& imb (sts.update_image_binding ());
+    if (im.version != sts.update_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_update);
+      sts.update_image_version (im.version);
+      imb.version++;
+      u = true;
+    }
+
+    binding& idb (sts.id_image_binding ());
+    if (idi.version != sts.update_id_image_version () ||
+        idb.version == 0)
+    {
+      if (idi.version != sts.id_image_version () ||
+          idb.version == 0)
+      {
+        bind (idb.bind, idi);
+        sts.id_image_version (idi.version);
+        idb.version++;
+      }
+
+      sts.update_id_image_version (idi.version);
+
+      if (!u)
+        imb.version++;
+    }
+
+    update_statement& st (sts.update_statement ());
+    if (st.execute () == 0)
+      throw object_not_persistent ();
+
+    callback (db, obj, callback_event::post_update);
+    pointer_cache_traits::update (db, obj);
+  }
+
+  void access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  erase (database& db, const id_type& id)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    id_image_type& i (sts.id_image ());
+    init (i, id);
+
+    binding& idb (sts.id_image_binding ());
+    if (i.version != sts.id_image_version () || idb.version == 0)
+    {
+      bind (idb.bind, i);
+      sts.id_image_version (i.version);
+      idb.version++;
+    }
+
+    if (sts.erase_statement ().execute () != 1)
+      throw object_not_persistent ();
+
+    pointer_cache_traits::erase (db, id);
+  }
+
+  access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::pointer_type
+  access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  find (database& db, const id_type& id)
+  {
+    using namespace sqlite;
+
+    {
+      pointer_type p (pointer_cache_traits::find (db, id));
+
+      if (!pointer_traits::null_ptr (p))
+        return p;
+    }
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+
+    if (l.locked ())
+    {
+      if (!find_ (sts, &id))
+        return pointer_type ();
+    }
+
+    pointer_type p (
+      access::object_factory<object_type, pointer_type>::create ());
+    pointer_traits::guard pg (p);
+
+    pointer_cache_traits::insert_guard ig (
+      pointer_cache_traits::insert (db, id, p));
+
+    object_type& obj (pointer_traits::get_ref (p));
+
+    if (l.locked ())
+    {
+      select_statement& st (sts.find_statement ());
+      ODB_POTENTIALLY_UNUSED (st);
+
+      callback (db, obj, callback_event::pre_load);
+      init (obj, sts.image (), &db);
+      load_ (sts, obj, false);
+      sts.load_delayed (0);
+      l.unlock ();
+      callback (db, obj, callback_event::post_load);
+      pointer_cache_traits::load (ig.position ());
+    }
+    else
+      sts.delay_load (id, obj, ig.position ());
+
+    ig.release ();
+    pg.release ();
+    return p;
+  }
+
+  bool access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  find (database& db, const id_type& id, object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+    assert (l.locked ()) /* Must be a top-level call. */;
+
+    if (!find_ (sts, &id))
+      return false;
+
+    select_statement& st (sts.find_statement ());
+    ODB_POTENTIALLY_UNUSED (st);
+
+    reference_cache_traits::position_type pos (
+      reference_cache_traits::insert (db, id, obj));
+    reference_cache_traits::insert_guard ig (pos);
+
+    callback (db, obj, callback_event::pre_load);
+    init (obj, sts.image (), &db);
+    load_ (sts, obj, false);
+    sts.load_delayed (0);
+    l.unlock ();
+    callback (db, obj, callback_event::post_load);
+    reference_cache_traits::load (pos);
+    ig.release ();
+    return true;
+  }
+
+  bool access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  reload (database& db, object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+    assert (l.locked ()) /* Must be a top-level call. */;
+
+    const id_type& id (object_traits_impl::id (obj));
+    if (!find_ (sts, &id))
+      return false;
+
+    select_statement& st (sts.find_statement ());
+    ODB_POTENTIALLY_UNUSED (st);
+
+    callback (db, obj, callback_event::pre_load);
+    init (obj, sts.image (), &db);
+    load_ (sts, obj, true);
+    sts.load_delayed (0);
+    l.unlock ();
+    callback (db, obj, callback_event::post_load);
+    return true;
+  }
+
+  bool access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  find_ (statements_type& sts,
+         const id_type* id)
+  {
+    using namespace sqlite;
+
+    id_image_type& i (sts.id_image ());
+    init (i, *id);
+
+    binding& idb (sts.id_image_binding ());
+    if (i.version != sts.id_image_version () || idb.version == 0)
+    {
+      bind (idb.bind, i);
+      sts.id_image_version (i.version);
+      idb.version++;
+    }
+
+    image_type& im (sts.image ());
+    binding& imb (sts.select_image_binding ());
+
+    if (im.version != sts.select_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_select);
+      sts.select_image_version (im.version);
+      imb.version++;
+    }
+
+    select_statement& st (sts.find_statement ());
+
+    st.execute ();
+    auto_result ar (st);
+    select_statement::result r (st.fetch ());
+
+    if (r == select_statement::truncated)
+    {
+      if (grow (im, sts.select_image_truncated ()))
+        im.version++;
+
+      if (im.version != sts.select_image_version ())
+      {
+        bind (imb.bind, im, statement_select);
+        sts.select_image_version (im.version);
+        imb.version++;
+        st.refetch ();
+      }
+    }
+
+    return r != select_statement::no_data;
+  }
+
+  result< access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::object_type >
+  access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  query (database& db, const query_base_type& q)
+  {
+    using namespace sqlite;
+    using odb::details::shared;
+    using odb::details::shared_ptr;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    image_type& im (sts.image ());
+    binding& imb (sts.select_image_binding ());
+
+    if (im.version != sts.select_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_select);
+      sts.select_image_version (im.version);
+      imb.version++;
+    }
+
+    std::string text (query_statement);
+    if (!q.empty ())
+    {
+      text += " ";
+      text += q.clause ();
+    }
+
+    q.init_parameters ();
+    shared_ptr<select_statement> st (
+      new (shared) select_statement (
+        conn,
+        text,
+        false,
+        true,
+        q.parameters_binding (),
+        imb));
+
+    st->execute ();
+
+    shared_ptr< odb::object_result_impl<object_type> > r (
+      new (shared) sqlite::object_result_impl<object_type> (
+        q, st, sts, 0));
+
+    return result<object_type> (r);
+  }
+
+  unsigned long long access::object_traits_impl< ::launcher::journaled_download, id_sqlite >::
+  erase_query (database& db, const query_base_type& q)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+
+    std::string text (erase_query_statement);
+    if (!q.empty ())
+    {
+      text += ' ';
+      text += q.clause ();
+    }
+
+    q.init_parameters ();
+    delete_statement st (
+      conn,
+      text,
+      q.parameters_binding ());
+
+    return st.execute ();
+  }
+}
+
+namespace odb
+{
+  static bool
+  create_schema (database& db, unsigned short pass, bool drop)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+    ODB_POTENTIALLY_UNUSED (pass);
+    ODB_POTENTIALLY_UNUSED (drop);
+
+    if (drop)
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("DROP TABLE IF EXISTS \"download_journal\"");
+          db.execute ("DROP TABLE IF EXISTS \"user_settings\"");
+          db.execute ("DROP TABLE IF EXISTS \"component_versions\"");
+          db.execute ("DROP TABLE IF EXISTS \"cached_files\"");
+          return false;
+        }
+      }
+    }
+    else
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          db.execute ("CREATE TABLE \"cached_files\" (\n"
+                      "  \"path\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"mtime\" INTEGER NOT NULL,\n"
+                      "  \"version\" TEXT NOT NULL,\n"
+                      "  \"component\" INTEGER NOT NULL,\n"
+                      "  \"size\" INTEGER NOT NULL,\n"
+                      "  \"hash\" BLOB NOT NULL)");
+          db.execute ("CREATE INDEX \"cached_files_version_i\"\n"
+                      "  ON \"cached_files\" (\"version\")");
+          db.execute ("CREATE TABLE \"component_versions\" (\n"
+                      "  \"component\" INTEGER NOT NULL PRIMARY KEY,\n"
+                      "  \"tag\" TEXT NOT NULL,\n"
+                      "  \"installed_at\" INTEGER NOT NULL)");
+          db.execute ("CREATE TABLE \"user_settings\" (\n"
+                      "  \"key\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"val\" TEXT NOT NULL)");
+          db.execute ("CREATE TABLE \"download_journal\" (\n"
+                      "  \"target\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"url\" TEXT NOT NULL,\n"
+                      "  \"size\" INTEGER NOT NULL,\n"
+                      "  \"hash\" BLOB NOT NULL,\n"
+                      "  \"confirmed\" INTEGER NOT NULL,\n"
+                      "  \"state\" BLOB NOT NULL,\n"
+                      "  \"etag\" TEXT NOT NULL)");
           return false;
         }
       }
@@ -161,6 +161,48 @@ namespace odb
     static void
     callback (database&, const object_type&, callback_event);
   };
+
+  // journaled_download
+  //
+  template <>
+  struct class_traits< ::launcher::journaled_download >
+  {
+    static const class_kind kind = class_object;
+  };
+
+  template <>
+  class access::object_traits< ::launcher::journaled_download >
+  {
+    public:
+    typedef ::launcher::journaled_download object_type;
+    typedef ::launcher::journaled_download* pointer_type;
+    typedef odb::pointer_traits<pointer_type> pointer_traits;
+
+    static const bool polymorphic = false;
+
+    typedef ::std::string id_type;
+
+    static const bool auto_id = false;
+
+    static const bool abstract = false;
+
+    static id_type
+    id (const object_type&);
+
+    typedef
+    no_op_pointer_cache_traits<pointer_type>
+    pointer_cache_traits;
+
+    typedef
+    no_op_reference_cache_traits<object_type>
+    reference_cache_traits;
+
+    static void
+    callback (database&, object_type&, callback_event);
+
+    static void
+    callback (database&, const object_type&, callback_event);
+  };
 }
 
 #include <odb/details/buffer.hxx>
@@ -243,9 +285,9 @@ namespace odb
     typedef
     sqlite::query_column<
       sqlite::value_traits<
-        ::std::string,
-        sqlite::id_text >::query_type,
-      sqlite::id_text >
+        ::launcher::blake3_digest::bytes_type,
+        sqlite::id_blob >::query_type,
+      sqlite::id_blob >
     hash_type_;
 
     static const hash_type_ hash;
@@ -813,12 +855,304 @@ namespace odb
   {
   };
 
+  // journaled_download
+  //
+  template <typename A>
+  struct query_columns< ::launcher::journaled_download, id_sqlite, A >
+  {
+    // target
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::std::string,
+        sqlite::id_text >::query_type,
+      sqlite::id_text >
+    target_type_;
+
+    static const target_type_ target;
+
+    // url
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::std::string,
+        sqlite::id_text >::query_type,
+      sqlite::id_text >
+    url_type_;
+
+    static const url_type_ url;
+
+    // size
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::uint64_t,
+        sqlite::id_integer >::query_type,
+      sqlite::id_integer >
+    size_type_;
+
+    static const size_type_ size;
+
+    // hash
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::launcher::blake3_digest::bytes_type,
+        sqlite::id_blob >::query_type,
+      sqlite::id_blob >
+    hash_type_;
+
+    static const hash_type_ hash;
+
+    // confirmed
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::uint64_t,
+        sqlite::id_integer >::query_type,
+      sqlite::id_integer >
+    confirmed_type_;
+
+    static const confirmed_type_ confirmed;
+
+    // state
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::std::vector< char >,
+        sqlite::id_blob >::query_type,
+      sqlite::id_blob >
+    state_type_;
+
+    static const state_type_ state;
+
+    // etag
+    //
+    typedef
+    sqlite::query_column<
+      sqlite::value_traits<
+        ::std::string,
+        sqlite::id_text >::query_type,
+      sqlite::id_text >
+    etag_type_;
+
+    static const etag_type_ etag;
+  };
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::target_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  target (A::table_name, "\"target\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::url_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  url (A::table_name, "\"url\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::size_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  size (A::table_name, "\"size\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::hash_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  hash (A::table_name, "\"hash\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::confirmed_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  confirmed (A::table_name, "\"confirmed\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::state_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  state (A::table_name, "\"state\"", 0);
+
+  template <typename A>
+  const typename query_columns< ::launcher::journaled_download, id_sqlite, A >::etag_type_
+  query_columns< ::launcher::journaled_download, id_sqlite, A >::
+  etag (A::table_name, "\"etag\"", 0);
+
+  template <typename A>
+  struct pointer_query_columns< ::launcher::journaled_download, id_sqlite, A >:
+    query_columns< ::launcher::journaled_download, id_sqlite, A >
+  {
+  };
+
+  template <>
+  class access::object_traits_impl< ::launcher::journaled_download, id_sqlite >:
+    public access::object_traits< ::launcher::journaled_download >
+  {
+    public:
+    struct id_image_type
+    {
+      details::buffer id_value;
+      std::size_t id_size;
+      bool id_null;
+
+      std::size_t version;
+    };
+
+    struct image_type
+    {
+      // target_
+      //
+      details::buffer target_value;
+      std::size_t target_size;
+      bool target_null;
+
+      // url_
+      //
+      details::buffer url_value;
+      std::size_t url_size;
+      bool url_null;
+
+      // size_
+      //
+      long long size_value;
+      bool size_null;
+
+      // hash_
+      //
+      details::buffer hash_value;
+      std::size_t hash_size;
+      bool hash_null;
+
+      // confirmed_
+      //
+      long long confirmed_value;
+      bool confirmed_null;
+
+      // state_
+      //
+      details::buffer state_value;
+      std::size_t state_size;
+      bool state_null;
+
+      // etag_
+      //
+      details::buffer etag_value;
+      std::size_t etag_size;
+      bool etag_null;
+
+      std::size_t version;
+    };
+
+    struct extra_statement_cache_type;
+
+    using object_traits<object_type>::id;
+
+    static id_type
+    id (const image_type&);
+
+    static bool
+    grow (image_type&,
+          bool*);
+
+    static void
+    bind (sqlite::bind*,
+          image_type&,
+          sqlite::statement_kind);
+
+    static void
+    bind (sqlite::bind*, id_image_type&);
+
+    static bool
+    init (image_type&,
+          const object_type&,
+          sqlite::statement_kind);
+
+    static void
+    init (object_type&,
+          const image_type&,
+          database*);
+
+    static void
+    init (id_image_type&, const id_type&);
+
+    typedef sqlite::object_statements<object_type> statements_type;
+
+    typedef sqlite::query_base query_base_type;
+
+    static const std::size_t column_count = 7UL;
+    static const std::size_t id_column_count = 1UL;
+    static const std::size_t inverse_column_count = 0UL;
+    static const std::size_t readonly_column_count = 0UL;
+    static const std::size_t managed_optimistic_column_count = 0UL;
+
+    static const std::size_t separate_load_column_count = 0UL;
+    static const std::size_t separate_update_column_count = 0UL;
+
+    static const bool versioned = false;
+
+    static const char persist_statement[];
+    static const char find_statement[];
+    static const char update_statement[];
+    static const char erase_statement[];
+    static const char query_statement[];
+    static const char erase_query_statement[];
+
+    static const char table_name[];
+
+    static void
+    persist (database&, const object_type&);
+
+    static pointer_type
+    find (database&, const id_type&);
+
+    static bool
+    find (database&, const id_type&, object_type&);
+
+    static bool
+    reload (database&, object_type&);
+
+    static void
+    update (database&, const object_type&);
+
+    static void
+    erase (database&, const id_type&);
+
+    static void
+    erase (database&, const object_type&);
+
+    static result<object_type>
+    query (database&, const query_base_type&);
+
+    static unsigned long long
+    erase_query (database&, const query_base_type&);
+
+    public:
+    static bool
+    find_ (statements_type&,
+           const id_type*);
+
+    static void
+    load_ (statements_type&,
+           object_type&,
+           bool reload);
+  };
+
+  template <>
+  class access::object_traits_impl< ::launcher::journaled_download, id_common >:
+    public access::object_traits_impl< ::launcher::journaled_download, id_sqlite >
+  {
+  };
+
   // cached_file
   //
   // component_version
   //
   // user_setting
   //
+  // journaled_download
+  //
 }
 
 #include <launcher/cache/cache-types-odb.ixx>
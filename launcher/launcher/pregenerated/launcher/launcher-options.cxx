@@ -769,6 +769,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -793,6 +801,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -820,6 +836,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -847,6 +871,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -876,6 +908,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -901,6 +941,14 @@ namespace launcher
     prerelease_ (),
     jobs_ (99),
     jobs_specified_ (false),
+    metadata_ttl_ (0),
+    metadata_ttl_specified_ (false),
+    stall_rate_ (16384),
+    stall_rate_specified_ (false),
+    stall_time_ (20),
+    stall_time_specified_ (false),
+    schedule_ ("critical"),
+    schedule_specified_ (false),
     game_exe_ ("iw4x.exe"),
     game_exe_specified_ (false),
     game_args_ (),
@@ -920,27 +968,35 @@ namespace launcher
     if (p == ::launcher::cli::usage_para::text)
       os << ::std::endl;
 
-    os << "--help             Show this help message and exit." << ::std::endl;
+    os << "--help               Show this help message and exit." << ::std::endl;
 
-    os << "--version          Show version information and exit." << ::std::endl;
+    os << "--version            Show version information and exit." << ::std::endl;
 
-    os << "--build2-metadata  Print the build2 metadata and exit." << ::std::endl;
+    os << "--build2-metadata    Print the build2 metadata and exit." << ::std::endl;
 
-    os << "--path <dir>       The installation directory for the game files." << ::std::endl;
+    os << "--path <dir>         The installation directory for the game files." << ::std::endl;
 
-    os << "--prerelease       Opt-in to pre-release (beta) updates." << ::std::endl;
+    os << "--prerelease         Opt-in to pre-release (beta) updates." << ::std::endl;
 
-    os << "--jobs|-j <num>    The number of parallel download jobs to run." << ::std::endl;
+    os << "--jobs|-j <num>      The number of parallel download jobs to run." << ::std::endl;
 
-    os << "--game-exe <file>  The game executable to launch." << ::std::endl;
+    os << "--metadata-ttl <sec> Trust the release metadata fetched by a previous run for up to <sec> seconds, at the cost of picking up new client and launcher releases one run late." << ::std::endl;
 
-    os << "--game-args <arg>  Additional arguments to pass to the game executable." << ::std::endl;
+    os << "--stall-rate <num>   Consider a download stalled while it transfers fewer than <num> bytes per second." << ::std::endl;
 
-    os << "--no-self-update   Skip the automatic launcher self-update check." << ::std::endl;
+    os << "--stall-time <sec>   Restart a download that stays stalled for <sec> seconds." << ::std::endl;
 
-    os << "--self-update-only Only check for and apply launcher updates, then exit." << ::std::endl;
+    os << "--schedule <policy>  The order in which to start downloads of equal priority." << ::std::endl;
 
-    os << "--skip-launch      Skip launching the game after updating/installing." << ::std::endl;
+    os << "--game-exe <file>    The game executable to launch." << ::std::endl;
+
+    os << "--game-args <arg>    Additional arguments to pass to the game executable." << ::std::endl;
+
+    os << "--no-self-update     Skip the automatic launcher self-update check." << ::std::endl;
+
+    os << "--self-update-only   Only check for and apply launcher updates, then exit." << ::std::endl;
+
+    os << "--skip-launch        Skip launching the game after updating/installing." << ::std::endl;
 
     p = ::launcher::cli::usage_para::option;
 
@@ -974,6 +1030,18 @@ namespace launcher
       _cli_options_map_["-j"] =
       &::launcher::cli::thunk< options, std::size_t, &options::jobs_,
         &options::jobs_specified_ >;
+      _cli_options_map_["--metadata-ttl"] =
+      &::launcher::cli::thunk< options, std::uint64_t, &options::metadata_ttl_,
+        &options::metadata_ttl_specified_ >;
+      _cli_options_map_["--stall-rate"] =
+      &::launcher::cli::thunk< options, std::uint64_t, &options::stall_rate_,
+        &options::stall_rate_specified_ >;
+      _cli_options_map_["--stall-time"] =
+      &::launcher::cli::thunk< options, std::uint64_t, &options::stall_time_,
+        &options::stall_time_specified_ >;
+      _cli_options_map_["--schedule"] =
+      &::launcher::cli::thunk< options, std::string, &options::schedule_,
+        &options::schedule_specified_ >;
       _cli_options_map_["--game-exe"] =
       &::launcher::cli::thunk< options, std::string, &options::game_exe_,
         &options::game_exe_specified_ >;
@@ -498,6 +498,30 @@ namespace launcher
     bool
     jobs_specified () const;
 
+    const std::uint64_t&
+    metadata_ttl () const;
+
+    bool
+    metadata_ttl_specified () const;
+
+    const std::uint64_t&
+    stall_rate () const;
+
+    bool
+    stall_rate_specified () const;
+
+    const std::uint64_t&
+    stall_time () const;
+
+    bool
+    stall_time_specified () const;
+
+    const std::string&
+    schedule () const;
+
+    bool
+    schedule_specified () const;
+
     const std::string&
     game_exe () const;
 
@@ -546,6 +570,14 @@ namespace launcher
     bool prerelease_;
     std::size_t jobs_;
     bool jobs_specified_;
+    std::uint64_t metadata_ttl_;
+    bool metadata_ttl_specified_;
+    std::uint64_t stall_rate_;
+    bool stall_rate_specified_;
+    std::uint64_t stall_time_;
+    bool stall_time_specified_;
+    std::string schedule_;
+    bool schedule_specified_;
     std::string game_exe_;
     bool game_exe_specified_;
     std::vector<std::string> game_args_;
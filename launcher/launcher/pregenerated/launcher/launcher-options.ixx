@@ -329,6 +329,54 @@ namespace launcher
     return this->jobs_specified_;
   }
 
+  inline const std::uint64_t& options::
+  metadata_ttl () const
+  {
+    return this->metadata_ttl_;
+  }
+
+  inline bool options::
+  metadata_ttl_specified () const
+  {
+    return this->metadata_ttl_specified_;
+  }
+
+  inline const std::uint64_t& options::
+  stall_rate () const
+  {
+    return this->stall_rate_;
+  }
+
+  inline bool options::
+  stall_rate_specified () const
+  {
+    return this->stall_rate_specified_;
+  }
+
+  inline const std::uint64_t& options::
+  stall_time () const
+  {
+    return this->stall_time_;
+  }
+
+  inline bool options::
+  stall_time_specified () const
+  {
+    return this->stall_time_specified_;
+  }
+
+  inline const std::string& options::
+  schedule () const
+  {
+    return this->schedule_;
+  }
+
+  inline bool options::
+  schedule_specified () const
+  {
+    return this->schedule_specified_;
+  }
+
   inline const std::string& options::
   game_exe () const
   {
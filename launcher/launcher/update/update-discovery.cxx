@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <sstream>
 #include <stdexcept>
 
 #include <launcher/launcher-log.hxx>
@@ -76,6 +77,10 @@ namespace launcher
     if (ui.version > v)
     {
       launcher::log::info (categories::update{}, "update available: target version {} is newer than current", ui.tag_name);
+
+      if (ui.find_patch (v) != nullptr)
+        launcher::log::debug (categories::update{}, "binary patch from current version is available");
+
       co_return ui;
     }
 
@@ -221,6 +226,7 @@ namespace launcher
     ui.asset_url = a->browser_download_url;
     ui.asset_name = a->name;
     ui.asset_size = a->size;
+    ui.patches = find_platform_patches (r);
 
     return ui;
   }
@@ -331,4 +337,60 @@ namespace launcher
 
     return res;
   }
+
+  vector<update_patch> update_discovery::
+  find_platform_patches (const release_type& r) const
+  {
+    vector<update_patch> ps;
+
+    ostringstream os;
+    os << '-' << current_platform () << ".patch";
+    const string s (os.str ());
+    const string p ("launcher-");
+
+    for (const auto& a : r.assets)
+    {
+      const string& n (a.name);
+
+      if (n.size () <= p.size () + s.size () ||
+          n.compare (0, p.size (), p) != 0 ||
+          n.compare (n.size () - s.size (), s.size (), s) != 0)
+        continue;
+
+      // Whatever is between the prefix and the suffix should be the two
+      // versions separated by an underscore (which can't appear in the
+      // versions themselves).
+      //
+      string m (n.substr (p.size (), n.size () - p.size () - s.size ()));
+      size_t u (m.find ('_'));
+
+      if (u == string::npos)
+      {
+        launcher::log::trace_l3 (categories::update{}, "ignoring patch asset '{}' without version pair", n);
+        continue;
+      }
+
+      auto f (parse_launcher_version (m.substr (0, u)));
+      auto t (parse_launcher_version (m.substr (u + 1)));
+
+      if (!f || !t)
+      {
+        launcher::log::warning (categories::update{}, "failed to parse version pair from patch asset '{}'", n);
+        continue;
+      }
+
+      launcher::log::trace_l3 (categories::update{}, "found patch asset: {}", n);
+
+      update_patch up;
+      up.from = move (*f);
+      up.to = move (*t);
+      up.url = a.browser_download_url;
+      up.name = n;
+      up.size = a.size;
+
+      ps.push_back (move (up));
+    }
+
+    return ps;
+  }
 }
@@ -6,6 +6,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <launcher/update/update-types.hxx>
 
@@ -111,6 +112,13 @@ namespace launcher
     std::optional<launcher_version>
     parse_asset_version (const std::string& asset_name) const;
 
+    // Find the binary patches for the current platform in the release.
+    //
+    // launcher-<from>_<to>-<platform>.patch
+    //
+    std::vector<update_patch>
+    find_platform_patches (const release_type& release) const;
+
     asio::io_context& ioc_;
     std::unique_ptr<api_type> api_;
     bool include_prerelease_ = false;
@@ -17,6 +17,7 @@
 #include <miniz.h>
 
 #include <launcher/launcher-log.hxx>
+#include <launcher/update/update-patch.hxx>
 
 using namespace std;
 
@@ -65,6 +66,13 @@ namespace launcher
     verify_size_ = v;
   }
 
+  void update_installer::
+  set_current_version (const launcher_version& v)
+  {
+    launcher::log::trace_l3 (categories::update{}, "set_current_version: {}", v.string ());
+    current_version_ = v;
+  }
+
   asio::awaitable<update_result> update_installer::
   install (const update_info& ui)
   {
@@ -89,17 +97,48 @@ namespace launcher
       // exception out.
       //
 
-      // 1. Download.
-      //
-      launcher::log::trace_l1 (categories::update{}, "downloading update archive");
-      fs::path a (co_await download_archive (ui));
-      temp_files_.push_back (a);
+      fs::path b;
 
-      // 2. Extract.
+      // 0. Patch.
+      //
+      // If there is a patch from the version we are running, try that
+      // first. Any failure (missing asset, we are not quite the binary the
+      // patch was made for, corrupt result) simply means we fall back to
+      // the full archive.
       //
-      launcher::log::trace_l1 (categories::update{}, "extracting launcher binary");
-      fs::path b (co_await extract_launcher (a, ui));
-      temp_files_.push_back (b);
+      const update_patch* p (current_version_
+                             ? ui.find_patch (*current_version_)
+                             : nullptr);
+
+      if (p != nullptr)
+      {
+        launcher::log::trace_l1 (categories::update{}, "applying binary patch {}", p->name);
+
+        try
+        {
+          b = co_await apply_patch (*p);
+        }
+        catch (const exception& e)
+        {
+          launcher::log::warning (categories::update{}, "binary patch failed, falling back to full download: {}", e.what ());
+          b.clear ();
+        }
+      }
+
+      if (b.empty ())
+      {
+        // 1. Download.
+        //
+        launcher::log::trace_l1 (categories::update{}, "downloading update archive");
+        fs::path a (co_await download_archive (ui));
+        temp_files_.push_back (a);
+
+        // 2. Extract.
+        //
+        launcher::log::trace_l1 (categories::update{}, "extracting launcher binary");
+        b = co_await extract_launcher (a, ui);
+        temp_files_.push_back (b);
+      }
 
       // We expect the extractor to either throw or produce the file. If it
       // didn't throw but the file is missing, something is really wrong with
@@ -401,6 +440,47 @@ namespace launcher
     co_return t;
   }
 
+  asio::awaitable<fs::path> update_installer::
+  apply_patch (const update_patch& up)
+  {
+    fs::path pp (download_dir_ / up.name);
+    launcher::log::trace_l2 (categories::update{}, "downloading patch {} to {}", up.name, pp.string ());
+
+    error_code ec;
+    fs::create_directories (download_dir_, ec);
+
+    temp_files_.push_back (pp);
+
+    auto cb = [this, tot = up.size]
+              (uint64_t cur, uint64_t /* hint */)
+    {
+      double p (tot > 0 ? static_cast<double> (cur) / tot : 0.0);
+      report_progress (update_state::downloading, p, "Downloading patch...");
+    };
+
+    co_await http_->download (up.url,
+                              pp.string (),
+                              cb,
+                              nullopt,
+                              0);
+
+    // Write the result under the same name as the running binary so that
+    // the rest of the pipeline doesn't care where it came from.
+    //
+    fs::path s (current_executable_path ());
+    fs::path d (download_dir_ / "launcher_update_patched");
+    fs::create_directories (d, ec);
+    temp_files_.push_back (d);
+
+    fs::path t (d / s.filename ());
+
+    launcher::log::trace_l2 (categories::update{}, "applying patch {} to {}", pp.string (), s.string ());
+    apply_update_patch (s, pp, t);
+
+    launcher::log::debug (categories::update{}, "patched binary verified: {}", t.string ());
+    co_return t;
+  }
+
   asio::awaitable<fs::path> update_installer::
   extract_launcher (const fs::path& ap, const update_info& ui)
   {
@@ -7,6 +7,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <launcher/download/download.hxx>
 #include <launcher/http/http.hxx>
@@ -74,6 +75,13 @@ namespace launcher
     void
     set_verify_size (bool verify);
 
+    // The version we are running. If set and the release carries a binary
+    // patch from it, we try the (much smaller) patch before falling back to
+    // the full archive.
+    //
+    void
+    set_current_version (const launcher_version& version);
+
     // Mechanics.
     //
 
@@ -135,6 +143,13 @@ namespace launcher
     asio::awaitable<fs::path>
     download_archive (const update_info& info);
 
+    // Download the patch and apply it to the running binary. Throws if
+    // anything goes wrong, including if the result does not hash to what
+    // the patch promised.
+    //
+    asio::awaitable<fs::path>
+    apply_patch (const update_patch& patch);
+
     // Extract the launcher binary from the archive.
     //
     asio::awaitable<fs::path>
@@ -165,6 +180,7 @@ namespace launcher
     progress_callback_type progress_callback_;
     fs::path download_dir_;
     bool verify_size_ = true;
+    std::optional<launcher_version> current_version_;
     std::vector<fs::path> temp_files_;
   };
 }
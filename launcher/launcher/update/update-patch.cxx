@@ -0,0 +1,299 @@
+#include <launcher/update/update-patch.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miniz.h>
+
+#include <launcher/blake3.h>
+
+using namespace std;
+
+namespace launcher
+{
+  static const char patch_magic[8] = {'I', 'W', '4', 'X', 'P', 'T', 'C', 'H'};
+  static const uint32_t patch_version (1);
+  static const size_t patch_header_size (96);
+
+  enum : uint8_t
+  {
+    op_end    = 0x00,
+    op_copy   = 0x01,
+    op_add    = 0x02,
+    op_insert = 0x03
+  };
+
+  static vector<uint8_t>
+  read_file (const fs::path& p)
+  {
+    ifstream ifs (p, ios::binary);
+    if (!ifs)
+      throw runtime_error ("failed to open " + p.string ());
+
+    vector<uint8_t> r ((istreambuf_iterator<char> (ifs)),
+                       istreambuf_iterator<char> ());
+
+    if (ifs.bad ())
+      throw runtime_error ("failed to read " + p.string ());
+
+    return r;
+  }
+
+  static array<uint8_t, 32>
+  digest (const vector<uint8_t>& d)
+  {
+    array<uint8_t, 32> r;
+
+    blake3_hasher h;
+    blake3_hasher_init (&h);
+    blake3_hasher_update (&h, d.data (), d.size ());
+    blake3_hasher_finalize (&h, r.data (), r.size ());
+
+    return r;
+  }
+
+  // Little-endian cursor over a byte buffer that throws instead of reading
+  // past the end.
+  //
+  namespace
+  {
+    struct cursor
+    {
+      const uint8_t* p;
+      const uint8_t* e;
+
+      void
+      need (uint64_t n) const
+      {
+        if (static_cast<uint64_t> (e - p) < n)
+          throw runtime_error ("truncated patch");
+      }
+
+      uint8_t
+      u8 ()
+      {
+        need (1);
+        return *p++;
+      }
+
+      uint32_t
+      u32 ()
+      {
+        need (4);
+        uint32_t r (0);
+        for (int i (0); i != 4; ++i)
+          r |= static_cast<uint32_t> (*p++) << (i * 8);
+        return r;
+      }
+
+      uint64_t
+      u64 ()
+      {
+        need (8);
+        uint64_t r (0);
+        for (int i (0); i != 8; ++i)
+          r |= static_cast<uint64_t> (*p++) << (i * 8);
+        return r;
+      }
+
+      const uint8_t*
+      bytes (uint64_t n)
+      {
+        need (n);
+        const uint8_t* r (p);
+        p += n;
+        return r;
+      }
+    };
+  }
+
+  static update_patch_header
+  parse_header (cursor& c)
+  {
+    if (memcmp (c.bytes (sizeof (patch_magic)), patch_magic,
+                sizeof (patch_magic)) != 0)
+      throw runtime_error ("not a launcher patch");
+
+    if (c.u32 () != patch_version)
+      throw runtime_error ("unsupported launcher patch version");
+
+    c.u32 (); // Reserved.
+
+    update_patch_header h;
+    h.source_size = c.u64 ();
+    memcpy (h.source_hash.data (), c.bytes (32), 32);
+    h.target_size = c.u64 ();
+    memcpy (h.target_hash.data (), c.bytes (32), 32);
+
+    return h;
+  }
+
+  update_patch_header
+  read_update_patch_header (const fs::path& p)
+  {
+    ifstream ifs (p, ios::binary);
+    if (!ifs)
+      throw runtime_error ("failed to open " + p.string ());
+
+    uint8_t b[patch_header_size];
+    if (!ifs.read (reinterpret_cast<char*> (b), sizeof (b)))
+      throw runtime_error ("truncated patch");
+
+    cursor c {b, b + sizeof (b)};
+    return parse_header (c);
+  }
+
+  void
+  apply_update_patch (const fs::path& sp,
+                      const fs::path& pp,
+                      const fs::path& tp)
+  {
+    vector<uint8_t> pd (read_file (pp));
+
+    cursor hc {pd.data (), pd.data () + pd.size ()};
+    update_patch_header h (parse_header (hc));
+
+    // Make sure we are patching what the patch was made for. Applying it to
+    // anything else would produce garbage that we'd only catch at the end.
+    //
+    vector<uint8_t> src (read_file (sp));
+
+    if (src.size () != h.source_size || digest (src) != h.source_hash)
+      throw runtime_error ("patch does not apply to " + sp.string ());
+
+    // Inflate the operation stream. The body can't legitimately be much
+    // larger than the target (an add or insert carries at most the bytes it
+    // produces), so cap it to guard against a hostile stream.
+    //
+    vector<uint8_t> ops;
+    {
+      uint64_t cap (h.target_size * 2 + 1024 * 1024);
+
+      mz_stream s;
+      memset (&s, 0, sizeof (s));
+
+      if (mz_inflateInit (&s) != MZ_OK)
+        throw runtime_error ("failed to initialize inflate stream");
+
+      s.next_in = hc.p;
+      s.avail_in = static_cast<unsigned int> (hc.e - hc.p);
+
+      vector<uint8_t> buf (64 * 1024);
+      int r;
+
+      do
+      {
+        s.next_out = buf.data ();
+        s.avail_out = static_cast<unsigned int> (buf.size ());
+
+        r = mz_inflate (&s, MZ_NO_FLUSH);
+
+        if (r != MZ_OK && r != MZ_STREAM_END)
+        {
+          mz_inflateEnd (&s);
+          throw runtime_error ("corrupt patch body");
+        }
+
+        ops.insert (ops.end (),
+                    buf.data (),
+                    buf.data () + (buf.size () - s.avail_out));
+
+        if (ops.size () > cap)
+        {
+          mz_inflateEnd (&s);
+          throw runtime_error ("patch body too large");
+        }
+      }
+      while (r != MZ_STREAM_END);
+
+      mz_inflateEnd (&s);
+    }
+
+    vector<uint8_t> dst;
+    dst.reserve (h.target_size);
+
+    auto grow ([&dst, &h] (uint64_t n)
+    {
+      if (h.target_size - dst.size () < n)
+        throw runtime_error ("patch overruns target size");
+    });
+
+    auto range ([&src] (uint64_t o, uint64_t n)
+    {
+      if (o > src.size () || src.size () - o < n)
+        throw runtime_error ("patch references data past end of source");
+    });
+
+    cursor c {ops.data (), ops.data () + ops.size ()};
+
+    for (bool done (false); !done; )
+    {
+      switch (c.u8 ())
+      {
+      case op_end:
+        {
+          done = true;
+          break;
+        }
+      case op_copy:
+        {
+          uint64_t o (c.u64 ());
+          uint64_t n (c.u64 ());
+
+          range (o, n);
+          grow (n);
+          dst.insert (dst.end (), src.data () + o, src.data () + o + n);
+          break;
+        }
+      case op_add:
+        {
+          uint64_t o (c.u64 ());
+          uint64_t n (c.u64 ());
+          const uint8_t* d (c.bytes (n));
+
+          range (o, n);
+          grow (n);
+          for (uint64_t i (0); i != n; ++i)
+            dst.push_back (static_cast<uint8_t> (src[o + i] + d[i]));
+          break;
+        }
+      case op_insert:
+        {
+          uint64_t n (c.u64 ());
+          const uint8_t* d (c.bytes (n));
+
+          grow (n);
+          dst.insert (dst.end (), d, d + n);
+          break;
+        }
+      default:
+        throw runtime_error ("unknown patch operation");
+      }
+    }
+
+    if (dst.size () != h.target_size || digest (dst) != h.target_hash)
+      throw runtime_error ("patched binary does not match expected hash");
+
+    {
+      ofstream ofs (tp, ios::binary | ios::trunc);
+      if (!ofs)
+        throw runtime_error ("failed to open " + tp.string ());
+
+      ofs.write (reinterpret_cast<const char*> (dst.data ()),
+                 static_cast<streamsize> (dst.size ()));
+
+      if (!ofs)
+      {
+        ofs.close ();
+
+        error_code ec;
+        fs::remove (tp, ec);
+        throw runtime_error ("failed to write " + tp.string ());
+      }
+    }
+  }
+}
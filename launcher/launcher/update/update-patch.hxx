@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+
+namespace launcher
+{
+  namespace fs = std::filesystem;
+
+  // Launcher binary patch.
+  //
+  // A patch rebuilds one specific launcher binary (the source) into another
+  // (the target). The layout is in the spirit of bsdiff: since most of an
+  // executable only shifts around between builds, the bulk of a patch is
+  // "add these (mostly zero) bytes to that range of the source", which
+  // compresses to almost nothing.
+  //
+  // All integers are little-endian:
+  //
+  // magic    "IW4XPTCH"
+  // version  u32 (1)
+  // reserved u32
+  // source   u64 size, 32-byte BLAKE3
+  // target   u64 size, 32-byte BLAKE3
+  // body     zlib stream of operations, terminated by end:
+  //
+  //   0x00  end
+  //   0x01  copy   u64 offset, u64 length
+  //   0x02  add    u64 offset, u64 length, <length> bytes to add (mod 256)
+  //          to the source bytes at offset
+  //   0x03  insert u64 length, <length> literal bytes
+  //
+  struct update_patch_header
+  {
+    std::uint64_t source_size = 0;
+    std::array<std::uint8_t, 32> source_hash {};
+    std::uint64_t target_size = 0;
+    std::array<std::uint8_t, 32> target_hash {};
+  };
+
+  // Read and check the patch header. Throws if this is not a patch we
+  // understand.
+  //
+  update_patch_header
+  read_update_patch_header (const fs::path& patch);
+
+  // Apply the patch to the source, writing the result to the target.
+  //
+  // Throws if the patch is malformed, was made for a different source, or
+  // if the result does not match the expected size and hash. The target is
+  // removed on failure.
+  //
+  void
+  apply_update_patch (const fs::path& source,
+                      const fs::path& patch,
+                      const fs::path& target);
+}
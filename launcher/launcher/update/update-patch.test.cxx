@@ -0,0 +1,226 @@
+#include <launcher/update/update-patch.hxx>
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miniz.h>
+
+#include <launcher/blake3.h>
+
+using namespace std;
+using namespace launcher;
+
+static void
+put (string& s, uint64_t v, int n)
+{
+  for (int i (0); i != n; ++i)
+    s.push_back (static_cast<char> (v >> (i * 8)));
+}
+
+static string
+digest (const string& d)
+{
+  uint8_t o[BLAKE3_OUT_LEN];
+
+  blake3_hasher h;
+  blake3_hasher_init (&h);
+  blake3_hasher_update (&h, d.data (), d.size ());
+  blake3_hasher_finalize (&h, o, BLAKE3_OUT_LEN);
+
+  return string (reinterpret_cast<const char*> (o), BLAKE3_OUT_LEN);
+}
+
+static string
+patch (const string& src, const string& dst, const string& ops)
+{
+  string r ("IW4XPTCH");
+  put (r, 1, 4);
+  put (r, 0, 4);
+  put (r, src.size (), 8);
+  r += digest (src);
+  put (r, dst.size (), 8);
+  r += digest (dst);
+
+  mz_ulong n (mz_compressBound (static_cast<mz_ulong> (ops.size ())));
+  string b (n, '\0');
+
+  int e (mz_compress (reinterpret_cast<unsigned char*> (&b[0]),
+                      &n,
+                      reinterpret_cast<const unsigned char*> (ops.data ()),
+                      static_cast<mz_ulong> (ops.size ())));
+  assert (e == MZ_OK);
+
+  b.resize (n);
+  return r + b;
+}
+
+static void
+write (const fs::path& p, const string& d)
+{
+  ofstream ofs (p, ios::binary | ios::trunc);
+  ofs.write (d.data (), static_cast<streamsize> (d.size ()));
+  assert (ofs);
+}
+
+static string
+read (const fs::path& p)
+{
+  ifstream ifs (p, ios::binary);
+  return string ((istreambuf_iterator<char> (ifs)),
+                 istreambuf_iterator<char> ());
+}
+
+static bool
+fails (const fs::path& s, const fs::path& p, const fs::path& t)
+{
+  try
+  {
+    apply_update_patch (s, p, t);
+    return false;
+  }
+  catch (const exception&)
+  {
+    return true;
+  }
+}
+
+// The patch we exercise below turns src into dst: copy "The quick brown ",
+// add "fox" -> "cat", copy the middle, insert the new tail.
+//
+static const string src ("The quick brown fox jumps over the lazy dog.");
+static const string dst ("The quick brown cat jumps over the lazy dog!!");
+
+static string
+ops ()
+{
+  string r;
+  r.push_back (0x01); put (r, 0, 8);  put (r, 16, 8);
+  r.push_back (0x02); put (r, 16, 8); put (r, 3, 8);
+  for (size_t i (0); i != 3; ++i)
+    r.push_back (static_cast<char> (dst[16 + i] - src[16 + i]));
+  r.push_back (0x01); put (r, 19, 8); put (r, 24, 8);
+  r.push_back (0x03); put (r, 2, 8);  r += "!!";
+  r.push_back (0x00);
+  return r;
+}
+
+static fs::path
+scratch (const char* n)
+{
+  fs::path d (fs::temp_directory_path () / n);
+  fs::remove_all (d);
+  fs::create_directories (d);
+  return d;
+}
+
+// Header. Only the fixed-size part is read and it carries the sizes of
+// both ends.
+//
+static void
+test_header ()
+{
+  fs::path d (scratch ("iw4x-update-patch-test-header"));
+  fs::path pp (d / "patch");
+
+  write (pp, patch (src, dst, ops ()));
+
+  update_patch_header h (read_update_patch_header (pp));
+  assert (h.source_size == src.size ());
+  assert (h.target_size == dst.size ());
+
+  fs::remove_all (d);
+}
+
+// Round trip. Applying the patch to its source yields the target.
+//
+static void
+test_apply ()
+{
+  fs::path d (scratch ("iw4x-update-patch-test-apply"));
+  fs::path sp (d / "source");
+  fs::path pp (d / "patch");
+  fs::path tp (d / "target");
+
+  write (sp, src);
+  write (pp, patch (src, dst, ops ()));
+
+  apply_update_patch (sp, pp, tp);
+  assert (read (tp) == dst);
+
+  fs::remove_all (d);
+}
+
+// Wrong source. The source digest doesn't match so we refuse to apply and
+// leave no target behind.
+//
+static void
+test_source ()
+{
+  fs::path d (scratch ("iw4x-update-patch-test-source"));
+  fs::path sp (d / "source");
+  fs::path pp (d / "patch");
+  fs::path tp (d / "target");
+
+  write (sp, src + " ");
+  write (pp, patch (src, dst, ops ()));
+
+  assert (fails (sp, pp, tp));
+  assert (!fs::exists (tp));
+
+  fs::remove_all (d);
+}
+
+// Bad patches. An operation that reaches past the end of the source,
+// well-formed operations that produce the wrong result, and something that
+// is not a patch at all are all errors.
+//
+static void
+test_invalid ()
+{
+  fs::path d (scratch ("iw4x-update-patch-test-invalid"));
+  fs::path sp (d / "source");
+  fs::path pp (d / "patch");
+  fs::path tp (d / "target");
+
+  write (sp, src);
+
+  {
+    string o;
+    o.push_back (0x01); put (o, 40, 8); put (o, 10, 8);
+    o.push_back (0x00);
+
+    write (pp, patch (src, dst, o));
+    assert (fails (sp, pp, tp));
+  }
+
+  {
+    string o;
+    o.push_back (0x03); put (o, dst.size (), 8); o += string (dst.size (), 'x');
+    o.push_back (0x00);
+
+    write (pp, patch (src, dst, o));
+    assert (fails (sp, pp, tp));
+  }
+
+  {
+    write (pp, "definitely not a patch, but long enough to have a header of "
+               "the expected size so that only the magic is wrong here....");
+    assert (fails (sp, pp, tp));
+  }
+
+  fs::remove_all (d);
+}
+
+int
+main ()
+{
+  test_header ();
+  test_apply ();
+  test_source ();
+  test_invalid ();
+}
@@ -6,6 +6,7 @@
 #include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace launcher
 {
@@ -243,6 +244,22 @@ namespace launcher
   platform_type
   current_platform () noexcept;
 
+  // Binary patch asset.
+  //
+  // Turns the launcher binary of version `from` into that of version `to`.
+  // Published alongside the full archives and named:
+  //
+  // launcher-<from>_<to>-<platform>.patch
+  //
+  struct update_patch
+  {
+    launcher_version from;
+    launcher_version to;
+    std::string url;
+    std::string name;
+    std::uint64_t size = 0;
+  };
+
   // Update information from a GitHub release.
   //
   struct update_info
@@ -256,11 +273,27 @@ namespace launcher
     bool prerelease = false;
     std::string body;  // release notes (markdown)
 
+    // Patches for the current platform that lead to this version.
+    //
+    std::vector<update_patch> patches;
+
     bool
     empty () const noexcept
     {
       return version.empty ();
     }
+
+    // Find the patch from the specified version to this one, if any.
+    //
+    const update_patch*
+    find_patch (const launcher_version& from) const noexcept
+    {
+      for (const auto& p : patches)
+        if (p.from == from && p.to == version)
+          return &p;
+
+      return nullptr;
+    }
   };
 
   // Update progress callback.